@@ -0,0 +1,42 @@
+#!/bin/sh
+# Сравнение интерпретатора и AOT-компиляции (--emit-cpp) на скриптах из bench/.
+# Порождённый C++ и библиотека времени выполнения собираются с -O2.
+#   bench/aot.sh [каталог сборки]   (по умолчанию build)
+set -e
+here=$(cd "$(dirname "$0")" && pwd)
+src="$here/../src"
+build=${1:-build}
+interpreter="$build/interpreter"
+cxx=${CXX:-c++}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+for unit in ast environment runtime symbol array; do
+    $cxx -std=c++17 -O2 -I "$src" -c "$src/$unit.cpp" -o "$work/$unit.o"
+done
+
+# Время выполнения команды в миллисекундах; вывод сохраняется в $work/out
+elapsed() {
+    start=$(date +%s%N)
+    "$@" > "$work/out" 2>&1
+    end=$(date +%s%N)
+    echo $(( (end - start) / 1000000 ))
+}
+
+printf '%-10s %16s %10s %9s\n' script interpreter_ms aot_ms speedup
+for script in "$here"/*.txt; do
+    name=$(basename "$script" .txt)
+    "$interpreter" --emit-cpp="$work/$name.cpp" "$script"
+    $cxx -std=c++17 -O2 -I "$src" "$work/$name.cpp" "$work"/*.o -pthread -o "$work/$name"
+
+    interpreted=$(elapsed "$interpreter" "$script")
+    cp "$work/out" "$work/expected"
+    compiled=$(elapsed "$work/$name")
+    if ! cmp -s "$work/out" "$work/expected"; then
+        echo "$name: AOT output differs from the interpreter" >&2
+        exit 1
+    fi
+
+    speedup=$(awk "BEGIN { printf \"%.1f\", $interpreted / ($compiled > 0 ? $compiled : 1) }")
+    printf '%-10s %16s %10s %8sx\n' "$name" "$interpreted" "$compiled" "$speedup"
+done
@@ -0,0 +1,397 @@
+#include "interpreter.h"
+#include "lexer.h"
+#include "parser.h"
+#include "script.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Набор бенчмарков интерпретатора (цель bench в CMakeLists.txt).
+// Микробенчмарки меряют отдельные части: лексер и парсер — на корпусе из
+// скриптов набора, поиск переменных, вызовы, свойства, склейку строк и
+// индексацию — скриптами bench/suite/micro. Макробенчмарки — целые программы
+// из bench/suite/macro. Скрипт разбирается один раз и выполняется в
+// сброшенном интерпретаторе, как в --repeat: меряется только выполнение.
+//
+// Каждый бенчмарк сначала прогревается (кэши, специализация узлов, JIT),
+// затем число итераций на замер подбирается так, чтобы замер длился не
+// меньше --min-time, и замеры повторяются. Итог — медиана, минимум, среднее
+// и стандартное отклонение времени одной итерации; с --json — файл для
+// сравнения запусков на разных коммитах (--baseline).
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Пороги JIT и трассировки — как у интерпретатора по умолчанию
+const size_t JIT_THRESHOLD = 10;
+const size_t TRACE_THRESHOLD = 50;
+// Корпус лексера и парсера — скрипты набора, повторённые столько раз
+const size_t CORPUS_COPIES = 20;
+
+struct Options {
+    std::string suite = BENCH_SUITE_DIR;
+    std::string filter;
+    size_t warmup = 3;
+    size_t repetitions = 10;
+    double minTime = 20; // мс на замер
+    bool jit = false;
+    bool traceJit = false;
+    bool list = false;
+    std::string json;
+    std::string baseline;
+    std::string label;
+};
+
+struct Benchmark {
+    std::string name; // micro/lex, macro/fib, ...
+    std::string kind; // micro или macro
+    // Одна итерация; возвращает вывод, по которому сверяются запуски
+    std::function<std::string()> run;
+};
+
+struct Result {
+    std::string name;
+    std::string kind;
+    std::string check;
+    size_t iterations = 0;
+    std::vector<double> samples; // нс на итерацию
+    double min = 0;
+    double median = 0;
+    double mean = 0;
+    double stddev = 0;
+};
+
+std::string readFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+std::vector<std::filesystem::path> suiteScripts(const std::string& directory) {
+    std::vector<std::filesystem::path> scripts;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() == ".txt") {
+            scripts.push_back(entry.path());
+        }
+    }
+    std::sort(scripts.begin(), scripts.end());
+    return scripts;
+}
+
+// Скрипт разбирается один раз; интерпретатор и его кэши живут между итерациями
+Benchmark scriptBenchmark(const std::string& kind, const std::filesystem::path& path, const Options& options) {
+    std::string name = kind + "/" + path.stem().string();
+    auto script = std::make_shared<Script>(readFile(path.string()));
+    auto interpreter = std::make_shared<Interpreter>();
+    if (options.jit) {
+        interpreter->enableJit(JIT_THRESHOLD);
+    }
+    if (options.traceJit) {
+        interpreter->enableTracing(TRACE_THRESHOLD);
+    }
+    auto output = std::make_shared<std::ostringstream>();
+    auto errors = std::make_shared<std::ostringstream>();
+    interpreter->setOutput(*output, *errors);
+    return {name, kind, [name, script, interpreter, output, errors] {
+        output->str("");
+        interpreter->reset();
+        script->run(*interpreter);
+        if (!errors->str().empty()) {
+            throw std::runtime_error(name + ": " + errors->str());
+        }
+        return output->str();
+    }};
+}
+
+std::vector<Benchmark> makeBenchmarks(const Options& options) {
+    std::string micro = options.suite + "/micro";
+    std::string macro = options.suite + "/macro";
+
+    std::string corpus;
+    for (const std::string& directory : {micro, macro}) {
+        for (const auto& path : suiteScripts(directory)) {
+            corpus += readFile(path.string()) + "\n";
+        }
+    }
+    std::string copies;
+    for (size_t i = 0; i < CORPUS_COPIES; i++) {
+        copies += corpus;
+    }
+    auto source = std::make_shared<const std::string>(std::move(copies));
+
+    std::vector<Benchmark> benchmarks;
+    benchmarks.push_back({"micro/lex", "micro", [source] {
+        Lexer lexer(*source);
+        size_t tokens = 0;
+        while (lexer.getNextToken().type != TokenType::END_OF_FILE) {
+            tokens++;
+        }
+        return std::to_string(tokens) + " tokens";
+    }});
+    benchmarks.push_back({"micro/parse", "micro", [source] {
+        Lexer lexer(*source);
+        Parser parser(lexer);
+        auto program = parser.parse();
+        return std::to_string(program->statements.size()) + " statements";
+    }});
+    for (const auto& path : suiteScripts(micro)) {
+        benchmarks.push_back(scriptBenchmark("micro", path, options));
+    }
+    for (const auto& path : suiteScripts(macro)) {
+        benchmarks.push_back(scriptBenchmark("macro", path, options));
+    }
+    return benchmarks;
+}
+
+double nanosecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+Result measure(const Benchmark& benchmark, const Options& options) {
+    Result result;
+    result.name = benchmark.name;
+    result.kind = benchmark.kind;
+    for (size_t i = 0; i < options.warmup; i++) {
+        result.check = benchmark.run();
+    }
+
+    // Калибровка: столько итераций, чтобы замер длился не меньше minTime
+    Clock::time_point start = Clock::now();
+    std::string check = benchmark.run();
+    double once = std::max(nanosecondsSince(start), 1.0);
+    if (options.warmup > 0 && check != result.check) {
+        throw std::runtime_error(benchmark.name + ": output differs between runs");
+    }
+    result.check = check;
+    result.iterations = std::max<size_t>(1, static_cast<size_t>(std::ceil(options.minTime * 1e6 / once)));
+
+    for (size_t r = 0; r < options.repetitions; r++) {
+        start = Clock::now();
+        for (size_t i = 0; i < result.iterations; i++) {
+            benchmark.run();
+        }
+        result.samples.push_back(nanosecondsSince(start) / static_cast<double>(result.iterations));
+    }
+
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    result.min = sorted.front();
+    result.median = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    double sum = 0;
+    for (double sample : sorted) sum += sample;
+    result.mean = sum / static_cast<double>(n);
+    double squares = 0;
+    for (double sample : sorted) squares += (sample - result.mean) * (sample - result.mean);
+    result.stddev = n > 1 ? std::sqrt(squares / static_cast<double>(n - 1)) : 0;
+    return result;
+}
+
+std::string formatTime(double nanoseconds) {
+    char buffer[32];
+    if (nanoseconds >= 1e6) {
+        std::snprintf(buffer, sizeof(buffer), "%.3f ms", nanoseconds / 1e6);
+    } else if (nanoseconds >= 1e3) {
+        std::snprintf(buffer, sizeof(buffer), "%.3f us", nanoseconds / 1e3);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.1f ns", nanoseconds);
+    }
+    return buffer;
+}
+
+std::string jsonString(const std::string& text) {
+    std::string result = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    result += escaped;
+                } else {
+                    result += c;
+                }
+        }
+    }
+    return result + "\"";
+}
+
+std::string timestamp() {
+    std::time_t now = std::time(nullptr);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return buffer;
+}
+
+void writeJson(const std::string& filename, const std::vector<Result>& results, const Options& options) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not write file: " + filename);
+    }
+    file.precision(10);
+    file << "{\n";
+    file << "  \"label\": " << jsonString(options.label) << ",\n";
+    file << "  \"timestamp\": " << jsonString(timestamp()) << ",\n";
+    file << "  \"compiler\": " << jsonString(__VERSION__) << ",\n";
+#ifdef NDEBUG
+    file << "  \"build\": \"Release\",\n";
+#else
+    file << "  \"build\": \"Debug\",\n";
+#endif
+    file << "  \"config\": {\"jit\": " << (options.jit ? "true" : "false")
+         << ", \"trace_jit\": " << (options.traceJit ? "true" : "false")
+         << ", \"warmup\": " << options.warmup << ", \"repetitions\": " << options.repetitions
+         << ", \"min_time_ms\": " << options.minTime << "},\n";
+    file << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        file << "    {\"name\": " << jsonString(result.name) << ", \"kind\": " << jsonString(result.kind)
+             << ", \"iterations\": " << result.iterations << ", \"median_ns\": " << result.median
+             << ", \"min_ns\": " << result.min << ", \"mean_ns\": " << result.mean
+             << ", \"stddev_ns\": " << result.stddev << ", \"samples_ns\": [";
+        for (size_t s = 0; s < result.samples.size(); s++) {
+            file << (s > 0 ? ", " : "") << result.samples[s];
+        }
+        file << "], \"check\": " << jsonString(result.check) << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+}
+
+// Медианы из JSON прошлого запуска: за каждым "name" ищется его "median_ns"
+std::map<std::string, double> readBaseline(const std::string& filename) {
+    std::string text = readFile(filename);
+    std::map<std::string, double> medians;
+    const std::string nameKey = "\"name\": \"";
+    const std::string medianKey = "\"median_ns\": ";
+    size_t position = 0;
+    while ((position = text.find(nameKey, position)) != std::string::npos) {
+        position += nameKey.size();
+        size_t nameEnd = text.find('"', position);
+        size_t median = text.find(medianKey, nameEnd);
+        if (nameEnd == std::string::npos || median == std::string::npos) break;
+        medians[text.substr(position, nameEnd - position)] = std::stod(text.substr(median + medianKey.size()));
+        position = nameEnd;
+    }
+    return medians;
+}
+
+bool parseSize(const std::string& text, size_t& value) {
+    try {
+        value = std::stoul(text);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--suite=", 0) == 0) {
+            options.suite = arg.substr(8);
+        } else if (arg.rfind("--filter=", 0) == 0) {
+            options.filter = arg.substr(9);
+        } else if (arg.rfind("--warmup=", 0) == 0) {
+            if (!parseSize(arg.substr(9), options.warmup)) return false;
+        } else if (arg.rfind("--repetitions=", 0) == 0) {
+            if (!parseSize(arg.substr(14), options.repetitions) || options.repetitions == 0) return false;
+        } else if (arg.rfind("--min-time=", 0) == 0) {
+            try {
+                options.minTime = std::stod(arg.substr(11));
+            } catch (const std::exception&) {
+                return false;
+            }
+        } else if (arg == "--jit") {
+            options.jit = true;
+        } else if (arg == "--trace-jit") {
+            options.traceJit = true;
+        } else if (arg == "--list") {
+            options.list = true;
+        } else if (arg.rfind("--json=", 0) == 0) {
+            options.json = arg.substr(7);
+        } else if (arg.rfind("--baseline=", 0) == 0) {
+            options.baseline = arg.substr(11);
+        } else if (arg.rfind("--label=", 0) == 0) {
+            options.label = arg.substr(8);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cout << "Usage: " << argv[0] << " [--filter=TEXT] [--warmup=N] [--repetitions=N] [--min-time=MS] [--jit] [--trace-jit] [--json=FILE] [--baseline=FILE] [--label=TEXT] [--suite=DIR] [--list]" << std::endl;
+        return 1;
+    }
+
+    try {
+        std::vector<Benchmark> benchmarks = makeBenchmarks(options);
+        if (options.list) {
+            for (const Benchmark& benchmark : benchmarks) {
+                std::cout << benchmark.name << std::endl;
+            }
+            return 0;
+        }
+        std::map<std::string, double> baseline;
+        if (!options.baseline.empty()) {
+            baseline = readBaseline(options.baseline);
+        }
+#ifndef NDEBUG
+        std::cerr << "Warning: benchmarks built without NDEBUG; use the bench target for a Release build" << std::endl;
+#endif
+
+        std::printf("%-18s %8s %12s %12s %8s", "benchmark", "iters", "median", "min", "stddev");
+        if (!baseline.empty()) std::printf(" %10s", "vs base");
+        std::printf("\n");
+        std::vector<Result> results;
+        for (const Benchmark& benchmark : benchmarks) {
+            if (benchmark.name.find(options.filter) == std::string::npos) continue;
+            Result result = measure(benchmark, options);
+            std::printf("%-18s %8zu %12s %12s %7.1f%%", result.name.c_str(), result.iterations,
+                        formatTime(result.median).c_str(), formatTime(result.min).c_str(),
+                        result.mean > 0 ? 100 * result.stddev / result.mean : 0);
+            auto base = baseline.find(result.name);
+            if (base != baseline.end() && base->second > 0) {
+                std::printf(" %+9.1f%%", 100 * (result.median / base->second - 1));
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+            results.push_back(std::move(result));
+        }
+
+        if (!options.json.empty()) {
+            writeJson(options.json, results, options);
+            std::cout << "Results: " << options.json << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#!/bin/sh
+# Время работы интерпретатора на скриптах из bench/ (лучшее из нескольких запусков).
+#   bench/run.sh [каталог сборки] [флаги интерпретатора...]
+#   RUNS=5 bench/run.sh build --jit
+set -e
+here=$(cd "$(dirname "$0")" && pwd)
+build=${1:-build}
+[ $# -gt 0 ] && shift
+interpreter="$build/interpreter"
+runs=${RUNS:-3}
+
+printf '%-12s %8s\n' script best_ms
+for script in "$here"/*.txt; do
+    best=
+    i=0
+    while [ $i -lt "$runs" ]; do
+        start=$(date +%s%N)
+        "$interpreter" "$@" "$script" > /dev/null 2>&1
+        end=$(date +%s%N)
+        ms=$(( (end - start) / 1000000 ))
+        if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then best=$ms; fi
+        i=$((i + 1))
+    done
+    printf '%-12s %8s\n' "$(basename "$script" .txt)" "$best"
+done
@@ -0,0 +1,47 @@
+#!/bin/sh
+# Запрос к службе (--serve) против нового процесса на каждый запуск.
+# Скрипт использует прелюдию из FUNCS функций, восстановленную из снимка:
+# процесс каждый раз стартует и разворачивает снимок, служба делает это
+# один раз на работника.
+#   bench/serve.sh [каталог сборки]   (по умолчанию build)
+#   FUNCS=500 REQUESTS=200 CONNECTIONS=4 THREADS=4 bench/serve.sh build
+set -e
+build=${1:-build}
+interpreter="$build/interpreter"
+funcs=${FUNCS:-500}
+requests=${REQUESTS:-200}
+connections=${CONNECTIONS:-4}
+threads=${THREADS:-4}
+work=$(mktemp -d)
+trap 'kill $server 2>/dev/null; rm -rf "$work"' EXIT
+
+i=0
+while [ $i -lt "$funcs" ]; do
+    echo "fun helper$i(x) { let y = x + $i; if (y > 100) { return y - 100; } return y * 2; }"
+    i=$((i + 1))
+done > "$work/prelude.txt"
+echo 'let total = 0; let i = 0; while (i < 100) { total = total + helper7(i); i = i + 1; } print total;' > "$work/main.txt"
+"$interpreter" --snapshot-out="$work/prelude.snapshot" "$work/prelude.txt"
+
+start=$(date +%s%N)
+n=0
+while [ $n -lt "$requests" ]; do
+    "$interpreter" --snapshot="$work/prelude.snapshot" "$work/main.txt" > "$work/expected"
+    n=$((n + 1))
+done
+end=$(date +%s%N)
+process_us=$(( (end - start) / 1000 / requests ))
+
+"$interpreter" --serve "$work/serve.sock" --threads="$threads" --snapshot="$work/prelude.snapshot" &
+server=$!
+"$interpreter" --client "$work/serve.sock" --repeat="$requests" --connections="$connections" \
+    "$work/main.txt" > "$work/out" 2> "$work/load"
+"$interpreter" --client "$work/serve.sock" --shutdown
+wait $server
+if ! cmp -s "$work/out" "$work/expected"; then
+    echo "output through --serve differs" >&2
+    exit 1
+fi
+
+printf 'process per request: %s us/request, %s requests/s\n' "$process_us" $((1000000 / process_us))
+printf 'serve:               %s\n' "$(cat "$work/load")"
\ No newline at end of file
@@ -0,0 +1,64 @@
+#!/bin/sh
+# Холодный старт с большой прелюдией: прелюдия и скрипт подряд против
+# скрипта со снимком прелюдии (--snapshot). Прелюдия порождается: FUNCS
+# функций и таблица из ROWS объектов.
+#   bench/snapshot.sh [каталог сборки]   (по умолчанию build)
+#   FUNCS=500 ROWS=2000 RUNS=10 bench/snapshot.sh build
+set -e
+build=${1:-build}
+interpreter="$build/interpreter"
+funcs=${FUNCS:-500}
+rows=${ROWS:-2000}
+runs=${RUNS:-10}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+i=0
+while [ $i -lt "$funcs" ]; do
+    echo "fun helper$i(x) { let y = x + $i; if (y > 100) { return y - 100; } return y * 2; }"
+    i=$((i + 1))
+done > "$work/prelude.txt"
+{
+    echo "let table = ["
+    i=0
+    while [ $i -lt "$rows" ]; do
+        echo "    {\"id\": $i, \"name\": \"row $i\", \"weight\": $i.5, \"tags\": [\"a\", \"b\", $i]},"
+        i=$((i + 1))
+    done
+    echo "    {\"id\": -1, \"name\": \"end\", \"weight\": 0, \"tags\": []}"
+    echo "];"
+} >> "$work/prelude.txt"
+echo 'print helper7(table[42].id) + table.length;' > "$work/main.txt"
+echo 'print 1;' > "$work/empty.txt"
+cat "$work/prelude.txt" "$work/main.txt" > "$work/full.txt"
+"$interpreter" --snapshot-out="$work/prelude.snapshot" "$work/prelude.txt"
+
+# Лучшее из runs время команды в миллисекундах; вывод — в $work/out
+best() {
+    result=
+    n=0
+    while [ $n -lt "$runs" ]; do
+        start=$(date +%s%N)
+        "$@" > "$work/out" 2>&1
+        end=$(date +%s%N)
+        us=$(( (end - start) / 1000 ))
+        if [ -z "$result" ] || [ "$us" -lt "$result" ]; then result=$us; fi
+        n=$((n + 1))
+    done
+    echo "$result"
+}
+
+empty=$(best "$interpreter" "$work/empty.txt")
+cold=$(best "$interpreter" "$work/full.txt")
+cp "$work/out" "$work/expected"
+warm=$(best "$interpreter" --snapshot="$work/prelude.snapshot" "$work/main.txt")
+if ! cmp -s "$work/out" "$work/expected"; then
+    echo "output with snapshot differs" >&2
+    exit 1
+fi
+bytes=$(wc -c < "$work/prelude.snapshot")
+printf 'prelude: %s functions, %s rows, snapshot %s bytes\n' "$funcs" "$rows" "$bytes"
+printf '%-16s %10s\n' start best_us
+printf '%-16s %10s\n' empty "$empty"
+printf '%-16s %10s\n' prelude "$cold"
+printf '%-16s %10s\n' snapshot "$warm"
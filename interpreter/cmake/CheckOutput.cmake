@@ -0,0 +1,18 @@
+# Запускает скрипт с флагами FLAGS и сравнивает вывод с файлом EXPECTED.
+# Нужен там, где все режимы могут ошибиться одинаково и сравнение режимов ничего не покажет.
+#   cmake -DINTERPRETER=... -DSCRIPT=... -DEXPECTED=... "-DFLAGS=--memoize" -P CheckOutput.cmake
+
+file(READ ${EXPECTED} expected_out)
+
+separate_arguments(flags UNIX_COMMAND "${FLAGS}")
+execute_process(COMMAND ${INTERPRETER} ${flags} ${SCRIPT}
+                OUTPUT_VARIABLE actual_out
+                ERROR_VARIABLE actual_err)
+
+string(STRIP "${expected_out}" expected_out)
+string(STRIP "${actual_out}" actual_out)
+if(NOT expected_out STREQUAL actual_out OR NOT actual_err STREQUAL "")
+    message(FATAL_ERROR "Output of '${SCRIPT}' with ${FLAGS} is wrong:\n"
+                        "--- expected\n${expected_out}\n"
+                        "--- actual\n${actual_out}\n${actual_err}")
+endif()
\ No newline at end of file
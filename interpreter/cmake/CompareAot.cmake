@@ -0,0 +1,39 @@
+# Транслирует скрипт в C++ (--emit-cpp), собирает его с библиотекой времени
+# выполнения и сравнивает вывод с обычным интерпретатором. Диагностика разбора
+# печатается при трансляции, поэтому учитывается вместе с выводом программы.
+#   cmake -DINTERPRETER=... -DSCRIPT=... -DCXX=... -DINCLUDE_DIR=... -DRUNTIME=... -DWORK_DIR=... -P CompareAot.cmake
+
+get_filename_component(name ${SCRIPT} NAME_WE)
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(source ${WORK_DIR}/${name}.cpp)
+set(binary ${WORK_DIR}/${name})
+
+execute_process(COMMAND ${INTERPRETER} ${SCRIPT}
+                OUTPUT_VARIABLE expected_out
+                ERROR_VARIABLE expected_err)
+
+execute_process(COMMAND ${INTERPRETER} --emit-cpp=${source} ${SCRIPT}
+                OUTPUT_VARIABLE emit_out
+                ERROR_VARIABLE emit_err
+                RESULT_VARIABLE emit_result)
+if(NOT emit_result EQUAL 0)
+    message(FATAL_ERROR "--emit-cpp failed for '${SCRIPT}':\n${emit_out}${emit_err}")
+endif()
+
+execute_process(COMMAND ${CXX} -std=c++17 -O1 -I ${INCLUDE_DIR} ${source} ${RUNTIME} -pthread -o ${binary}
+                OUTPUT_VARIABLE compile_out
+                ERROR_VARIABLE compile_err
+                RESULT_VARIABLE compile_result)
+if(NOT compile_result EQUAL 0)
+    message(FATAL_ERROR "Generated C++ for '${SCRIPT}' does not compile:\n${compile_out}${compile_err}")
+endif()
+
+execute_process(COMMAND ${binary}
+                OUTPUT_VARIABLE actual_out
+                ERROR_VARIABLE actual_err)
+
+if(NOT expected_out STREQUAL "${emit_out}${actual_out}" OR NOT expected_err STREQUAL "${emit_err}${actual_err}")
+    message(FATAL_ERROR "AOT output of '${SCRIPT}' differs:\n"
+                        "--- expected\n${expected_out}${expected_err}\n"
+                        "--- actual\n${emit_out}${actual_out}${emit_err}${actual_err}")
+endif()
\ No newline at end of file
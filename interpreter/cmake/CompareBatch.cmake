@@ -0,0 +1,51 @@
+# Запускает манифест --batch и сравнивает вывод с отдельными запусками
+# каждого скрипта. Ввод строки манифеста подставляется в копию скрипта
+# присваиванием input в первой строке; priority=N пропускается.
+#   cmake -DINTERPRETER=... -DMANIFEST=... "-DFLAGS=--threads=2" -DWORK_DIR=... -P CompareBatch.cmake
+
+get_filename_component(manifest_dir ${MANIFEST} DIRECTORY)
+file(STRINGS ${MANIFEST} lines ENCODING UTF-8)
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+set(expected_out "")
+set(expected_err "")
+set(index 0)
+foreach(line ${lines})
+    string(STRIP "${line}" line)
+    if(line STREQUAL "" OR line MATCHES "^#")
+        continue()
+    endif()
+    string(REGEX MATCH "^([^ \t]+)[ \t]*(.*)$" matched "${line}")
+    set(path "${CMAKE_MATCH_1}")
+    set(input "${CMAKE_MATCH_2}")
+    # priority=N влияет только на очерёдность, не на вывод
+    string(REGEX REPLACE "^priority=[0-9]+[ \t]*" "" input "${input}")
+    set(script ${manifest_dir}/${path})
+    if(NOT input STREQUAL "")
+        if(NOT input MATCHES "^-?[0-9.]+$")
+            set(input "\"${input}\"")
+        endif()
+        file(READ ${script} source)
+        math(EXPR index "${index} + 1")
+        set(script ${WORK_DIR}/input_${index}.txt)
+        file(WRITE ${script} "let input = ${input};\n${source}")
+    endif()
+    execute_process(COMMAND ${INTERPRETER} ${script}
+                    OUTPUT_VARIABLE out
+                    ERROR_VARIABLE err)
+    string(APPEND expected_out "${out}")
+    string(APPEND expected_err "${err}")
+endforeach()
+
+separate_arguments(flags UNIX_COMMAND "${FLAGS}")
+execute_process(COMMAND ${INTERPRETER} ${flags} --batch ${MANIFEST}
+                OUTPUT_VARIABLE actual_out
+                ERROR_VARIABLE actual_err)
+# Последняя строка — сводка Batch: ..., её значения от запуска к запуску разные
+string(REGEX REPLACE "Batch: [^\n]*\n$" "" actual_err "${actual_err}")
+
+if(NOT expected_out STREQUAL actual_out OR NOT expected_err STREQUAL actual_err)
+    message(FATAL_ERROR "Output of batch '${MANIFEST}' differs:\n"
+                        "--- expected\n${expected_out}${expected_err}\n"
+                        "--- actual\n${actual_out}${actual_err}")
+endif()
\ No newline at end of file
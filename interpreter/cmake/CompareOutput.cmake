@@ -0,0 +1,18 @@
+# Запускает скрипт без флагов и с флагами FLAGS и сравнивает вывод.
+# Используется для проверки оптимизирующих режимов против обычного интерпретатора.
+#   cmake -DINTERPRETER=... -DSCRIPT=... "-DFLAGS=--jit" -P CompareOutput.cmake
+
+execute_process(COMMAND ${INTERPRETER} ${SCRIPT}
+                OUTPUT_VARIABLE expected_out
+                ERROR_VARIABLE expected_err)
+
+separate_arguments(flags UNIX_COMMAND "${FLAGS}")
+execute_process(COMMAND ${INTERPRETER} ${flags} ${SCRIPT}
+                OUTPUT_VARIABLE actual_out
+                ERROR_VARIABLE actual_err)
+
+if(NOT expected_out STREQUAL actual_out OR NOT expected_err STREQUAL actual_err)
+    message(FATAL_ERROR "Output of '${SCRIPT}' differs with ${FLAGS}:\n"
+                        "--- expected\n${expected_out}${expected_err}\n"
+                        "--- actual\n${actual_out}${actual_err}")
+endif()
@@ -0,0 +1,30 @@
+# Служба: манифест, выполненный через --serve нагрузочным клиентом
+# (несколько проходов и соединений), выводит то же, что --batch.
+#   cmake -DINTERPRETER=... -DMANIFEST=... "-DFLAGS=--threads=2" "-DCLIENT_FLAGS=--repeat=3" -DWORK_DIR=... -P CompareServe.cmake
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+execute_process(COMMAND ${INTERPRETER} --batch ${MANIFEST}
+                OUTPUT_VARIABLE expected_out
+                ERROR_VARIABLE expected_err)
+string(REGEX REPLACE "Batch: [^\n]*\n$" "" expected_err "${expected_err}")
+
+# Служба и клиент запускаются вместе; клиент ждёт сокета и в конце
+# останавливает службу запросом shutdown
+separate_arguments(flags UNIX_COMMAND "${FLAGS}")
+separate_arguments(client_flags UNIX_COMMAND "${CLIENT_FLAGS}")
+set(socket ${WORK_DIR}/serve.sock)
+file(REMOVE ${socket})
+execute_process(COMMAND ${INTERPRETER} ${flags} --serve ${socket}
+                COMMAND ${INTERPRETER} --client ${socket} --batch ${MANIFEST} ${client_flags} --shutdown
+                OUTPUT_VARIABLE actual_out
+                ERROR_VARIABLE actual_err
+                RESULTS_VARIABLE results
+                TIMEOUT 120)
+# Последняя строка — сводка Load: ..., её значения от запуска к запуску разные
+string(REGEX REPLACE "Load: [^\n]*\n$" "" actual_err "${actual_err}")
+
+if(NOT results STREQUAL "0;0" OR NOT expected_out STREQUAL actual_out OR NOT expected_err STREQUAL actual_err)
+    message(FATAL_ERROR "Output of '${MANIFEST}' through --serve differs (exit codes ${results}):\n"
+                        "--- expected\n${expected_out}${expected_err}\n"
+                        "--- actual\n${actual_out}${actual_err}")
+endif()
\ No newline at end of file
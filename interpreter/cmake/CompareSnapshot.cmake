@@ -0,0 +1,28 @@
+# Снимок прелюдии: MAIN со снимком PRELUDE должен вывести то же, что
+# PRELUDE и MAIN, выполненные подряд одной программой.
+#   cmake -DINTERPRETER=... -DPRELUDE=... -DMAIN=... "-DFLAGS=--jit" -DWORK_DIR=... -P CompareSnapshot.cmake
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+file(READ ${PRELUDE} prelude)
+file(READ ${MAIN} main)
+file(WRITE ${WORK_DIR}/combined.txt "${prelude}\n${main}")
+execute_process(COMMAND ${INTERPRETER} ${WORK_DIR}/combined.txt
+                OUTPUT_VARIABLE expected_out
+                ERROR_VARIABLE expected_err)
+
+separate_arguments(flags UNIX_COMMAND "${FLAGS}")
+execute_process(COMMAND ${INTERPRETER} --snapshot-out=${WORK_DIR}/prelude.snapshot ${PRELUDE}
+                RESULT_VARIABLE result
+                ERROR_VARIABLE write_err)
+if(NOT result EQUAL 0 OR NOT write_err STREQUAL "")
+    message(FATAL_ERROR "Could not write snapshot of '${PRELUDE}':\n${write_err}")
+endif()
+execute_process(COMMAND ${INTERPRETER} ${flags} --snapshot=${WORK_DIR}/prelude.snapshot ${MAIN}
+                OUTPUT_VARIABLE actual_out
+                ERROR_VARIABLE actual_err)
+
+if(NOT expected_out STREQUAL actual_out OR NOT expected_err STREQUAL actual_err)
+    message(FATAL_ERROR "Output of '${MAIN}' with snapshot of '${PRELUDE}' differs:\n"
+                        "--- expected\n${expected_out}${expected_err}\n"
+                        "--- actual\n${actual_out}${actual_err}")
+endif()
\ No newline at end of file
@@ -0,0 +1,551 @@
+#include "array.h"
+#include "runtime.h"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// SSE2 входит в любой x86-64; AVX включается для отдельных функций
+// (target) и выбирается во время выполнения
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define ARRAY_SSE2 1
+#else
+#define ARRAY_SSE2 0
+#endif
+#if ARRAY_SSE2 && (defined(__GNUC__) || defined(__clang__))
+#define ARRAY_AVX 1
+#define ARRAY_TARGET_AVX __attribute__((target("avx")))
+#else
+#define ARRAY_AVX 0
+#endif
+
+ArrayStorage::ArrayStorage(std::vector<double> numbers) : doubles(std::move(numbers)) {}
+
+void ArrayStorage::reserve(size_t capacity) {
+    if (elementsKind == PACKED_DOUBLE) {
+        doubles.reserve(capacity);
+    } else {
+        values.reserve(capacity);
+    }
+}
+
+Value ArrayStorage::get(size_t index) const {
+    if (elementsKind == PACKED_DOUBLE) {
+        return Value(doubles[index]);
+    }
+    return values[index];
+}
+
+void ArrayStorage::set(size_t index, const Value& value) {
+    if (elementsKind == PACKED_DOUBLE) {
+        if (value.type == Value::NUMBER) {
+            doubles[index] = value.numberValue;
+            return;
+        }
+        generalize();
+    }
+    values[index] = value;
+}
+
+void ArrayStorage::push(const Value& value) {
+    if (elementsKind == PACKED_DOUBLE) {
+        if (value.type == Value::NUMBER) {
+            doubles.push_back(value.numberValue);
+            return;
+        }
+        generalize();
+    }
+    values.push_back(value);
+}
+
+void ArrayStorage::push(Value&& value) {
+    if (elementsKind == PACKED_DOUBLE) {
+        if (value.type == Value::NUMBER) {
+            doubles.push_back(value.numberValue);
+            return;
+        }
+        generalize();
+    }
+    values.push_back(std::move(value));
+}
+
+Value ArrayStorage::pop() {
+    if (elementsKind == PACKED_DOUBLE) {
+        double last = doubles.back();
+        doubles.pop_back();
+        return Value(last);
+    }
+    Value last = std::move(values.back());
+    values.pop_back();
+    return last;
+}
+
+ArrayStorage ArrayStorage::slice(size_t from, size_t to) const {
+    ArrayStorage result;
+    if (elementsKind == PACKED_DOUBLE) {
+        result.doubles.assign(doubles.begin() + from, doubles.begin() + to);
+    } else {
+        result.elementsKind = GENERIC;
+        result.values.assign(values.begin() + from, values.begin() + to);
+    }
+    return result;
+}
+
+void ArrayStorage::append(const ArrayStorage& other) {
+    if (elementsKind == PACKED_DOUBLE && other.elementsKind == PACKED_DOUBLE) {
+        doubles.insert(doubles.end(), other.doubles.begin(), other.doubles.end());
+        return;
+    }
+    reserve(size() + other.size());
+    for (size_t i = 0; i < other.size(); i++) {
+        push(other.get(i));
+    }
+}
+
+void ArrayStorage::generalize() {
+    values.reserve(doubles.capacity() + 1);
+    for (double number : doubles) {
+        values.push_back(Value(number));
+    }
+    std::vector<double>().swap(doubles);
+    elementsKind = GENERIC;
+}
+
+namespace {
+
+#if ARRAY_AVX
+bool hasAvx() {
+    static const bool supported = __builtin_cpu_supports("avx");
+    return supported;
+}
+#endif
+
+// Частичные суммы по четырём дорожкам (элемент i идёт в дорожку i % 4)
+// складываются попарно, затем по порядку добавляется хвост
+double finishSum(const double lanes[4], const double* data, size_t from, size_t count) {
+    double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (size_t i = from; i < count; i++) {
+        total += data[i];
+    }
+    return total;
+}
+
+double finishDot(const double lanes[4], const double* left, const double* right, size_t from, size_t count) {
+    double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (size_t i = from; i < count; i++) {
+        total += left[i] * right[i];
+    }
+    return total;
+}
+
+// Сравнение как у minpd/maxpd: при равенстве и NaN остаётся второй операнд
+inline double lesser(double a, double b) { return a < b ? a : b; }
+inline double greater(double a, double b) { return a > b ? a : b; }
+
+#if ARRAY_AVX
+ARRAY_TARGET_AVX double sumAvx(const double* data, size_t count) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm256_add_pd(acc, _mm256_loadu_pd(data + i));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return finishSum(lanes, data, i, count);
+}
+
+ARRAY_TARGET_AVX double dotAvx(const double* left, const double* right, size_t count) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return finishDot(lanes, left, right, i, count);
+}
+
+ARRAY_TARGET_AVX void scaleAvx(const double* data, double factor, double* out, size_t count) {
+    __m256d k = _mm256_set1_pd(factor);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(data + i), k));
+    }
+    for (; i < count; i++) {
+        out[i] = data[i] * factor;
+    }
+}
+
+ARRAY_TARGET_AVX void addAvx(const double* left, const double* right, double* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i)));
+    }
+    for (; i < count; i++) {
+        out[i] = left[i] + right[i];
+    }
+}
+#endif
+
+} // namespace
+
+namespace kernels {
+
+double sum(const double* data, size_t count) {
+#if ARRAY_AVX
+    if (hasAvx()) return sumAvx(data, count);
+#endif
+    double lanes[4];
+    size_t i = 0;
+#if ARRAY_SSE2
+    __m128d low = _mm_setzero_pd();
+    __m128d high = _mm_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        low = _mm_add_pd(low, _mm_loadu_pd(data + i));
+        high = _mm_add_pd(high, _mm_loadu_pd(data + i + 2));
+    }
+    _mm_storeu_pd(lanes, low);
+    _mm_storeu_pd(lanes + 2, high);
+#else
+    lanes[0] = lanes[1] = lanes[2] = lanes[3] = 0;
+    for (; i + 4 <= count; i += 4) {
+        for (size_t lane = 0; lane < 4; lane++) lanes[lane] += data[i + lane];
+    }
+#endif
+    return finishSum(lanes, data, i, count);
+}
+
+double dot(const double* left, const double* right, size_t count) {
+#if ARRAY_AVX
+    if (hasAvx()) return dotAvx(left, right, count);
+#endif
+    double lanes[4];
+    size_t i = 0;
+#if ARRAY_SSE2
+    __m128d low = _mm_setzero_pd();
+    __m128d high = _mm_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        low = _mm_add_pd(low, _mm_mul_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+        high = _mm_add_pd(high, _mm_mul_pd(_mm_loadu_pd(left + i + 2), _mm_loadu_pd(right + i + 2)));
+    }
+    _mm_storeu_pd(lanes, low);
+    _mm_storeu_pd(lanes + 2, high);
+#else
+    lanes[0] = lanes[1] = lanes[2] = lanes[3] = 0;
+    for (; i + 4 <= count; i += 4) {
+        for (size_t lane = 0; lane < 4; lane++) lanes[lane] += left[i + lane] * right[i + lane];
+    }
+#endif
+    return finishDot(lanes, left, right, i, count);
+}
+
+// Минимум и максимум не зависят от порядка, поэтому AVX здесь не нужен:
+// упор в чтение памяти, а не в ширину сравнения
+double min(const double* data, size_t count) {
+    double result = data[0];
+    size_t i = 0;
+#if ARRAY_SSE2
+    if (count >= 4) {
+        __m128d low = _mm_set1_pd(data[0]);
+        __m128d high = low;
+        for (; i + 4 <= count; i += 4) {
+            low = _mm_min_pd(low, _mm_loadu_pd(data + i));
+            high = _mm_min_pd(high, _mm_loadu_pd(data + i + 2));
+        }
+        double lanes[4];
+        _mm_storeu_pd(lanes, low);
+        _mm_storeu_pd(lanes + 2, high);
+        result = lesser(lesser(lanes[0], lanes[1]), lesser(lanes[2], lanes[3]));
+    }
+#endif
+    for (; i < count; i++) {
+        result = lesser(result, data[i]);
+    }
+    return result;
+}
+
+double max(const double* data, size_t count) {
+    double result = data[0];
+    size_t i = 0;
+#if ARRAY_SSE2
+    if (count >= 4) {
+        __m128d low = _mm_set1_pd(data[0]);
+        __m128d high = low;
+        for (; i + 4 <= count; i += 4) {
+            low = _mm_max_pd(low, _mm_loadu_pd(data + i));
+            high = _mm_max_pd(high, _mm_loadu_pd(data + i + 2));
+        }
+        double lanes[4];
+        _mm_storeu_pd(lanes, low);
+        _mm_storeu_pd(lanes + 2, high);
+        result = greater(greater(lanes[0], lanes[1]), greater(lanes[2], lanes[3]));
+    }
+#endif
+    for (; i < count; i++) {
+        result = greater(result, data[i]);
+    }
+    return result;
+}
+
+void scale(const double* data, double factor, double* out, size_t count) {
+#if ARRAY_AVX
+    if (hasAvx()) return scaleAvx(data, factor, out, count);
+#endif
+    size_t i = 0;
+#if ARRAY_SSE2
+    __m128d k = _mm_set1_pd(factor);
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(data + i), k));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = data[i] * factor;
+    }
+}
+
+void add(const double* left, const double* right, double* out, size_t count) {
+#if ARRAY_AVX
+    if (hasAvx()) return addAvx(left, right, out, count);
+#endif
+    size_t i = 0;
+#if ARRAY_SSE2
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = left[i] + right[i];
+    }
+}
+
+} // namespace kernels
+
+namespace {
+
+// Числа аргумента-массива: упакованный отдаётся как есть, общий вид
+// копируется в scratch, если все его элементы — числа
+const std::vector<double>& numbersOf(const Value& value, const char* function, std::vector<double>& scratch) {
+    if (value.type != Value::ARRAY || !value.arrayValue) {
+        throw std::runtime_error(std::string(function) + " expects an array of numbers");
+    }
+    const ArrayStorage& array = *value.arrayValue;
+    if (array.kind() == ArrayStorage::PACKED_DOUBLE) {
+        return array.numbers();
+    }
+    scratch.reserve(array.size());
+    for (const Value& element : array.elements()) {
+        if (element.type != Value::NUMBER) {
+            throw std::runtime_error(std::string(function) + " expects an array of numbers");
+        }
+        scratch.push_back(element.numberValue);
+    }
+    return scratch;
+}
+
+Value makeArray(ArrayStorage storage) {
+    Value result;
+    result.type = Value::ARRAY;
+    result.arrayValue = std::make_shared<ArrayStorage>(std::move(storage));
+    return result;
+}
+
+Value packedArray(std::vector<double> numbers) {
+    return makeArray(ArrayStorage(std::move(numbers)));
+}
+
+struct ArrayMethods {
+    Symbol push = intern("push");
+    Symbol pop = intern("pop");
+    Symbol slice = intern("slice");
+    Symbol indexOf = intern("indexOf");
+    Symbol concat = intern("concat");
+    Symbol map = intern("map");
+    Symbol filter = intern("filter");
+    Symbol reduce = intern("reduce");
+};
+
+const ArrayMethods& arrayMethods() {
+    static const ArrayMethods methods;
+    return methods;
+}
+
+void expectArguments(const char* method, size_t count, size_t least, size_t most) {
+    if (count < least || count > most) {
+        throw std::runtime_error(std::string("Wrong number of arguments for method: ") + method);
+    }
+}
+
+// Граница slice как в JavaScript: отрицательная отсчитывается от конца
+size_t sliceBound(const Value& value, size_t size) {
+    if (value.type != Value::NUMBER) {
+        throw std::runtime_error("slice expects number bounds");
+    }
+    double position = std::trunc(value.numberValue);
+    if (position < 0) position += static_cast<double>(size);
+    if (position < 0) return 0;
+    return position > static_cast<double>(size) ? size : static_cast<size_t>(position);
+}
+
+// Колбэк проверяется один раз, до обхода элементов
+Value callback(const Value& value, const char* method, size_t arity) {
+    if (!value.isCallable() || value.arity() != arity) {
+        throw std::runtime_error(std::string(method) + " expects a function of " + std::to_string(arity) +
+                                 (arity == 1 ? " argument" : " arguments"));
+    }
+    return value;
+}
+
+} // namespace
+
+Value arraySum(const Value* args) {
+    std::vector<double> scratch;
+    const std::vector<double>& numbers = numbersOf(args[0], "sum", scratch);
+    return Value(kernels::sum(numbers.data(), numbers.size()));
+}
+
+Value arrayMin(const Value* args) {
+    std::vector<double> scratch;
+    const std::vector<double>& numbers = numbersOf(args[0], "min", scratch);
+    if (numbers.empty()) {
+        throw std::runtime_error("min of an empty array");
+    }
+    return Value(kernels::min(numbers.data(), numbers.size()));
+}
+
+Value arrayMax(const Value* args) {
+    std::vector<double> scratch;
+    const std::vector<double>& numbers = numbersOf(args[0], "max", scratch);
+    if (numbers.empty()) {
+        throw std::runtime_error("max of an empty array");
+    }
+    return Value(kernels::max(numbers.data(), numbers.size()));
+}
+
+Value arrayDot(const Value* args) {
+    std::vector<double> leftScratch;
+    std::vector<double> rightScratch;
+    const std::vector<double>& left = numbersOf(args[0], "dot", leftScratch);
+    const std::vector<double>& right = numbersOf(args[1], "dot", rightScratch);
+    if (left.size() != right.size()) {
+        throw std::runtime_error("dot expects arrays of the same length");
+    }
+    return Value(kernels::dot(left.data(), right.data(), left.size()));
+}
+
+Value arrayScale(const Value* args) {
+    std::vector<double> scratch;
+    const std::vector<double>& numbers = numbersOf(args[0], "scale", scratch);
+    if (args[1].type != Value::NUMBER) {
+        throw std::runtime_error("scale expects a number factor");
+    }
+    std::vector<double> result(numbers.size());
+    kernels::scale(numbers.data(), args[1].numberValue, result.data(), numbers.size());
+    return packedArray(std::move(result));
+}
+
+Value arrayAdd(const Value* args) {
+    std::vector<double> leftScratch;
+    std::vector<double> rightScratch;
+    const std::vector<double>& left = numbersOf(args[0], "add", leftScratch);
+    const std::vector<double>& right = numbersOf(args[1], "add", rightScratch);
+    if (left.size() != right.size()) {
+        throw std::runtime_error("add expects arrays of the same length");
+    }
+    std::vector<double> result(left.size());
+    kernels::add(left.data(), right.data(), result.data(), left.size());
+    return packedArray(std::move(result));
+}
+
+// receiver и args могут лежать в регистрах VM, которые вложенный вызов
+// колбэка перераспределит, поэтому до обхода всё нужное копируется
+Value callArrayMethod(Value& receiver, Symbol method, const Value* args, size_t count,
+                      FunctionCaller& caller) {
+    if (receiver.type != Value::ARRAY || !receiver.arrayValue) {
+        throw std::runtime_error("Cannot call methods of this type");
+    }
+    const ArrayMethods& methods = arrayMethods();
+
+    if (method == methods.push) {
+        expectArguments("push", count, 1, 1);
+        ArrayStorage& array = receiver.mutableArray();
+        array.push(args[0]);
+        return Value(static_cast<double>(array.size()));
+    }
+    if (method == methods.pop) {
+        expectArguments("pop", count, 0, 0);
+        if (receiver.arrayValue->size() == 0) {
+            return Value();
+        }
+        return receiver.mutableArray().pop();
+    }
+
+    // Снимок элементов: изменения receiver из колбэка его не затронут
+    std::shared_ptr<const ArrayStorage> elements = receiver.arrayValue;
+    const ArrayStorage& array = *elements;
+    size_t size = array.size();
+
+    if (method == methods.slice) {
+        expectArguments("slice", count, 1, 2);
+        size_t from = sliceBound(args[0], size);
+        size_t to = count > 1 ? sliceBound(args[1], size) : size;
+        return makeArray(array.slice(from, to < from ? from : to));
+    }
+    if (method == methods.indexOf) {
+        expectArguments("indexOf", count, 1, 1);
+        const Value& target = args[0];
+        for (size_t i = 0; i < size; i++) {
+            bool equal = array.kind() == ArrayStorage::PACKED_DOUBLE && target.type == Value::NUMBER
+                ? numbersEqual(array.numbers()[i], target.numberValue)
+                : equalValues(array.get(i), target).booleanValue;
+            if (equal) {
+                return Value(static_cast<double>(i));
+            }
+        }
+        return Value(-1.0);
+    }
+    if (method == methods.concat) {
+        expectArguments("concat", count, 1, 1);
+        ArrayStorage result = array;
+        if (args[0].type == Value::ARRAY && args[0].arrayValue) {
+            result.append(*args[0].arrayValue);
+        } else {
+            result.push(args[0]);
+        }
+        return makeArray(std::move(result));
+    }
+    if (method == methods.map) {
+        expectArguments("map", count, 1, 1);
+        Value function = callback(args[0], "map", 1);
+        ArrayStorage result;
+        result.reserve(size);
+        for (size_t i = 0; i < size; i++) {
+            Value element = array.get(i);
+            result.push(caller.call(function, &element, 1));
+        }
+        return makeArray(std::move(result));
+    }
+    if (method == methods.filter) {
+        expectArguments("filter", count, 1, 1);
+        Value function = callback(args[0], "filter", 1);
+        ArrayStorage result;
+        for (size_t i = 0; i < size; i++) {
+            Value element = array.get(i);
+            if (caller.call(function, &element, 1).booleanValue) {
+                result.push(std::move(element));
+            }
+        }
+        return makeArray(std::move(result));
+    }
+    if (method == methods.reduce) {
+        expectArguments("reduce", count, 2, 2);
+        Value function = callback(args[0], "reduce", 2);
+        Value pair[2] = {args[1], Value()}; // Аккумулятор и элемент
+        for (size_t i = 0; i < size; i++) {
+            pair[1] = array.get(i);
+            pair[0] = caller.call(function, pair, 2);
+        }
+        return pair[0];
+    }
+    throw std::runtime_error("Unknown method: " + symbolName(method));
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef ARRAY_H
+#define ARRAY_H
+
+#include "environment.h"
+#include <cstddef>
+#include <vector>
+
+// Элементы массива с видом (elements kind): пока все элементы — числа, они
+// лежат подряд как double, по 8 байт вместо целого Value, и численные
+// встроенные функции обходят их векторными ядрами. Первая запись не-числа
+// переводит массив в общий вид; обратно он не возвращается.
+class ArrayStorage {
+public:
+    enum Kind { PACKED_DOUBLE, GENERIC };
+
+    ArrayStorage() = default;
+    explicit ArrayStorage(std::vector<double> numbers);
+
+    Kind kind() const { return elementsKind; }
+    size_t size() const { return elementsKind == PACKED_DOUBLE ? doubles.size() : values.size(); }
+    void reserve(size_t capacity);
+
+    Value get(size_t index) const;
+    void set(size_t index, const Value& value);
+    void push(const Value& value);
+    void push(Value&& value);
+    // Удаляет и возвращает последний элемент; массив не пуст
+    Value pop();
+    // Элементы [from, to) того же вида
+    ArrayStorage slice(size_t from, size_t to) const;
+    void append(const ArrayStorage& other);
+
+    // Только для PACKED_DOUBLE
+    const std::vector<double>& numbers() const { return doubles; }
+    // Только для GENERIC
+    const std::vector<Value>& elements() const { return values; }
+
+private:
+    Kind elementsKind = PACKED_DOUBLE;
+    std::vector<double> doubles;
+    std::vector<Value> values;
+
+    void generalize();
+};
+
+// Ядра над непрерывными double: AVX, если процессор его поддерживает, иначе
+// SSE2 или скалярный цикл. Сумма копится в четырёх частичных суммах в одном и
+// том же порядке на всех путях, поэтому результат не зависит от процессора.
+namespace kernels {
+double sum(const double* data, size_t count);
+double dot(const double* left, const double* right, size_t count);
+// count > 0
+double min(const double* data, size_t count);
+double max(const double* data, size_t count);
+void scale(const double* data, double factor, double* out, size_t count);
+void add(const double* left, const double* right, double* out, size_t count);
+} // namespace kernels
+
+// Встроенные функции над массивами чисел (см. findBuiltin в runtime.h)
+Value arraySum(const Value* args);
+Value arrayMin(const Value* args);
+Value arrayMax(const Value* args);
+Value arrayDot(const Value* args);
+Value arrayScale(const Value* args);
+Value arrayAdd(const Value* args);
+
+#endif // ARRAY_H
\ No newline at end of file
@@ -11,9 +11,9 @@ std::unique_ptr<ASTNode> NumberLiteral::clone() const {
 }
 
 // StringLiteral
-StringLiteral::StringLiteral(const std::string& value) : value(value) {}
+StringLiteral::StringLiteral(StringStorage value) : value(std::move(value)) {}
 void StringLiteral::print(int indent) const {
-    std::cout << std::string(indent, ' ') << "StringLiteral(\"" << value << "\")\n";
+    std::cout << std::string(indent, ' ') << "StringLiteral(\"" << *value << "\")\n";
 }
 std::unique_ptr<ASTNode> StringLiteral::clone() const {
     return std::make_unique<StringLiteral>(value);
@@ -29,7 +29,7 @@ std::unique_ptr<ASTNode> BooleanLiteral::clone() const {
 }
 
 // Identifier
-Identifier::Identifier(const std::string& name) : name(name) {}
+Identifier::Identifier(const std::string& name) : name(name), symbol(intern(name)) {}
 void Identifier::print(int indent) const {
     std::cout << std::string(indent, ' ') << "Identifier(" << name << ")\n";
 }
@@ -39,7 +39,8 @@ std::unique_ptr<ASTNode> Identifier::clone() const {
 
 // BinaryOperation
 BinaryOperation::BinaryOperation(std::unique_ptr<Expression> left, const std::string& op, std::unique_ptr<Expression> right)
-    : left(std::move(left)), op(op), right(std::move(right)) {}
+    : left(std::move(left)), op(op), right(std::move(right)),
+      specialization(UNSPECIALIZED), deoptCount(0) {}
 void BinaryOperation::print(int indent) const {
     std::cout << std::string(indent, ' ') << "BinaryOperation(" << op << ")\n";
     left->print(indent + 2);
@@ -67,9 +68,22 @@ std::unique_ptr<ASTNode> UnaryOperation::clone() const {
     );
 }
 
+// AwaitExpression
+AwaitExpression::AwaitExpression(std::unique_ptr<Expression> operand)
+    : operand(std::move(operand)) {}
+void AwaitExpression::print(int indent) const {
+    std::cout << std::string(indent, ' ') << "AwaitExpression\n";
+    operand->print(indent + 2);
+}
+std::unique_ptr<ASTNode> AwaitExpression::clone() const {
+    return std::make_unique<AwaitExpression>(
+        std::unique_ptr<Expression>(static_cast<Expression*>(operand->clone().release()))
+    );
+}
+
 // FunctionCall
 FunctionCall::FunctionCall(const std::string& functionName, std::vector<std::unique_ptr<Expression>> arguments)
-    : functionName(functionName), arguments(std::move(arguments)) {}
+    : functionName(functionName), functionSymbol(intern(functionName)), arguments(std::move(arguments)) {}
 void FunctionCall::print(int indent) const {
     std::cout << std::string(indent, ' ') << "FunctionCall(" << functionName << ")\n";
     for (const auto& arg : arguments) {
@@ -118,7 +132,7 @@ std::unique_ptr<ASTNode> Block::clone() const {
 
 // VariableDeclaration
 VariableDeclaration::VariableDeclaration(const std::string& variableName, std::unique_ptr<Expression> initializer)
-    : variableName(variableName), initializer(std::move(initializer)) {}
+    : variableName(variableName), variableSymbol(intern(variableName)), initializer(std::move(initializer)) {}
 void VariableDeclaration::print(int indent) const {
     std::cout << std::string(indent, ' ') << "VariableDeclaration(" << variableName << ")\n";
     if (initializer) {
@@ -135,10 +149,10 @@ std::unique_ptr<ASTNode> VariableDeclaration::clone() const {
 
 // Assignment
 Assignment::Assignment(const std::string& variableName, std::unique_ptr<Expression> value)
-    : variableName(variableName), value(std::move(value)), target(nullptr) {}
+    : variableName(variableName), variableSymbol(intern(variableName)), value(std::move(value)), target(nullptr) {}
 
 Assignment::Assignment(const std::string& variableName, std::unique_ptr<Expression> value, std::unique_ptr<Expression> target)
-    : variableName(variableName), value(std::move(value)), target(std::move(target)) {}
+    : variableName(variableName), variableSymbol(intern(variableName)), value(std::move(value)), target(std::move(target)) {}
 
 void Assignment::print(int indent) const {
     std::cout << std::string(indent, ' ') << "Assignment(" << variableName << ")\n";
@@ -190,7 +204,7 @@ std::unique_ptr<ASTNode> IfStatement::clone() const {
 
 // WhileStatement
 WhileStatement::WhileStatement(std::unique_ptr<Expression> condition, std::unique_ptr<Block> body)
-    : condition(std::move(condition)), body(std::move(body)) {}
+    : condition(std::move(condition)), body(std::move(body)), traceId(-1) {}
 void WhileStatement::print(int indent) const {
     std::cout << std::string(indent, ' ') << "WhileStatement:\n";
     condition->print(indent + 2);
@@ -220,6 +234,18 @@ std::unique_ptr<ASTNode> ReturnStatement::clone() const {
     return std::make_unique<ReturnStatement>(std::move(clonedValue));
 }
 
+// YieldStatement
+YieldStatement::YieldStatement(std::unique_ptr<Expression> value) : value(std::move(value)) {}
+void YieldStatement::print(int indent) const {
+    std::cout << std::string(indent, ' ') << "YieldStatement:\n";
+    value->print(indent + 2);
+}
+std::unique_ptr<ASTNode> YieldStatement::clone() const {
+    return std::make_unique<YieldStatement>(
+        std::unique_ptr<Expression>(static_cast<Expression*>(value->clone().release()))
+    );
+}
+
 // PrintStatement
 PrintStatement::PrintStatement(std::unique_ptr<Expression> expression) : expression(std::move(expression)) {}
 void PrintStatement::print(int indent) const {
@@ -234,9 +260,15 @@ std::unique_ptr<ASTNode> PrintStatement::clone() const {
 
 // FunctionDeclaration
 FunctionDeclaration::FunctionDeclaration(const std::string& functionName, const std::vector<std::string>& parameters, std::unique_ptr<Block> body)
-    : functionName(functionName), parameters(parameters), body(std::move(body)) {}
+    : functionName(functionName), parameters(parameters), functionSymbol(intern(functionName)),
+      body(std::move(body)), isPure(false), isAsync(false), isGenerator(false) {
+    for (const auto& param : parameters) {
+        parameterSymbols.push_back(intern(param));
+    }
+}
 void FunctionDeclaration::print(int indent) const {
-    std::cout << std::string(indent, ' ') << "FunctionDeclaration(" << functionName << ")\n";
+    std::cout << std::string(indent, ' ') << "FunctionDeclaration(" << (isAsync ? "async " : "")
+              << functionName << (isGenerator ? "*" : "") << ")\n";
     std::cout << std::string(indent + 2, ' ') << "Parameters: ";
     for (const auto& param : parameters) {
         std::cout << param << " ";
@@ -245,11 +277,15 @@ void FunctionDeclaration::print(int indent) const {
     body->print(indent + 2);
 }
 std::unique_ptr<ASTNode> FunctionDeclaration::clone() const {
-    return std::make_unique<FunctionDeclaration>(
+    auto cloned = std::make_unique<FunctionDeclaration>(
         functionName,
         parameters,
         std::unique_ptr<Block>(static_cast<Block*>(body->clone().release()))
     );
+    cloned->isPure = isPure;
+    cloned->isAsync = isAsync;
+    cloned->isGenerator = isGenerator;
+    return cloned;
 }
 
 // Program
@@ -306,7 +342,11 @@ std::unique_ptr<ASTNode> IndexExpression::clone() const {
 
 // ObjectLiteral
 ObjectLiteral::ObjectLiteral(std::vector<std::pair<std::string, std::unique_ptr<Expression>>> properties)
-    : properties(std::move(properties)) {}
+    : properties(std::move(properties)) {
+    for (const auto& property : this->properties) {
+        keySymbols.push_back(intern(property.first));
+    }
+}
 
 void ObjectLiteral::print(int indent) const {
     std::cout << std::string(indent, ' ') << "ObjectLiteral:\n";
@@ -329,7 +369,7 @@ std::unique_ptr<ASTNode> ObjectLiteral::clone() const {
 
 // PropertyAccess
 PropertyAccess::PropertyAccess(std::unique_ptr<Expression> object, const std::string& property)
-    : object(std::move(object)), property(property) {}
+    : object(std::move(object)), property(property), propertySymbol(intern(property)) {}
 
 void PropertyAccess::print(int indent) const {
     std::cout << std::string(indent, ' ') << "PropertyAccess: ." << property << "\n";
@@ -343,13 +383,38 @@ std::unique_ptr<ASTNode> PropertyAccess::clone() const {
     );
 }
 
+// MethodCall
+MethodCall::MethodCall(std::unique_ptr<Expression> object, const std::string& method,
+                       std::vector<std::unique_ptr<Expression>> arguments)
+    : object(std::move(object)), method(method), methodSymbol(intern(method)), arguments(std::move(arguments)) {}
+
+void MethodCall::print(int indent) const {
+    std::cout << std::string(indent, ' ') << "MethodCall: ." << method << "\n";
+    object->print(indent + 2);
+    for (const auto& arg : arguments) {
+        arg->print(indent + 4);
+    }
+}
+
+std::unique_ptr<ASTNode> MethodCall::clone() const {
+    std::vector<std::unique_ptr<Expression>> clonedArgs;
+    for (const auto& arg : arguments) {
+        clonedArgs.push_back(std::unique_ptr<Expression>(static_cast<Expression*>(arg->clone().release())));
+    }
+    return std::make_unique<MethodCall>(
+        std::unique_ptr<Expression>(static_cast<Expression*>(object->clone().release())),
+        method,
+        std::move(clonedArgs)
+    );
+}
+
 // ForStatement
 ForStatement::ForStatement(std::unique_ptr<Statement> initializer, 
                          std::unique_ptr<Expression> condition,
                          std::unique_ptr<Expression> increment,
                          std::unique_ptr<Block> body)
     : initializer(std::move(initializer)), condition(std::move(condition)),
-      increment(std::move(increment)), body(std::move(body)) {}
+      increment(std::move(increment)), body(std::move(body)), traceId(-1) {}
 void ForStatement::print(int indent) const {
     std::cout << std::string(indent, ' ') << "ForStatement:\n";
     if (initializer) initializer->print(indent + 2);
@@ -366,6 +431,24 @@ std::unique_ptr<ASTNode> ForStatement::clone() const {
     );
 }
 
+// ForInStatement
+ForInStatement::ForInStatement(const std::string& variableName, std::unique_ptr<Expression> iterable,
+                               std::unique_ptr<Block> body)
+    : variableName(variableName), variableSymbol(intern(variableName)), iterable(std::move(iterable)),
+      body(std::move(body)) {}
+void ForInStatement::print(int indent) const {
+    std::cout << std::string(indent, ' ') << "ForInStatement(" << variableName << "):\n";
+    iterable->print(indent + 2);
+    body->print(indent + 2);
+}
+std::unique_ptr<ASTNode> ForInStatement::clone() const {
+    return std::make_unique<ForInStatement>(
+        variableName,
+        std::unique_ptr<Expression>(static_cast<Expression*>(iterable->clone().release())),
+        std::unique_ptr<Block>(static_cast<Block*>(body->clone().release()))
+    );
+}
+
 // NullLiteral
 NullLiteral::NullLiteral() {}
 void NullLiteral::print(int indent) const {
@@ -1,11 +1,17 @@
 #ifndef AST_H
 #define AST_H
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <memory>
 #include <iostream>
 #include <utility> 
+#include "symbol.h"
+
+// Неизменяемая строка с общим хранилищем: литералы программы и строковые
+// значения делят его по указателю, копия значения не копирует символы
+using StringStorage = std::shared_ptr<const std::string>;
 
 // Базовый класс для всех узлов AST
 class ASTNode {
@@ -34,8 +40,8 @@ public:
 // Строковый литерал
 class StringLiteral : public Expression {
 public:
-    std::string value;
-    StringLiteral(const std::string& value);
+    StringStorage value; // Из пула констант программы (Parser::internString)
+    StringLiteral(StringStorage value);
     void print(int indent) const override;
     std::unique_ptr<ASTNode> clone() const override;
 };
@@ -53,6 +59,7 @@ public:
 class Identifier : public Expression {
 public:
     std::string name;
+    Symbol symbol;
     Identifier(const std::string& name);
     void print(int indent) const override;
     std::unique_ptr<ASTNode> clone() const override;
@@ -61,9 +68,25 @@ public:
 // Бинарная операция
 class BinaryOperation : public Expression {
 public:
+    // Специализация по наблюдаемым типам операндов (quickening).
+    // Узел переписывает себя при первом выполнении и откатывается к GENERIC,
+    // если защитная проверка типов не прошла. Программу могут выполнять
+    // несколько изолятов сразу, поэтому поля атомарные: это лишь подсказка,
+    // каждое выполнение всё равно проверяет типы операндов.
+    enum Specialization {
+        UNSPECIALIZED, GENERIC,
+        NUMBER_ADD, NUMBER_SUB, NUMBER_MUL, NUMBER_DIV,
+        NUMBER_LESS, NUMBER_GREATER, NUMBER_LESS_EQUAL, NUMBER_GREATER_EQUAL,
+        NUMBER_EQUALS, NUMBER_NOT_EQUALS,
+        STRING_CONCAT, STRING_EQUALS, STRING_NOT_EQUALS,
+        BOOLEAN_AND, BOOLEAN_OR
+    };
+    
     std::unique_ptr<Expression> left;
     std::string op;
     std::unique_ptr<Expression> right;
+    mutable std::atomic<Specialization> specialization;
+    mutable std::atomic<int> deoptCount;
     BinaryOperation(std::unique_ptr<Expression> left, const std::string& op, std::unique_ptr<Expression> right);
     void print(int indent) const override;
     std::unique_ptr<ASTNode> clone() const override;
@@ -79,10 +102,20 @@ public:
     std::unique_ptr<ASTNode> clone() const override;
 };
 
+// await: ждать обещание, не занимая поток (eventloop.h)
+class AwaitExpression : public Expression {
+public:
+    std::unique_ptr<Expression> operand;
+    explicit AwaitExpression(std::unique_ptr<Expression> operand);
+    void print(int indent) const override;
+    std::unique_ptr<ASTNode> clone() const override;
+};
+
 // Вызов функции
 class FunctionCall : public Expression {
 public:
     std::string functionName;
+    Symbol functionSymbol;
     std::vector<std::unique_ptr<Expression>> arguments;
     FunctionCall(const std::string& functionName, std::vector<std::unique_ptr<Expression>> arguments);
     void print(int indent) const override;
@@ -119,6 +152,7 @@ public:
 class VariableDeclaration : public Statement {
 public:
     std::string variableName;
+    Symbol variableSymbol;
     std::unique_ptr<Expression> initializer;
     VariableDeclaration(const std::string& variableName, std::unique_ptr<Expression> initializer);
     void print(int indent) const override;
@@ -129,6 +163,7 @@ public:
 class Assignment : public Statement {
 public:
     std::string variableName;
+    Symbol variableSymbol;
     std::unique_ptr<Expression> value;
     std::unique_ptr<Expression> target; // Для присваивания элементам массива/объекта
     
@@ -156,6 +191,7 @@ class WhileStatement : public Statement {
 public:
     std::unique_ptr<Expression> condition;
     std::unique_ptr<Block> body;
+    mutable std::atomic<int> traceId; // Номер цикла для Tracer (-1 — ещё не встречался)
     WhileStatement(std::unique_ptr<Expression> condition, std::unique_ptr<Block> body);
     void print(int indent) const override;
     std::unique_ptr<ASTNode> clone() const override;
@@ -170,6 +206,15 @@ public:
     std::unique_ptr<ASTNode> clone() const override;
 };
 
+// Оператор yield в генераторе (fun*)
+class YieldStatement : public Statement {
+public:
+    std::unique_ptr<Expression> value;
+    YieldStatement(std::unique_ptr<Expression> value);
+    void print(int indent) const override;
+    std::unique_ptr<ASTNode> clone() const override;
+};
+
 // Оператор print
 class PrintStatement : public Statement {
 public:
@@ -184,7 +229,13 @@ class FunctionDeclaration : public Statement {
 public:
     std::string functionName;
     std::vector<std::string> parameters;
-    std::unique_ptr<Block> body;
+    Symbol functionSymbol;
+    std::vector<Symbol> parameterSymbols;
+    // Общее со значениями-функциями: выполнение объявления не копирует тело
+    std::shared_ptr<Block> body;
+    bool isPure; // Выставляется PurityAnalyzer
+    bool isAsync; // async fun: вызов возвращает обещание (eventloop.h)
+    bool isGenerator; // fun*: вызов возвращает генератор, тело выполняется в for..in
     FunctionDeclaration(const std::string& functionName, const std::vector<std::string>& parameters, std::unique_ptr<Block> body);
     void print(int indent) const override;
     std::unique_ptr<ASTNode> clone() const override;
@@ -223,6 +274,7 @@ public:
 class ObjectLiteral : public Expression {
 public:
     std::vector<std::pair<std::string, std::unique_ptr<Expression>>> properties;
+    std::vector<Symbol> keySymbols; // Ключи properties в том же порядке
     ObjectLiteral(std::vector<std::pair<std::string, std::unique_ptr<Expression>>> properties);
     void print(int indent) const override;
     std::unique_ptr<ASTNode> clone() const override;
@@ -233,11 +285,25 @@ class PropertyAccess : public Expression {
 public:
     std::unique_ptr<Expression> object;
     std::string property;
+    Symbol propertySymbol;
     PropertyAccess(std::unique_ptr<Expression> object, const std::string& property);
     void print(int indent) const override;
     std::unique_ptr<ASTNode> clone() const override;
 };
 
+// Вызов метода: object.method(arguments)
+class MethodCall : public Expression {
+public:
+    std::unique_ptr<Expression> object;
+    std::string method;
+    Symbol methodSymbol;
+    std::vector<std::unique_ptr<Expression>> arguments;
+    MethodCall(std::unique_ptr<Expression> object, const std::string& method,
+               std::vector<std::unique_ptr<Expression>> arguments);
+    void print(int indent) const override;
+    std::unique_ptr<ASTNode> clone() const override;
+};
+
 // Цикл for
 class ForStatement : public Statement {
 public:
@@ -245,6 +311,7 @@ public:
     std::unique_ptr<Expression> condition;
     std::unique_ptr<Expression> increment;
     std::unique_ptr<Block> body;
+    mutable std::atomic<int> traceId; // Номер цикла для Tracer (-1 — ещё не встречался)
     ForStatement(std::unique_ptr<Statement> initializer, 
                  std::unique_ptr<Expression> condition,
                  std::unique_ptr<Expression> increment,
@@ -253,6 +320,18 @@ public:
     std::unique_ptr<ASTNode> clone() const override;
 };
 
+// Цикл for..in по элементам массива или значениям генератора
+class ForInStatement : public Statement {
+public:
+    std::string variableName;
+    Symbol variableSymbol;
+    std::unique_ptr<Expression> iterable;
+    std::unique_ptr<Block> body;
+    ForInStatement(const std::string& variableName, std::unique_ptr<Expression> iterable, std::unique_ptr<Block> body);
+    void print(int indent) const override;
+    std::unique_ptr<ASTNode> clone() const override;
+};
+
 // Null литерал
 class NullLiteral : public Expression {
 public:
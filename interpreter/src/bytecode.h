@@ -0,0 +1,97 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "environment.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Команды регистровой виртуальной машины. Список задан X-макросом, чтобы
+// перечисление, имена для профиля и таблица меток VM не расходились.
+//   R[x] — регистр окна текущего вызова, K[x] — константа функции;
+//   RK[x] — регистр при x >= 0 и константа K[-1 - x] при x < 0.
+#define VM_OPCODES(X) \
+    X(MOVE)           /* R[a] = R[b] */ \
+    X(LOAD_CONST)     /* R[a] = K[b] */ \
+    X(LOAD_NIL)       /* R[a] = null */ \
+    X(GET_NAME)       /* R[a] = переменная names[b] */ \
+    X(SET_NAME)       /* переменная names[a] = RK[b] */ \
+    X(DECLARE_LOCAL)  /* локальная R[a] становится видимой по имени */ \
+    X(DEFINE_NAME)    /* globals.define(names[a], RK[b]) */ \
+    X(ADD) X(SUB) X(MUL) X(DIV) \
+    X(EQ) X(NE) X(LT) X(GT) X(LE) X(GE) \
+    X(AND) X(OR)      /* R[a] = RK[b] op RK[c] */ \
+    X(NEG) X(NOT)     /* R[a] = op RK[b] */ \
+    X(JUMP)           /* pc = a */ \
+    X(JUMP_IF_FALSE)  /* if (!RK[b].booleanValue) pc = a */ \
+    X(JUMP_IF_NOT_LT) /* if (!(RK[b] < RK[c])) pc = a */ \
+    X(JUMP_IF_NOT_LE) /* if (!(RK[b] <= RK[c])) pc = a */ \
+    X(PRINT)          /* print RK[a] */ \
+    X(PRINT_ITEM)     /* print(...): вывести RK[a] и пробел */ \
+    X(PRINT_END)      /* print(...): перевод строки */ \
+    X(GET_FUNCTION)   /* R[a] = функция names[b], проверив арность c */ \
+    X(CALL)           /* R[a] = R[a](R[a + 1] .. R[a + b]) */ \
+    X(RETURN)         /* вернуть RK[a] */ \
+    X(HALT)           /* конец программы */ \
+    X(FUNCTION)       /* R[a] = функция functions[b] */ \
+    X(ARRAY)          /* R[a] = [R[b] .. R[b + c - 1]] */ \
+    X(OBJECT)         /* R[a] = объект с ключами keyLists[c] из R[b] .. */ \
+    X(INDEX)          /* R[a] = RK[b][RK[c]] */ \
+    X(PROPERTY)       /* R[a] = RK[b].names[c] */ \
+    X(METHOD)         /* R[a] = получатель.methodSites[c](R[a + 1] ..); получатель — \
+                         R[b] при b >= 0, иначе переменная names[-1 - b] (меняется на месте) */
+
+enum class Op {
+#define VM_OPCODE_ENUM(name) name,
+    VM_OPCODES(VM_OPCODE_ENUM)
+#undef VM_OPCODE_ENUM
+    COUNT
+};
+
+const char* opName(Op op);
+
+struct Instruction {
+    Op op;
+    int a;
+    int b;
+    int c;
+    const void* target; // Адрес обработчика при шитом коде (computed goto)
+};
+
+// Имя, к которому обращается функция: slot — её локальный регистр с этим
+// именем или -1. Область видимости динамическая, поэтому имя ищется во время
+// выполнения: своя локальная (если уже объявлена), затем вызывающие, затем globals.
+struct NameRef {
+    std::string name;
+    Symbol symbol;
+    int slot;
+};
+
+// Вызов метода массива: имя метода и число аргументов
+struct MethodSite {
+    Symbol method;
+    int argumentCount;
+};
+
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<Value> constants;
+    std::vector<NameRef> names;
+    std::vector<std::vector<Symbol>> keyLists;
+    std::vector<MethodSite> methodSites;
+    int registers = 0;    // Размер окна: локальные, затем временные
+    bool threaded = false;
+};
+
+// Скомпилированная функция. Значение-функция ссылается на неё телом-меткой.
+// Параметры занимают первые локальные регистры.
+struct FunctionProto {
+    std::string name;
+    std::vector<Symbol> parameters;
+    std::vector<Symbol> localSymbols; // Регистр локальной -> символ её имени
+    Chunk chunk;
+    std::shared_ptr<Block> marker;
+    bool pure = false; // FunctionDeclaration::isPure, для parallelMap
+};
+
+#endif // BYTECODE_H
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <atomic>
+#include <utility>
+
+// Неограниченная очередь без блокировок для одного писателя и одного
+// читателя (SPSC). Список узлов с фиктивной головой: писатель меняет только
+// tail, читатель — только head, встречаются они лишь на атомарном next.
+// Узлы, которые читатель прошёл, писатель забирает себе (free) вместо
+// нового выделения памяти, так что в установившемся режиме new не нужен.
+template <typename T>
+class SpscQueue {
+public:
+    SpscQueue() {
+        Node* stub = new Node();
+        head.store(stub, std::memory_order_relaxed);
+        tail = stub;
+        free = stub;
+    }
+
+    ~SpscQueue() {
+        Node* node = free;
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Только из потока писателя
+    void push(T value) {
+        Node* node = allocate();
+        node->value = std::move(value);
+        node->next.store(nullptr, std::memory_order_relaxed);
+        tail->next.store(node, std::memory_order_release);
+        tail = node;
+    }
+
+    // Только из потока читателя; false — очередь пуста
+    bool pop(T& value) {
+        Node* current = head.load(std::memory_order_relaxed);
+        Node* next = current->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        value = std::move(next->value);
+        next->value = T();
+        // Прочитанный узел становится фиктивной головой; прежняя голова свободна
+        head.store(next, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Node {
+        T value;
+        std::atomic<Node*> next{nullptr};
+    };
+
+    std::atomic<Node*> head; // Фиктивный узел; пишет читатель
+    Node* tail;              // Последний узел; только писатель
+    Node* free;              // Начало узлов до head, которые можно переиспользовать; только писатель
+
+    Node* allocate() {
+        if (free != head.load(std::memory_order_acquire)) {
+            Node* node = free;
+            free = free->next.load(std::memory_order_relaxed);
+            return node;
+        }
+        return new Node();
+    }
+};
+
+#endif // CHANNEL_H
\ No newline at end of file
@@ -0,0 +1,521 @@
+#include "compiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+
+Op binaryOpcode(const std::string& op) {
+    if (op == "+") return Op::ADD;
+    if (op == "-") return Op::SUB;
+    if (op == "*") return Op::MUL;
+    if (op == "/") return Op::DIV;
+    if (op == "==") return Op::EQ;
+    if (op == "!=") return Op::NE;
+    if (op == "<") return Op::LT;
+    if (op == ">") return Op::GT;
+    if (op == "<=") return Op::LE;
+    if (op == ">=") return Op::GE;
+    if (op == "and") return Op::AND;
+    if (op == "or") return Op::OR;
+    return Op::COUNT;
+}
+
+// Может ли вычисление выражения изменить переменные (только через вызов функции)
+bool hasCall(const Expression& expr) {
+    if (dynamic_cast<const FunctionCall*>(&expr) || dynamic_cast<const MethodCall*>(&expr)) {
+        return true;
+    }
+    else if (auto binOp = dynamic_cast<const BinaryOperation*>(&expr)) {
+        return hasCall(*binOp->left) || hasCall(*binOp->right);
+    }
+    else if (auto unOp = dynamic_cast<const UnaryOperation*>(&expr)) {
+        return hasCall(*unOp->operand);
+    }
+    else if (auto array = dynamic_cast<const ArrayLiteral*>(&expr)) {
+        for (const auto& element : array->elements) {
+            if (hasCall(*element)) return true;
+        }
+    }
+    else if (auto object = dynamic_cast<const ObjectLiteral*>(&expr)) {
+        for (const auto& property : object->properties) {
+            if (hasCall(*property.second)) return true;
+        }
+    }
+    else if (auto indexExpr = dynamic_cast<const IndexExpression*>(&expr)) {
+        return hasCall(*indexExpr->object) || hasCall(*indexExpr->index);
+    }
+    else if (auto propAccess = dynamic_cast<const PropertyAccess*>(&expr)) {
+        return hasCall(*propAccess->object);
+    }
+    return false;
+}
+
+// Имена, которые функция объявляет сама (let и fun, кроме вложенных функций)
+void collectLocals(const Statement& stmt, std::vector<std::string>& names) {
+    if (auto varDecl = dynamic_cast<const VariableDeclaration*>(&stmt)) {
+        names.push_back(varDecl->variableName);
+    }
+    else if (auto funcDecl = dynamic_cast<const FunctionDeclaration*>(&stmt)) {
+        names.push_back(funcDecl->functionName);
+    }
+    else if (auto ifStmt = dynamic_cast<const IfStatement*>(&stmt)) {
+        collectLocals(*ifStmt->thenBlock, names);
+        if (ifStmt->elseBlock) collectLocals(*ifStmt->elseBlock, names);
+    }
+    else if (auto whileStmt = dynamic_cast<const WhileStatement*>(&stmt)) {
+        collectLocals(*whileStmt->body, names);
+    }
+    else if (auto forStmt = dynamic_cast<const ForStatement*>(&stmt)) {
+        if (forStmt->initializer) collectLocals(*forStmt->initializer, names);
+        collectLocals(*forStmt->body, names);
+    }
+    else if (auto block = dynamic_cast<const Block*>(&stmt)) {
+        for (const auto& inner : block->statements) {
+            collectLocals(*inner, names);
+        }
+    }
+}
+
+} // namespace
+
+BytecodeCompiler::BytecodeCompiler(std::vector<std::unique_ptr<FunctionProto>>& functions)
+    : functions(functions) {}
+
+int BytecodeCompiler::emit(Op op, int a, int b, int c) {
+    chunk->code.push_back({op, a, b, c, nullptr});
+    return static_cast<int>(chunk->code.size()) - 1;
+}
+
+// Пул констант: одинаковые литералы функции хранятся один раз.
+// Возвращает операнд RK константы (-1 - индекс).
+int BytecodeCompiler::constant(const std::string& key, const Value& value) {
+    auto it = constantIndices.find(key);
+    if (it != constantIndices.end()) return -1 - it->second;
+
+    int index = static_cast<int>(chunk->constants.size());
+    chunk->constants.push_back(value);
+    constantIndices[key] = index;
+    return -1 - index;
+}
+
+int BytecodeCompiler::name(const std::string& identifier) {
+    auto it = nameIndices.find(identifier);
+    if (it != nameIndices.end()) return it->second;
+
+    int index = static_cast<int>(chunk->names.size());
+    chunk->names.push_back({identifier, intern(identifier), localSlot(identifier)});
+    nameIndices[identifier] = index;
+    return index;
+}
+
+int BytecodeCompiler::allocateRegister() {
+    int reg = freeRegister++;
+    chunk->registers = std::max(chunk->registers, freeRegister);
+    return reg;
+}
+
+int BytecodeCompiler::localSlot(const std::string& identifier) const {
+    auto it = localSlots.find(identifier);
+    return it != localSlots.end() ? it->second : -1;
+}
+
+// Локальная, которая в этой точке объявлена на любом пути выполнения:
+// её можно читать прямо из регистра, без поиска по имени
+int BytecodeCompiler::knownLocal(const std::string& identifier) const {
+    int slot = localSlot(identifier);
+    return slot >= 0 && declared[slot] ? slot : -1;
+}
+
+// Переход вперёд на следующую команду
+void BytecodeCompiler::patchJump(int at) {
+    chunk->code[at].a = static_cast<int>(chunk->code.size());
+}
+
+int BytecodeCompiler::compileOperand(const Expression& expr, bool mayAlias) {
+    if (auto num = dynamic_cast<const NumberLiteral*>(&expr)) {
+        char key[64];
+        std::snprintf(key, sizeof(key), "n%.17g", num->value);
+        return constant(key, Value(num->value));
+    }
+    else if (auto str = dynamic_cast<const StringLiteral*>(&expr)) {
+        return constant("s" + *str->value, Value::string(str->value));
+    }
+    else if (auto boolean = dynamic_cast<const BooleanLiteral*>(&expr)) {
+        return constant(boolean->value ? "btrue" : "bfalse", Value(boolean->value));
+    }
+    else if (auto id = dynamic_cast<const Identifier*>(&expr)) {
+        int slot = knownLocal(id->name);
+        if (slot >= 0 && mayAlias) return slot;
+    }
+
+    int temp = allocateRegister();
+    compileExpression(expr, temp);
+    freeRegister = temp + 1;
+    return temp;
+}
+
+void BytecodeCompiler::compileExpression(const Expression& expr, int target) {
+    // Операнды вычисляются во временные регистры; target пишется последней командой
+    int saved = freeRegister;
+
+    if (dynamic_cast<const NumberLiteral*>(&expr) || dynamic_cast<const StringLiteral*>(&expr) ||
+        dynamic_cast<const BooleanLiteral*>(&expr)) {
+        emit(Op::LOAD_CONST, target, -1 - compileOperand(expr));
+    }
+    else if (auto id = dynamic_cast<const Identifier*>(&expr)) {
+        int slot = knownLocal(id->name);
+        if (slot < 0) {
+            emit(Op::GET_NAME, target, name(id->name));
+        } else if (slot != target) {
+            emit(Op::MOVE, target, slot);
+        }
+    }
+    else if (auto binOp = dynamic_cast<const BinaryOperation*>(&expr)) {
+        int left = compileOperand(*binOp->left, !hasCall(*binOp->right));
+        int right = compileOperand(*binOp->right);
+        Op op = binaryOpcode(binOp->op);
+        if (op == Op::COUNT) {
+            // Неизвестная операция даёт null, как binaryOperation
+            emit(Op::LOAD_NIL, target);
+        } else {
+            emit(op, target, left, right);
+        }
+    }
+    else if (auto unOp = dynamic_cast<const UnaryOperation*>(&expr)) {
+        int operand = compileOperand(*unOp->operand);
+        if (unOp->op == "not") {
+            emit(Op::NOT, target, operand);
+        } else if (unOp->op == "-") {
+            emit(Op::NEG, target, operand);
+        } else {
+            emit(Op::LOAD_NIL, target);
+        }
+    }
+    else if (auto call = dynamic_cast<const FunctionCall*>(&expr)) {
+        if (call->functionName == "print") {
+            for (const auto& arg : call->arguments) {
+                emit(Op::PRINT_ITEM, compileOperand(*arg));
+                freeRegister = saved;
+            }
+            emit(Op::PRINT_END);
+            emit(Op::LOAD_NIL, target);
+            return;
+        }
+
+        // Функция и аргументы лежат подряд на вершине окна: с аргументов
+        // начинается окно вызываемой функции. Временный target на вершине
+        // сам становится базой вызова.
+        int argc = static_cast<int>(call->arguments.size());
+        bool targetOnTop = target == freeRegister - 1 &&
+                           target >= static_cast<int>(function->localSymbols.size());
+        int base = targetOnTop ? target : allocateRegister();
+        emit(Op::GET_FUNCTION, base, name(call->functionName), argc);
+        for (const auto& arg : call->arguments) {
+            int reg = allocateRegister();
+            compileExpression(*arg, reg);
+            freeRegister = reg + 1;
+        }
+        emit(Op::CALL, base, argc);
+        if (base != target) {
+            emit(Op::MOVE, target, base);
+        }
+    }
+    else if (auto array = dynamic_cast<const ArrayLiteral*>(&expr)) {
+        int first = freeRegister;
+        for (const auto& element : array->elements) {
+            int reg = allocateRegister();
+            compileExpression(*element, reg);
+            freeRegister = reg + 1;
+        }
+        emit(Op::ARRAY, target, first, static_cast<int>(array->elements.size()));
+    }
+    else if (auto object = dynamic_cast<const ObjectLiteral*>(&expr)) {
+        int first = freeRegister;
+        for (const auto& [key, value] : object->properties) {
+            int reg = allocateRegister();
+            compileExpression(*value, reg);
+            freeRegister = reg + 1;
+        }
+        chunk->keyLists.push_back(object->keySymbols);
+        emit(Op::OBJECT, target, first, static_cast<int>(chunk->keyLists.size()) - 1);
+    }
+    else if (auto indexExpr = dynamic_cast<const IndexExpression*>(&expr)) {
+        int object = compileOperand(*indexExpr->object, !hasCall(*indexExpr->index));
+        int index = compileOperand(*indexExpr->index);
+        emit(Op::INDEX, target, object, index);
+    }
+    else if (auto propAccess = dynamic_cast<const PropertyAccess*>(&expr)) {
+        int object = compileOperand(*propAccess->object);
+        emit(Op::PROPERTY, target, object, name(propAccess->property));
+    }
+    else if (auto methodCall = dynamic_cast<const MethodCall*>(&expr)) {
+        // Как в интерпретаторе: выражение-получатель вычисляется до аргументов,
+        // а переменная ищется после них и меняется на месте (push, pop)
+        auto id = dynamic_cast<const Identifier*>(methodCall->object.get());
+        int receiver = 0;
+        if (!id) {
+            receiver = allocateRegister();
+            compileExpression(*methodCall->object, receiver);
+            freeRegister = receiver + 1;
+        }
+        int base = allocateRegister();
+        for (const auto& arg : methodCall->arguments) {
+            int reg = allocateRegister();
+            compileExpression(*arg, reg);
+            freeRegister = reg + 1;
+        }
+        if (id) {
+            int slot = knownLocal(id->name);
+            receiver = slot >= 0 ? slot : -1 - name(id->name);
+        }
+        chunk->methodSites.push_back({methodCall->methodSymbol,
+                                      static_cast<int>(methodCall->arguments.size())});
+        emit(Op::METHOD, base, receiver, static_cast<int>(chunk->methodSites.size()) - 1);
+        if (base != target) {
+            emit(Op::MOVE, target, base);
+        }
+    }
+    else if (dynamic_cast<const AwaitExpression*>(&expr)) {
+        throw std::runtime_error("await is not supported by --vm");
+    }
+    else {
+        emit(Op::LOAD_NIL, target);
+    }
+
+    freeRegister = saved;
+}
+
+int BytecodeCompiler::compileCondition(const Expression& condition) {
+    // Сравнение с переходом — одна команда; a > b проверяется как b < a
+    if (auto binOp = dynamic_cast<const BinaryOperation*>(&condition)) {
+        const std::string& op = binOp->op;
+        if (op == "<" || op == "<=" || op == ">" || op == ">=") {
+            int left = compileOperand(*binOp->left, !hasCall(*binOp->right));
+            int right = compileOperand(*binOp->right);
+            Op jump = op == "<" || op == ">" ? Op::JUMP_IF_NOT_LT : Op::JUMP_IF_NOT_LE;
+            if (op[0] == '>') std::swap(left, right);
+            return emit(jump, 0, left, right);
+        }
+    }
+    return emit(Op::JUMP_IF_FALSE, 0, compileOperand(condition));
+}
+
+void BytecodeCompiler::compileBlock(const Block& block) {
+    for (const auto& stmt : block.statements) {
+        compileStatement(*stmt);
+    }
+}
+
+void BytecodeCompiler::compileStatement(const Statement& stmt) {
+    int saved = freeRegister;
+
+    if (auto varDecl = dynamic_cast<const VariableDeclaration*>(&stmt)) {
+        if (topLevel) {
+            int value = varDecl->initializer ? compileOperand(*varDecl->initializer) : constant("null", Value());
+            emit(Op::DEFINE_NAME, name(varDecl->variableName), value);
+        } else {
+            // Значение пишется прямо в регистр: до DECLARE_LOCAL имя
+            // по-прежнему находит внешнюю переменную
+            int slot = localSlot(varDecl->variableName);
+            if (varDecl->initializer) {
+                compileExpression(*varDecl->initializer, slot);
+            } else {
+                emit(Op::LOAD_NIL, slot);
+            }
+            if (!declared[slot]) {
+                emit(Op::DECLARE_LOCAL, slot);
+                declared[slot] = true;
+            }
+        }
+    }
+    else if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
+        // Как и интерпретатор, присваивание элементу перезаписывает саму переменную
+        int slot = knownLocal(assignment->variableName);
+        if (slot >= 0) {
+            compileExpression(*assignment->value, slot);
+        } else {
+            emit(Op::SET_NAME, name(assignment->variableName), compileOperand(*assignment->value));
+        }
+    }
+    else if (auto ifStmt = dynamic_cast<const IfStatement*>(&stmt)) {
+        int elseJump = compileCondition(*ifStmt->condition);
+        freeRegister = saved;
+
+        // После if объявлено то, что объявили обе ветви
+        std::vector<bool> before = declared;
+        compileBlock(*ifStmt->thenBlock);
+        if (ifStmt->elseBlock) {
+            int endJump = emit(Op::JUMP);
+            patchJump(elseJump);
+            std::vector<bool> afterThen = declared;
+            declared = before;
+            compileBlock(*ifStmt->elseBlock);
+            for (size_t i = 0; i < declared.size(); i++) {
+                declared[i] = declared[i] && afterThen[i];
+            }
+            patchJump(endJump);
+        } else {
+            patchJump(elseJump);
+            declared = before;
+        }
+    }
+    else if (auto whileStmt = dynamic_cast<const WhileStatement*>(&stmt)) {
+        // Тело может не выполниться ни разу
+        std::vector<bool> before = declared;
+        int start = static_cast<int>(chunk->code.size());
+        int exitJump = compileCondition(*whileStmt->condition);
+        freeRegister = saved;
+        compileBlock(*whileStmt->body);
+        emit(Op::JUMP, start);
+        patchJump(exitJump);
+        declared = before;
+    }
+    else if (auto printStmt = dynamic_cast<const PrintStatement*>(&stmt)) {
+        emit(Op::PRINT, compileOperand(*printStmt->expression));
+    }
+    else if (auto returnStmt = dynamic_cast<const ReturnStatement*>(&stmt)) {
+        int value = returnStmt->value ? compileOperand(*returnStmt->value) : constant("null", Value());
+        emit(Op::RETURN, value);
+    }
+    else if (auto funcDecl = dynamic_cast<const FunctionDeclaration*>(&stmt)) {
+        int index = compileFunction(*funcDecl);
+        if (topLevel) {
+            int temp = allocateRegister();
+            emit(Op::FUNCTION, temp, index);
+            emit(Op::DEFINE_NAME, name(funcDecl->functionName), temp);
+        } else {
+            int slot = localSlot(funcDecl->functionName);
+            emit(Op::FUNCTION, slot, index);
+            if (!declared[slot]) {
+                emit(Op::DECLARE_LOCAL, slot);
+                declared[slot] = true;
+            }
+        }
+    }
+    else if (auto block = dynamic_cast<const Block*>(&stmt)) {
+        compileBlock(*block);
+    }
+    else if (auto exprStmt = dynamic_cast<const ExpressionStatement*>(&stmt)) {
+        compileOperand(*exprStmt->expression);
+    }
+    else if (auto forStmt = dynamic_cast<const ForStatement*>(&stmt)) {
+        if (forStmt->initializer) {
+            compileStatement(*forStmt->initializer);
+        }
+        std::vector<bool> before = declared;
+        int start = static_cast<int>(chunk->code.size());
+        int exitJump = -1;
+        if (forStmt->condition) {
+            exitJump = compileCondition(*forStmt->condition);
+            freeRegister = saved;
+        }
+        compileBlock(*forStmt->body);
+        if (forStmt->increment) {
+            compileOperand(*forStmt->increment);
+            freeRegister = saved;
+        }
+        emit(Op::JUMP, start);
+        if (exitJump >= 0) {
+            patchJump(exitJump);
+        }
+        declared = before;
+    }
+    else if (dynamic_cast<const YieldStatement*>(&stmt) || dynamic_cast<const ForInStatement*>(&stmt)) {
+        throw std::runtime_error("yield and for..in are not supported by --vm");
+    }
+
+    freeRegister = saved;
+}
+
+void BytecodeCompiler::compileBody(FunctionProto& proto, const std::vector<std::unique_ptr<Statement>>& statements) {
+    // Вложенные объявления компилируются в собственные chunk'и
+    FunctionProto* savedFunction = function;
+    Chunk* savedChunk = chunk;
+    bool savedTopLevel = topLevel;
+    auto savedConstants = std::move(constantIndices);
+    auto savedNames = std::move(nameIndices);
+    auto savedLocals = std::move(localSlots);
+    auto savedDeclared = std::move(declared);
+    int savedFreeRegister = freeRegister;
+
+    function = &proto;
+    chunk = &proto.chunk;
+    topLevel = !proto.marker;
+    constantIndices.clear();
+    nameIndices.clear();
+    localSlots.clear();
+    declared.clear();
+
+    // Параметры — первые регистры окна: в них вызывающий уже положил аргументы
+    if (!topLevel) {
+        std::vector<std::string> names;
+        for (Symbol parameter : proto.parameters) {
+            names.push_back(symbolName(parameter));
+        }
+        for (const auto& stmt : statements) {
+            collectLocals(*stmt, names);
+        }
+        for (size_t i = 0; i < names.size(); i++) {
+            // Одноимённый параметр перекрывает предыдущий, как повторный define
+            if (i < proto.parameters.size() || !localSlots.count(names[i])) {
+                localSlots[names[i]] = static_cast<int>(proto.localSymbols.size());
+                proto.localSymbols.push_back(intern(names[i]));
+            }
+        }
+        declared.assign(proto.localSymbols.size(), false);
+        std::fill(declared.begin(), declared.begin() + proto.parameters.size(), true);
+    }
+    freeRegister = static_cast<int>(proto.localSymbols.size());
+    chunk->registers = freeRegister;
+
+    for (const auto& stmt : statements) {
+        compileStatement(*stmt);
+    }
+    if (topLevel) {
+        emit(Op::HALT);
+    } else {
+        emit(Op::RETURN, constant("null", Value()));
+    }
+
+    function = savedFunction;
+    chunk = savedChunk;
+    topLevel = savedTopLevel;
+    constantIndices = std::move(savedConstants);
+    nameIndices = std::move(savedNames);
+    localSlots = std::move(savedLocals);
+    declared = std::move(savedDeclared);
+    freeRegister = savedFreeRegister;
+}
+
+int BytecodeCompiler::compileFunction(const FunctionDeclaration& decl) {
+    // Приостановка на await и yield требует сопрограмм обхода AST (Interpreter::prepareCall)
+    if (decl.isAsync) {
+        throw std::runtime_error("async functions are not supported by --vm");
+    }
+    if (decl.isGenerator) {
+        throw std::runtime_error("generator functions are not supported by --vm");
+    }
+    auto proto = std::make_unique<FunctionProto>();
+    proto->name = decl.functionName;
+    proto->parameters = decl.parameterSymbols;
+    proto->marker = std::make_shared<Block>();
+    proto->pure = decl.isPure;
+
+    int index = static_cast<int>(functions.size());
+    FunctionProto& compiled = *proto;
+    functions.push_back(std::move(proto));
+    compileBody(compiled, decl.body->statements);
+    return index;
+}
+
+int BytecodeCompiler::compile(const Program& program) {
+    auto proto = std::make_unique<FunctionProto>();
+    proto->name = "<script>";
+
+    int index = static_cast<int>(functions.size());
+    FunctionProto& script = *proto;
+    functions.push_back(std::move(proto));
+    compileBody(script, program.statements);
+    return index;
+}
\ No newline at end of file
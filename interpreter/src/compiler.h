@@ -0,0 +1,56 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "ast.h"
+#include "bytecode.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Компиляция AST в байткод регистровой VM (см. vm.h). Локальные переменные
+// функции получают постоянные регистры окна, промежуточные значения — временные
+// регистры над ними. Порядок вычислений — как в интерпретаторе: функция ищется
+// и проверяется до аргументов, print(...) печатает каждый аргумент сразу.
+class BytecodeCompiler {
+private:
+    std::vector<std::unique_ptr<FunctionProto>>& functions;
+
+    // Состояние компилируемой функции
+    FunctionProto* function = nullptr;
+    Chunk* chunk = nullptr;
+    bool topLevel = true;       // Переменные верхнего уровня живут в globals
+    std::unordered_map<std::string, int> constantIndices;
+    std::unordered_map<std::string, int> nameIndices;
+    std::unordered_map<std::string, int> localSlots;
+    std::vector<bool> declared; // Локальная заведомо объявлена в этой точке кода
+    int freeRegister = 0;
+
+    int emit(Op op, int a = 0, int b = 0, int c = 0);
+    int constant(const std::string& key, const Value& value);
+    int name(const std::string& identifier);
+    int allocateRegister();
+    int localSlot(const std::string& identifier) const;
+    int knownLocal(const std::string& identifier) const;
+    void patchJump(int at);
+
+    // Значение выражения как операнд RK. Регистр локальной возвращается без копии,
+    // только если до использования операнда её не успеет изменить вызов (mayAlias).
+    int compileOperand(const Expression& expr, bool mayAlias = true);
+    void compileExpression(const Expression& expr, int target);
+    // Переход при ложном условии; возвращает команду, которую нужно дописать
+    int compileCondition(const Expression& condition);
+    void compileStatement(const Statement& stmt);
+    void compileBlock(const Block& block);
+    int compileFunction(const FunctionDeclaration& decl);
+    void compileBody(FunctionProto& proto, const std::vector<std::unique_ptr<Statement>>& statements);
+
+public:
+    // functions — протофункции VM; новые добавляются в конец
+    BytecodeCompiler(std::vector<std::unique_ptr<FunctionProto>>& functions);
+
+    // Возвращает индекс протофункции верхнего уровня
+    int compile(const Program& program);
+};
+
+#endif // COMPILER_H
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "coroutine.h"
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+thread_local Coroutine* running = nullptr;
+// Cancelled летит: от throw в yield/suspend до entry отменённой сопрограммы
+thread_local bool unwindingCancelled = false;
+
+size_t pageSize() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+} // namespace
+
+Coroutine::Coroutine(Body body, size_t stackSize) : body(std::move(body)), size(stackSize) {
+    // Нижняя страница недоступна: переполнение падает сразу, а не портит чужую память
+    void* memory = mmap(nullptr, size + pageSize(), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error("Cannot allocate coroutine stack");
+    }
+    stack = static_cast<char*>(memory);
+    mprotect(stack, pageSize(), PROT_NONE);
+
+    getcontext(&context);
+    context.uc_stack.ss_sp = stack + pageSize();
+    context.uc_stack.ss_size = size;
+    context.uc_link = nullptr;
+    makecontext(&context, &Coroutine::entry, 0);
+}
+
+Coroutine::~Coroutine() {
+    if (started && !done) {
+        cancelled = true;
+        try {
+            resume();
+        } catch (...) {
+        }
+    }
+    munmap(stack, size + pageSize());
+}
+
+const void* Coroutine::stackLowest() const {
+    return stack + pageSize();
+}
+
+Coroutine* Coroutine::current() {
+    return running;
+}
+
+bool Coroutine::unwinding() {
+    return unwindingCancelled;
+}
+
+void Coroutine::entry() {
+    Coroutine* self = running;
+    try {
+        self->body();
+    } catch (const Cancelled&) {
+        // Отменена внешняя сопрограмма: раскрутка продолжается на её стеке
+        if (!self->cancelled) {
+            self->error = std::current_exception();
+        } else {
+            unwindingCancelled = false;
+        }
+    } catch (...) {
+        self->error = std::current_exception();
+    }
+    self->done = true;
+    // Контекст завершённой сопрограммы больше не продолжается
+    swapcontext(&self->context, &self->caller);
+}
+
+void Coroutine::resume() {
+    if (done) return;
+    started = true;
+    resumer = running;
+    Coroutine* target = suspendedAt ? suspendedAt : this;
+    suspendedAt = nullptr;
+    running = target;
+    swapcontext(&caller, &target->context);
+    running = resumer;
+    if (error) {
+        std::exception_ptr thrown = error;
+        error = nullptr;
+        std::rethrow_exception(thrown);
+    }
+}
+
+void Coroutine::yield() {
+    Coroutine* self = running;
+    if (!self) {
+        throw std::runtime_error("yield outside of a coroutine");
+    }
+    swapcontext(&self->context, &self->caller);
+    if (self->cancelled) {
+        unwindingCancelled = true;
+        throw Cancelled();
+    }
+}
+
+void Coroutine::suspend(Coroutine* root) {
+    Coroutine* self = running;
+    if (!self) {
+        throw std::runtime_error("suspend outside of a coroutine");
+    }
+    root->suspendedAt = self;
+    swapcontext(&self->context, &root->caller);
+    if (root->cancelled) {
+        unwindingCancelled = true;
+        throw Cancelled();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <ucontext.h>
+
+// Сопрограмма со своим стеком (ucontext). Тело выполняется в resume и может
+// в любой глубине вызовов вернуть управление через yield — весь стек обхода
+// AST сохраняется, а поток свободен для других задач. Так await приостанавливает
+// async-функцию вместе со всеми вызывающими её функциями скрипта.
+class Coroutine {
+public:
+    using Body = std::function<void()>;
+
+    explicit Coroutine(Body body, size_t stackSize = DEFAULT_STACK_SIZE);
+    // Незавершённая сопрограмма раскручивается: yield бросает Cancelled,
+    // и деструкторы на её стеке выполняются
+    ~Coroutine();
+    Coroutine(const Coroutine&) = delete;
+    Coroutine& operator=(const Coroutine&) = delete;
+
+    // Выполнять тело до yield или до конца; исключение тела пробрасывается здесь
+    void resume();
+    bool finished() const { return done; }
+
+    // Вернуться в resume, продолживший текущую сопрограмму
+    static void yield();
+    // Приостановить root вместе с вложенными в неё сопрограммами (async-задачи,
+    // генераторы), внутри одной из которых выполняется код: управление
+    // возвращается в root->resume, а следующий root->resume продолжит
+    // выполнение с этого места. Так планировщик (scheduler.h) вытесняет скрипт
+    // на любой глубине.
+    static void suspend(Coroutine* root);
+    // Выполняемая сейчас сопрограмма этого потока; nullptr — обычный стек потока
+    static Coroutine* current();
+    // Идёт раскрутка отменённой сопрограммы (Cancelled): деструкторы на её
+    // стеке не должны трогать состояние того, кто её уничтожает
+    static bool unwinding();
+
+    // Границы стека для StackGuard
+    const void* stackLowest() const;
+    size_t stackSize() const { return size; }
+
+    // Бросается из yield при уничтожении незавершённой сопрограммы
+    struct Cancelled {};
+
+    // Как у стека главного потока: async-функции и генераторы рекурсируют не
+    // мельче обычных вызовов. Стек только резервируется (mmap), страницы
+    // отображаются при первом касании, поэтому тысячи задач не занимают память заранее
+    static constexpr size_t DEFAULT_STACK_SIZE = 8 * 1024 * 1024;
+
+private:
+    Body body;
+    char* stack = nullptr; // Вместе со сторожевой страницей внизу
+    size_t size;
+    ucontext_t context;
+    ucontext_t caller;
+    Coroutine* resumer = nullptr;
+    Coroutine* suspendedAt = nullptr; // Вложенная сопрограмма, остановленная suspend
+    bool started = false;
+    bool done = false;
+    bool cancelled = false;
+    std::exception_ptr error;
+
+    static void entry();
+};
+
+#endif // COROUTINE_H
\ No newline at end of file
@@ -0,0 +1,452 @@
+#include "cppemitter.h"
+#include <cctype>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+
+std::string padding(int indent) {
+    return std::string(indent * 4, ' ');
+}
+
+// Строковый литерал C++; непечатаемые байты — восьмеричными escape-последовательностями
+std::string quote(const std::string& text) {
+    std::string result = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += static_cast<char>(c);
+        } else if (c == '\n') {
+            result += "\\n";
+        } else if (c == '\t') {
+            result += "\\t";
+        } else if (std::isprint(c)) {
+            result += static_cast<char>(c);
+        } else {
+            char escaped[5];
+            std::snprintf(escaped, sizeof(escaped), "\\%03o", c);
+            result += escaped;
+        }
+    }
+    return result + "\"";
+}
+
+std::string sanitize(const std::string& name) {
+    std::string result;
+    for (unsigned char c : name) {
+        result += std::isalnum(c) ? static_cast<char>(c) : '_';
+    }
+    return result;
+}
+
+// Может ли вычисление выражения изменить переменные (только через вызов функции)
+bool hasCall(const Expression& expr) {
+    if (dynamic_cast<const FunctionCall*>(&expr) || dynamic_cast<const MethodCall*>(&expr)) {
+        return true;
+    }
+    else if (auto binOp = dynamic_cast<const BinaryOperation*>(&expr)) {
+        return hasCall(*binOp->left) || hasCall(*binOp->right);
+    }
+    else if (auto unOp = dynamic_cast<const UnaryOperation*>(&expr)) {
+        return hasCall(*unOp->operand);
+    }
+    else if (auto array = dynamic_cast<const ArrayLiteral*>(&expr)) {
+        for (const auto& element : array->elements) {
+            if (hasCall(*element)) return true;
+        }
+    }
+    else if (auto object = dynamic_cast<const ObjectLiteral*>(&expr)) {
+        for (const auto& property : object->properties) {
+            if (hasCall(*property.second)) return true;
+        }
+    }
+    else if (auto indexExpr = dynamic_cast<const IndexExpression*>(&expr)) {
+        return hasCall(*indexExpr->object) || hasCall(*indexExpr->index);
+    }
+    else if (auto propAccess = dynamic_cast<const PropertyAccess*>(&expr)) {
+        return hasCall(*propAccess->object);
+    }
+    return false;
+}
+
+const char* binaryFunction(const std::string& op) {
+    if (op == "+") return "addValues";
+    if (op == "-") return "subtractValues";
+    if (op == "*") return "multiplyValues";
+    if (op == "/") return "divideValues";
+    if (op == "==") return "equalValues";
+    if (op == "!=") return "notEqualValues";
+    if (op == "<") return "lessValues";
+    if (op == ">") return "greaterValues";
+    if (op == "<=") return "lessEqualValues";
+    if (op == ">=") return "greaterEqualValues";
+    if (op == "and") return "andValues";
+    if (op == "or") return "orValues";
+    return nullptr;
+}
+
+} // namespace
+
+std::string CppEmitter::newTemp() {
+    return "t" + std::to_string(tempCount++);
+}
+
+// Пул констант: литералы создаются один раз при старте программы
+std::string CppEmitter::numberConstant(double value) {
+    char literal[64];
+    std::snprintf(literal, sizeof(literal), "%.17g", value);
+    std::string text = literal;
+    if (text.find_first_of(".en") == std::string::npos) {
+        text += ".0";
+    }
+
+    std::string key = "n" + text;
+    auto it = constantNames.find(key);
+    if (it != constantNames.end()) return it->second;
+
+    std::string name = "k" + std::to_string(constants.size());
+    constants.push_back("static const Value " + name + "(" + text + ");");
+    constantNames[key] = name;
+    return name;
+}
+
+std::string CppEmitter::stringConstant(const std::string& value) {
+    std::string key = "s" + value;
+    auto it = constantNames.find(key);
+    if (it != constantNames.end()) return it->second;
+
+    std::string name = "k" + std::to_string(constants.size());
+    constants.push_back("static const Value " + name + "(std::string(" + quote(value) + "));");
+    constantNames[key] = name;
+    return name;
+}
+
+// Номера имён тоже получаются один раз при старте программы
+std::string CppEmitter::symbolConstant(const std::string& name) {
+    std::string key = "y" + name;
+    auto it = constantNames.find(key);
+    if (it != constantNames.end()) return it->second;
+
+    std::string constant = "y" + std::to_string(constants.size());
+    constants.push_back("static const Symbol " + constant + " = intern(" + quote(name) + ");");
+    constantNames[key] = constant;
+    return constant;
+}
+
+std::string CppEmitter::booleanConstant(bool value) {
+    std::string key = value ? "btrue" : "bfalse";
+    auto it = constantNames.find(key);
+    if (it != constantNames.end()) return it->second;
+
+    std::string name = "k" + std::to_string(constants.size());
+    constants.push_back("static const Value " + name + "(" + (value ? "true" : "false") + ");");
+    constantNames[key] = name;
+    return name;
+}
+
+std::string CppEmitter::emitFunction(const FunctionDeclaration& decl) {
+    if (decl.isAsync) {
+        throw std::runtime_error("async functions are not supported by --emit-cpp");
+    }
+    if (decl.isGenerator) {
+        throw std::runtime_error("generator functions are not supported by --emit-cpp");
+    }
+    std::string name = "fn" + std::to_string(functionCount++) + "_" + sanitize(decl.functionName);
+
+    std::string parameters;
+    for (size_t i = 0; i < decl.parameters.size(); i++) {
+        if (i > 0) parameters += ", ";
+        parameters += "intern(" + quote(decl.parameters[i]) + ")";
+    }
+    declarations.push_back("static Value " + name + "(const std::shared_ptr<Environment>& env);");
+    declarations.push_back("static const std::vector<Symbol> " + name + "_params = {" + parameters + "};");
+    // Чистота нужна parallelMap: нечистый колбэк отвергается во всех режимах
+    declarations.push_back("static const std::shared_ptr<Block> " + name + "_body = registerCompiledFunction(" + name +
+                           (decl.isPure ? ", true" : "") + ");");
+
+    // Вложенные объявления компилируются в отдельные функции C++
+    int savedTempCount = tempCount;
+    bool savedInsideFunction = insideFunction;
+    tempCount = 0;
+    insideFunction = true;
+
+    std::ostringstream out;
+    out << "// fun " << decl.functionName << "(";
+    for (size_t i = 0; i < decl.parameters.size(); i++) {
+        out << (i > 0 ? ", " : "") << decl.parameters[i];
+    }
+    out << ")\n";
+    out << "static Value " << name << "(const std::shared_ptr<Environment>& env) {\n";
+    for (const auto& stmt : decl.body->statements) {
+        emitStatement(*stmt, out, 1);
+    }
+    out << "    return Value();\n}\n";
+    definitions.push_back(out.str());
+
+    tempCount = savedTempCount;
+    insideFunction = savedInsideFunction;
+    return name;
+}
+
+std::string CppEmitter::emitCallArguments(const std::vector<std::unique_ptr<Expression>>& arguments,
+                                          std::ostringstream& out, int indent) {
+    std::vector<std::string> values;
+    for (size_t i = 0; i < arguments.size(); i++) {
+        bool laterCalls = false;
+        for (size_t j = i + 1; j < arguments.size(); j++) {
+            laterCalls = laterCalls || hasCall(*arguments[j]);
+        }
+        values.push_back(emitExpression(*arguments[i], out, indent, !laterCalls));
+    }
+
+    std::string list = "{";
+    for (size_t i = 0; i < values.size(); i++) {
+        if (i > 0) list += ", ";
+        list += values[i];
+    }
+    return list + "}";
+}
+
+std::string CppEmitter::emitExpression(const Expression& expr, std::ostringstream& out, int indent, bool mayReference) {
+    std::string pad = padding(indent);
+
+    if (auto num = dynamic_cast<const NumberLiteral*>(&expr)) {
+        return numberConstant(num->value);
+    }
+    else if (auto str = dynamic_cast<const StringLiteral*>(&expr)) {
+        return stringConstant(*str->value);
+    }
+    else if (auto boolean = dynamic_cast<const BooleanLiteral*>(&expr)) {
+        return booleanConstant(boolean->value);
+    }
+    else if (auto id = dynamic_cast<const Identifier*>(&expr)) {
+        // Ссылка на элемент окружения переживает вставки (узлы unordered_map не перемещаются)
+        std::string temp = newTemp();
+        out << pad << (mayReference ? "const Value& " : "Value ") << temp
+            << " = env->get(" << symbolConstant(id->name) << ");\n";
+        return temp;
+    }
+    else if (auto binOp = dynamic_cast<const BinaryOperation*>(&expr)) {
+        std::string left = emitExpression(*binOp->left, out, indent, !hasCall(*binOp->right));
+        std::string right = emitExpression(*binOp->right, out, indent, true);
+        std::string temp = newTemp();
+        if (const char* function = binaryFunction(binOp->op)) {
+            out << pad << "Value " << temp << " = " << function << "(" << left << ", " << right << ");\n";
+        } else {
+            out << pad << "Value " << temp << " = binaryOperation(" << quote(binOp->op) << ", "
+                << left << ", " << right << ");\n";
+        }
+        return temp;
+    }
+    else if (auto unOp = dynamic_cast<const UnaryOperation*>(&expr)) {
+        std::string operand = emitExpression(*unOp->operand, out, indent, true);
+        std::string temp = newTemp();
+        if (unOp->op == "not") {
+            out << pad << "Value " << temp << "(!" << operand << ".booleanValue);\n";
+        } else if (unOp->op == "-") {
+            out << pad << "Value " << temp << " = negateValue(" << operand << ");\n";
+        } else {
+            out << pad << "Value " << temp << " = unaryOperation(" << quote(unOp->op) << ", " << operand << ");\n";
+        }
+        return temp;
+    }
+    else if (auto call = dynamic_cast<const FunctionCall*>(&expr)) {
+        if (call->functionName == "print") {
+            for (const auto& arg : call->arguments) {
+                std::string value = emitExpression(*arg, out, indent, true);
+                out << pad << "std::cout << " << value << " << \" \";\n";
+            }
+            out << pad << "std::cout << '\\n';\n";
+            return "Value()";
+        }
+
+        std::string function = newTemp();
+        out << pad << "Value " << function << " = lookupFunction(*env, " << symbolConstant(call->functionName)
+            << ", " << call->arguments.size() << ");\n";
+        std::string arguments = emitCallArguments(call->arguments, out, indent);
+        std::string temp = newTemp();
+        out << pad << "Value " << temp << " = callCompiledFunction(env, " << function << ", " << arguments << ");\n";
+        return temp;
+    }
+    else if (auto methodCall = dynamic_cast<const MethodCall*>(&expr)) {
+        // Переменная-получатель берётся ссылкой после аргументов: push и pop меняют её
+        auto id = dynamic_cast<const Identifier*>(methodCall->object.get());
+        std::string receiver = newTemp();
+        if (!id) {
+            std::string object = emitExpression(*methodCall->object, out, indent, false);
+            out << pad << "Value " << receiver << " = " << object << ";\n";
+        }
+        std::string values = emitCallArguments(methodCall->arguments, out, indent);
+        std::string arguments = newTemp();
+        out << pad << "std::vector<Value> " << arguments << " = " << values << ";\n";
+        if (id) {
+            out << pad << "Value& " << receiver << " = env->get(" << symbolConstant(id->name) << ");\n";
+        }
+        std::string caller = newTemp();
+        std::string temp = newTemp();
+        out << pad << "CompiledFunctionCaller " << caller << "(env);\n";
+        out << pad << "Value " << temp << " = callArrayMethod(" << receiver << ", "
+            << symbolConstant(methodCall->method) << ", " << arguments << ".data(), "
+            << arguments << ".size(), " << caller << ");\n";
+        return temp;
+    }
+    else if (auto array = dynamic_cast<const ArrayLiteral*>(&expr)) {
+        std::string elements = emitCallArguments(array->elements, out, indent);
+        std::string temp = newTemp();
+        out << pad << "Value " << temp << "(std::vector<Value>" << elements << ");\n";
+        return temp;
+    }
+    else if (auto object = dynamic_cast<const ObjectLiteral*>(&expr)) {
+        std::string properties = newTemp();
+        out << pad << "std::unordered_map<Symbol, Value> " << properties << ";\n";
+        for (const auto& [key, value] : object->properties) {
+            std::string element = emitExpression(*value, out, indent, true);
+            out << pad << properties << "[" << symbolConstant(key) << "] = " << element << ";\n";
+        }
+        std::string temp = newTemp();
+        out << pad << "Value " << temp << "(" << properties << ");\n";
+        return temp;
+    }
+    else if (auto indexExpr = dynamic_cast<const IndexExpression*>(&expr)) {
+        std::string object = emitExpression(*indexExpr->object, out, indent, !hasCall(*indexExpr->index));
+        std::string index = emitExpression(*indexExpr->index, out, indent, true);
+        std::string temp = newTemp();
+        out << pad << "Value " << temp << " = indexValue(" << object << ", " << index << ");\n";
+        return temp;
+    }
+    else if (auto propAccess = dynamic_cast<const PropertyAccess*>(&expr)) {
+        std::string object = emitExpression(*propAccess->object, out, indent, true);
+        std::string temp = newTemp();
+        out << pad << "Value " << temp << " = propertyValue(" << object << ", "
+            << symbolConstant(propAccess->property) << ");\n";
+        return temp;
+    }
+    else if (dynamic_cast<const AwaitExpression*>(&expr)) {
+        throw std::runtime_error("await is not supported by --emit-cpp");
+    }
+
+    return "Value()";
+}
+
+void CppEmitter::emitBlock(const Block& block, std::ostringstream& out, int indent) {
+    // Блок не создаёт области видимости языка — только область C++ для временных
+    for (const auto& stmt : block.statements) {
+        emitStatement(*stmt, out, indent);
+    }
+}
+
+void CppEmitter::emitStatement(const Statement& stmt, std::ostringstream& out, int indent) {
+    std::string pad = padding(indent);
+
+    if (auto varDecl = dynamic_cast<const VariableDeclaration*>(&stmt)) {
+        std::string value = varDecl->initializer
+            ? emitExpression(*varDecl->initializer, out, indent, true) : "Value()";
+        out << pad << "env->define(" << symbolConstant(varDecl->variableName) << ", " << value << ");\n";
+    }
+    else if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
+        // Как и интерпретатор, присваивание элементу перезаписывает саму переменную
+        std::string value = emitExpression(*assignment->value, out, indent, true);
+        out << pad << "env->set(" << symbolConstant(assignment->variableName) << ", " << value << ");\n";
+    }
+    else if (auto ifStmt = dynamic_cast<const IfStatement*>(&stmt)) {
+        std::string condition = emitExpression(*ifStmt->condition, out, indent, true);
+        out << pad << "if (" << condition << ".booleanValue) {\n";
+        emitBlock(*ifStmt->thenBlock, out, indent + 1);
+        if (ifStmt->elseBlock) {
+            out << pad << "} else {\n";
+            emitBlock(*ifStmt->elseBlock, out, indent + 1);
+        }
+        out << pad << "}\n";
+    }
+    else if (auto whileStmt = dynamic_cast<const WhileStatement*>(&stmt)) {
+        out << pad << "while (true) {\n";
+        std::string condition = emitExpression(*whileStmt->condition, out, indent + 1, true);
+        out << pad << "    if (!" << condition << ".booleanValue) break;\n";
+        emitBlock(*whileStmt->body, out, indent + 1);
+        out << pad << "}\n";
+    }
+    else if (auto printStmt = dynamic_cast<const PrintStatement*>(&stmt)) {
+        std::string value = emitExpression(*printStmt->expression, out, indent, true);
+        out << pad << "std::cout << " << value << " << '\\n';\n";
+    }
+    else if (auto returnStmt = dynamic_cast<const ReturnStatement*>(&stmt)) {
+        std::string value = returnStmt->value
+            ? emitExpression(*returnStmt->value, out, indent, true) : "Value()";
+        if (insideFunction) {
+            out << pad << "return " << value << ";\n";
+        } else {
+            out << pad << "(void)" << value << ";\n";
+            out << pad << "throw ReturnOutsideFunction();\n";
+        }
+    }
+    else if (auto funcDecl = dynamic_cast<const FunctionDeclaration*>(&stmt)) {
+        std::string function = emitFunction(*funcDecl);
+        out << pad << "env->define(" << symbolConstant(funcDecl->functionName) << ", Value("
+            << function << "_params, " << function << "_body));\n";
+    }
+    else if (auto block = dynamic_cast<const Block*>(&stmt)) {
+        out << pad << "{\n";
+        emitBlock(*block, out, indent + 1);
+        out << pad << "}\n";
+    }
+    else if (auto exprStmt = dynamic_cast<const ExpressionStatement*>(&stmt)) {
+        std::string value = emitExpression(*exprStmt->expression, out, indent, true);
+        out << pad << "(void)" << value << ";\n";
+    }
+    else if (auto forStmt = dynamic_cast<const ForStatement*>(&stmt)) {
+        out << pad << "{\n";
+        if (forStmt->initializer) {
+            emitStatement(*forStmt->initializer, out, indent + 1);
+        }
+        out << pad << "    while (true) {\n";
+        if (forStmt->condition) {
+            std::string condition = emitExpression(*forStmt->condition, out, indent + 2, true);
+            out << pad << "        if (!" << condition << ".booleanValue) break;\n";
+        }
+        emitBlock(*forStmt->body, out, indent + 2);
+        if (forStmt->increment) {
+            std::string increment = emitExpression(*forStmt->increment, out, indent + 2, true);
+            out << pad << "        (void)" << increment << ";\n";
+        }
+        out << pad << "    }\n";
+        out << pad << "}\n";
+    }
+    else if (dynamic_cast<const YieldStatement*>(&stmt) || dynamic_cast<const ForInStatement*>(&stmt)) {
+        throw std::runtime_error("yield and for..in are not supported by --emit-cpp");
+    }
+}
+
+std::string CppEmitter::emit(const Program& program, const std::string& sourceName, size_t maxCallDepth) {
+    std::ostringstream body;
+    body << "static void runProgram(const std::shared_ptr<Environment>& env) {\n";
+    for (const auto& stmt : program.statements) {
+        emitStatement(*stmt, body, 1);
+    }
+    body << "}\n";
+
+    std::ostringstream out;
+    out << "// Сгенерировано: interpreter --emit-cpp " << sourceName << "\n";
+    out << "// Сборка: c++ -std=c++17 -O2 -I <interpreter/src> <файл>.cpp <libinterpreter_runtime.a> -pthread\n";
+    out << "#include \"runtime.h\"\n";
+    out << "#include <iostream>\n\n";
+
+    for (const auto& line : declarations) {
+        out << line << "\n";
+    }
+    if (!declarations.empty()) out << "\n";
+
+    for (const auto& line : constants) {
+        out << line << "\n";
+    }
+    if (!constants.empty()) out << "\n";
+
+    for (const auto& definition : definitions) {
+        out << definition << "\n";
+    }
+
+    out << body.str() << "\n";
+    out << "int main() {\n";
+    out << "    return runCompiledProgram(runProgram, " << maxCallDepth << ");\n";
+    out << "}\n";
+    return out.str();
+}
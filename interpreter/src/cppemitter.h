@@ -0,0 +1,44 @@
+#ifndef CPPEMITTER_H
+#define CPPEMITTER_H
+
+#include "ast.h"
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Ahead-of-time компиляция: Program -> исходный текст C++ поверх runtime.h.
+// Порождённый код сохраняет семантику интерпретатора (динамическая область
+// видимости, копирование значений, порядок вычислений и тексты ошибок),
+// но обходится без обхода AST и без исключений для return.
+class CppEmitter {
+private:
+    std::vector<std::string> declarations; // Прототипы и тела-метки функций
+    std::vector<std::string> definitions;  // Тела функций
+    std::vector<std::string> constants;
+    std::unordered_map<std::string, std::string> constantNames;
+    int functionCount = 0;
+    int tempCount = 0;
+    bool insideFunction = false;
+
+    std::string newTemp();
+    std::string numberConstant(double value);
+    std::string stringConstant(const std::string& value);
+    std::string booleanConstant(bool value);
+    std::string symbolConstant(const std::string& name);
+    std::string emitFunction(const FunctionDeclaration& decl);
+
+    // Возвращает имя значения; mayReference — значение используется до того,
+    // как что-либо успеет изменить переменные, и его можно не копировать
+    std::string emitExpression(const Expression& expr, std::ostringstream& out, int indent, bool mayReference);
+    std::string emitCallArguments(const std::vector<std::unique_ptr<Expression>>& arguments,
+                                  std::ostringstream& out, int indent);
+    void emitStatement(const Statement& stmt, std::ostringstream& out, int indent);
+    void emitBlock(const Block& block, std::ostringstream& out, int indent);
+
+public:
+    // maxCallDepth — предел глубины вызовов порождённой программы (--max-depth)
+    std::string emit(const Program& program, const std::string& sourceName, size_t maxCallDepth);
+};
+
+#endif // CPPEMITTER_H
@@ -1,33 +1,76 @@
 #include "environment.h"
 #include "ast.h" // Теперь подключаем здесь, где Value уже объявлен
+#include "array.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
 #include <stdexcept>
-#include <sstream>
 
 // Value implementations
-Value::Value() : type(NIL), numberValue(0), booleanValue(false), 
+Value::Value() : type(NIL), booleanValue(false), numberValue(0),
                 arrayValue(nullptr), objectValue(nullptr) {}
 
-Value::Value(double value) : type(NUMBER), numberValue(value), booleanValue(false),
+Value::Value(double value) : type(NUMBER), booleanValue(false), numberValue(value),
                            arrayValue(nullptr), objectValue(nullptr) {}
 
-Value::Value(const std::string& value) : type(STRING), stringValue(value), booleanValue(false),
+Value::Value(const std::string& value) : type(STRING), booleanValue(false), numberValue(0),
+                                       stringStorage(std::make_shared<const std::string>(value)),
                                        arrayValue(nullptr), objectValue(nullptr) {}
 
+Value::Value(std::string&& value) : type(STRING), booleanValue(false), numberValue(0),
+                                  stringStorage(std::make_shared<const std::string>(std::move(value))) {}
+
 Value::Value(bool value) : type(BOOLEAN), booleanValue(value), numberValue(0),
                          arrayValue(nullptr), objectValue(nullptr) {}
 
-Value::Value(const std::vector<std::string>& params, std::shared_ptr<Block> body)
-    : type(FUNCTION), parameters(params), body(body), numberValue(0), booleanValue(false),
+Value::Value(const std::vector<Symbol>& params, std::shared_ptr<Block> body)
+    : type(FUNCTION), booleanValue(false), numberValue(0), parameters(params), body(body),
       arrayValue(nullptr), objectValue(nullptr) {}
 
 Value::Value(const std::vector<Value>& array) 
-    : type(ARRAY), numberValue(0), booleanValue(false), objectValue(nullptr) {
-    arrayValue = std::make_unique<std::vector<Value>>(array);
+    : type(ARRAY), booleanValue(false), numberValue(0), objectValue(nullptr) {
+    auto storage = std::make_shared<ArrayStorage>();
+    storage->reserve(array.size());
+    for (const Value& element : array) {
+        storage->push(element);
+    }
+    arrayValue = std::move(storage);
+}
+
+Value::Value(std::vector<Value>&& array)
+    : type(ARRAY), booleanValue(false), numberValue(0), objectValue(nullptr) {
+    auto storage = std::make_shared<ArrayStorage>();
+    storage->reserve(array.size());
+    for (Value& element : array) {
+        storage->push(std::move(element));
+    }
+    arrayValue = std::move(storage);
+}
+
+Value::Value(const std::unordered_map<Symbol, Value>& object)
+    : type(OBJECT), booleanValue(false), numberValue(0), arrayValue(nullptr) {
+    objectValue = std::make_unique<std::unordered_map<Symbol, Value>>(object);
+}
+
+Value Value::string(StringStorage storage) {
+    Value result;
+    result.type = STRING;
+    result.stringStorage = std::move(storage);
+    return result;
+}
+
+Value Value::native(std::shared_ptr<const NativeFunction> function) {
+    Value result;
+    result.type = NATIVE;
+    result.nativeFunction = std::move(function);
+    return result;
 }
 
-Value::Value(const std::unordered_map<std::string, Value>& object)
-    : type(OBJECT), numberValue(0), booleanValue(false), arrayValue(nullptr) {
-    objectValue = std::make_unique<std::unordered_map<std::string, Value>>(object);
+Value Value::host(Type type, std::shared_ptr<HostObject> object) {
+    Value result;
+    result.type = type;
+    result.hostObject = std::move(object);
+    return result;
 }
 
 // Rule of Five implementations
@@ -35,26 +78,28 @@ Value::~Value() = default;
 
 Value::Value(const Value& other)
     : type(other.type),
-      numberValue(other.numberValue),
-      stringValue(other.stringValue),
       booleanValue(other.booleanValue),
+      numberValue(other.numberValue),
+      stringStorage(other.stringStorage),
       parameters(other.parameters),
-      body(other.body) {
-    if (other.arrayValue) {
-        arrayValue = std::make_unique<std::vector<Value>>(*other.arrayValue);
-    }
+      body(other.body),
+      nativeFunction(other.nativeFunction),
+      hostObject(other.hostObject),
+      arrayValue(other.arrayValue) {
     if (other.objectValue) {
-        objectValue = std::make_unique<std::unordered_map<std::string, Value>>(*other.objectValue);
+        objectValue = std::make_unique<std::unordered_map<Symbol, Value>>(*other.objectValue);
     }
 }
 
 Value::Value(Value&& other) noexcept
     : type(other.type),
-      numberValue(other.numberValue),
-      stringValue(std::move(other.stringValue)),
       booleanValue(other.booleanValue),
+      numberValue(other.numberValue),
+      stringStorage(std::move(other.stringStorage)),
       parameters(std::move(other.parameters)),
       body(std::move(other.body)),
+      nativeFunction(std::move(other.nativeFunction)),
+      hostObject(std::move(other.hostObject)),
       arrayValue(std::move(other.arrayValue)),
       objectValue(std::move(other.objectValue)) {
     other.type = NIL;
@@ -66,19 +111,17 @@ Value& Value::operator=(const Value& other) {
     if (this != &other) {
         type = other.type;
         numberValue = other.numberValue;
-        stringValue = other.stringValue;
+        stringStorage = other.stringStorage;
         booleanValue = other.booleanValue;
         parameters = other.parameters;
         body = other.body;
+        nativeFunction = other.nativeFunction;
+        hostObject = other.hostObject;
         
-        if (other.arrayValue) {
-            arrayValue = std::make_unique<std::vector<Value>>(*other.arrayValue);
-        } else {
-            arrayValue.reset();
-        }
+        arrayValue = other.arrayValue;
         
         if (other.objectValue) {
-            objectValue = std::make_unique<std::unordered_map<std::string, Value>>(*other.objectValue);
+            objectValue = std::make_unique<std::unordered_map<Symbol, Value>>(*other.objectValue);
         } else {
             objectValue.reset();
         }
@@ -90,10 +133,12 @@ Value& Value::operator=(Value&& other) noexcept {
     if (this != &other) {
         type = other.type;
         numberValue = other.numberValue;
-        stringValue = std::move(other.stringValue);
+        stringStorage = std::move(other.stringStorage);
         booleanValue = other.booleanValue;
         parameters = std::move(other.parameters);
         body = std::move(other.body);
+        nativeFunction = std::move(other.nativeFunction);
+        hostObject = std::move(other.hostObject);
         arrayValue = std::move(other.arrayValue);
         objectValue = std::move(other.objectValue);
         
@@ -104,23 +149,60 @@ Value& Value::operator=(Value&& other) noexcept {
     return *this;
 }
 
+// Как std::ostream << double с настройками по умолчанию (%g, точность 6),
+// но без ostringstream и выделения памяти
+static const size_t NUMBER_BUFFER_SIZE = 32;
+
+static void formatNumber(double value, char* buffer) {
+    std::snprintf(buffer, NUMBER_BUFFER_SIZE, "%g", value);
+}
+
+ArrayStorage& Value::mutableArray() {
+    if (arrayValue.use_count() != 1) {
+        arrayValue = std::make_shared<ArrayStorage>(*arrayValue);
+    } else {
+        // use_count читается без упорядочивания, а хранилище могло прийти из
+        // другого потока (сообщение воркера, часть parallelMap). Барьер
+        // синхронизируется с освобождением чужих ссылок: их чтения хранилища
+        // закончились раньше, чем мы начнём его менять.
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    // Хранилище создано неконстантным, const только защищает общие копии
+    return const_cast<ArrayStorage&>(*arrayValue);
+}
+
+const std::string& Value::stringValue() const {
+    static const std::string empty;
+    return stringStorage ? *stringStorage : empty;
+}
+
 std::string Value::toString() const {
     switch (type) {
         case NUMBER: {
-            std::ostringstream oss;
-            oss << numberValue;
-            return oss.str();
+            char buffer[NUMBER_BUFFER_SIZE];
+            formatNumber(numberValue, buffer);
+            return buffer;
         }
-        case STRING: return stringValue;
+        case STRING: return stringValue();
         case BOOLEAN: return booleanValue ? "true" : "false";
-        case FUNCTION: return "<function>";
+        case FUNCTION:
+        case NATIVE: return "<function>";
+        case PROMISE: return "<promise>";
+        case GENERATOR: return "<generator>";
+        case WORKER: return "<worker>";
         case NIL: return "null";
         case ARRAY: {
             if (!arrayValue) return "[]";
             std::string result = "[";
             for (size_t i = 0; i < arrayValue->size(); i++) {
                 if (i > 0) result += ", ";
-                result += (*arrayValue)[i].toString();
+                if (arrayValue->kind() == ArrayStorage::PACKED_DOUBLE) {
+                    char buffer[NUMBER_BUFFER_SIZE];
+                    formatNumber(arrayValue->numbers()[i], buffer);
+                    result += buffer;
+                } else {
+                    result += arrayValue->elements()[i].toString();
+                }
             }
             return result + "]";
         }
@@ -130,7 +212,7 @@ std::string Value::toString() const {
             bool first = true;
             for (const auto& [key, value] : *objectValue) {
                 if (!first) result += ", ";
-                result += key + ": " + value.toString();
+                result += symbolName(key) + ": " + value.toString();
                 first = false;
             }
             return result + "}";
@@ -139,28 +221,54 @@ std::string Value::toString() const {
     }
 }
 
+std::ostream& operator<<(std::ostream& os, const Value& value) {
+    if (value.type == Value::STRING) {
+        return os << value.stringValue();
+    }
+    if (value.type == Value::NUMBER) {
+        char buffer[NUMBER_BUFFER_SIZE];
+        formatNumber(value.numberValue, buffer);
+        return os << buffer;
+    }
+    return os << value.toString();
+}
+
+bool numbersEqual(double a, double b) {
+    if (a == b && a != 0) return true;
+    // Целые до 1e6 печатаются точно, строки совпадают только при равенстве
+    if (std::fabs(a) < 1e6 && std::fabs(b) < 1e6 && a == std::trunc(a) && b == std::trunc(b)) {
+        return a == b && std::signbit(a) == std::signbit(b);
+    }
+    return Value(a).toString() == Value(b).toString();
+}
+
 // Environment implementations (остаются без изменений)
 Environment::Environment() : parent(nullptr) {}
 Environment::Environment(std::shared_ptr<Environment> parent) : parent(parent) {}
 
-void Environment::define(const std::string& name, const Value& value) {
+void Environment::define(Symbol name, const Value& value) {
     variables[name] = value;
 }
 
-Value& Environment::get(const std::string& name) {
-    auto it = variables.find(name);
-    if (it != variables.end()) {
-        return it->second;
+Value& Environment::get(Symbol name) {
+    Value* value = find(name);
+    if (!value) {
+        throw std::runtime_error("Undefined variable: " + symbolName(name));
     }
-    
-    if (parent) {
-        return parent->get(name);
+    return *value;
+}
+
+Value* Environment::find(Symbol name) {
+    for (Environment* env = this; env; env = env->parent.get()) {
+        auto it = env->variables.find(name);
+        if (it != env->variables.end()) {
+            return &it->second;
+        }
     }
-    
-    throw std::runtime_error("Undefined variable: " + name);
+    return nullptr;
 }
 
-void Environment::set(const std::string& name, const Value& value) {
+void Environment::set(Symbol name, const Value& value) {
     auto it = variables.find(name);
     if (it != variables.end()) {
         it->second = value;
@@ -172,10 +280,10 @@ void Environment::set(const std::string& name, const Value& value) {
         return;
     }
     
-    throw std::runtime_error("Undefined variable: " + name);
+    throw std::runtime_error("Undefined variable: " + symbolName(name));
 }
 
-bool Environment::exists(const std::string& name) const {
+bool Environment::exists(Symbol name) const {
     if (variables.find(name) != variables.end()) {
         return true;
     }
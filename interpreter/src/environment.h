@@ -1,41 +1,79 @@
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
+#include <functional>
 #include <unordered_map>
 #include <string>
 #include <memory>
+#include <ostream>
 #include <vector>
 #include "ast.h"
 
 // Forward declarations
 class Block;
 class Expression;
+class ArrayStorage; // array.h
+class Value;
+class FunctionCaller; // runtime.h
+
+// Функция C++, доступная скриптам (Interpreter::registerNative). Аргументы
+// приходят подряд лежащими значениями, без окружения вызова; их ровно arity.
+using NativeCallback = std::function<Value(const Value* args, size_t count)>;
+// Встроенная функция высшего порядка (parallelMap): колбэки скрипта она
+// вызывает через исполнителя, который её вызвал
+using HigherOrderNative = Value (*)(const Value* args, FunctionCaller& caller);
+
+struct NativeFunction {
+    std::string name;
+    size_t arity;
+    NativeCallback function;
+    HigherOrderNative higherOrder = nullptr; // Задана — вызывается вместо function
+};
+
+// Объект среды исполнения, который скрипт видит как значение: обещание
+// async-функции (Promise, eventloop.h), генератор (interpreter.h) или воркер (worker.h).
+// Копии значения разделяют объект.
+class HostObject {
+public:
+    virtual ~HostObject() = default;
+};
 
 class Value {
 public:
-    enum Type { NUMBER, STRING, BOOLEAN, FUNCTION, NIL, ARRAY, OBJECT };
+    enum Type { NUMBER, STRING, BOOLEAN, FUNCTION, NIL, ARRAY, OBJECT, NATIVE, PROMISE, GENERATOR, WORKER };
     
     Type type;
-    double numberValue;
-    std::string stringValue;
     bool booleanValue;
+    double numberValue;
+    StringStorage stringStorage; // Символы строки; общие у всех копий значения
     
     // Для функций - используем shared_ptr вместо unique_ptr
-    std::vector<std::string> parameters;
+    std::vector<Symbol> parameters;
     std::shared_ptr<Block> body;
+    // Для родных функций: общее описание, копия значения его не копирует
+    std::shared_ptr<const NativeFunction> nativeFunction;
+    // Для PROMISE, GENERATOR и WORKER
+    std::shared_ptr<HostObject> hostObject;
     
-    // Для массивов и объектов
-    std::unique_ptr<std::vector<Value>> arrayValue;
-    std::unique_ptr<std::unordered_map<std::string, Value>> objectValue;
+    // Для массивов и объектов. Элементы массива общие у копий значения,
+    // пока одна из них не изменится (копирование при записи, mutableArray)
+    std::shared_ptr<const ArrayStorage> arrayValue;
+    std::unique_ptr<std::unordered_map<Symbol, Value>> objectValue;
 
     // Конструкторы
     Value();
     Value(double value);
     Value(const std::string& value);
+    Value(std::string&& value);
+    // Строка из готового хранилища (литерал) — без копирования символов
+    static Value string(StringStorage storage);
     Value(bool value);
-    Value(const std::vector<std::string>& params, std::shared_ptr<Block> body);
+    Value(const std::vector<Symbol>& params, std::shared_ptr<Block> body);
     Value(const std::vector<Value>& array); // НОВЫЙ
-    Value(const std::unordered_map<std::string, Value>& object); // НОВЫЙ
+    Value(std::vector<Value>&& array);
+    Value(const std::unordered_map<Symbol, Value>& object); // НОВЫЙ
+    static Value native(std::shared_ptr<const NativeFunction> function);
+    static Value host(Type type, std::shared_ptr<HostObject> object);
     
     // Правило пяти (Rule of Five)
     ~Value();
@@ -44,21 +82,38 @@ public:
     Value& operator=(const Value& other);
     Value& operator=(Value&& other) noexcept;
 
+    // Функция скрипта или родная: её можно вызвать с arity() аргументами
+    bool isCallable() const { return type == FUNCTION || type == NATIVE; }
+    size_t arity() const { return type == NATIVE ? nativeFunction->arity : parameters.size(); }
+
+    // Элементы массива для изменения: общие сначала копируются
+    ArrayStorage& mutableArray();
+
+    // Символы строки; у значений других типов — пустая строка
+    const std::string& stringValue() const;
     std::string toString() const;
 };
 
+// Печать без промежуточной копии строкового значения
+std::ostream& operator<<(std::ostream& os, const Value& value);
+
+// Сравнение чисел с той же семантикой, что и toString() == toString()
+bool numbersEqual(double a, double b);
+
 class Environment {
 public:
-    std::unordered_map<std::string, Value> variables;
+    std::unordered_map<Symbol, Value> variables;
     std::shared_ptr<Environment> parent;
     
     Environment();
     Environment(std::shared_ptr<Environment> parent);
     
-    void define(const std::string& name, const Value& value);
-    Value& get(const std::string& name);
-    void set(const std::string& name, const Value& value);
-    bool exists(const std::string& name) const;
+    void define(Symbol name, const Value& value);
+    Value& get(Symbol name);
+    // Как get, но nullptr вместо ошибки для неопределённого имени
+    Value* find(Symbol name);
+    void set(Symbol name, const Value& value);
+    bool exists(Symbol name) const;
 };
 
 #endif // ENVIRONMENT_H
\ No newline at end of file
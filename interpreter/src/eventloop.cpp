@@ -0,0 +1,210 @@
+#include "eventloop.h"
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+EventLoop::EventLoop() {
+#if defined(__linux__)
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd >= 0 && timerFd >= 0 && wakeFd >= 0) {
+        for (int fd : {timerFd, wakeFd}) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+#endif
+}
+
+EventLoop::~EventLoop() {
+#if defined(__linux__)
+    if (timerFd >= 0) close(timerFd);
+    if (wakeFd >= 0) close(wakeFd);
+    if (epollFd >= 0) close(epollFd);
+#endif
+}
+
+void EventLoop::post(Task task) {
+    ready.push_back(std::move(task));
+}
+
+long long EventLoop::addTimer(double delay, bool interval, Task callback) {
+    auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(delay > 0 ? delay : 0));
+    long long id = nextTimerId++;
+    Timer timer{Clock::now() + period, interval ? period : Clock::duration::zero(), std::move(callback)};
+    // Интервал 0 превратил бы цикл в бесконечный без единого ожидания
+    if (interval && timer.interval == Clock::duration::zero()) {
+        timer.interval = std::chrono::milliseconds(1);
+    }
+    schedule.emplace(timer.deadline, id);
+    timers.emplace(id, std::move(timer));
+    return id;
+}
+
+void EventLoop::cancelTimer(long long id) {
+    auto it = timers.find(id);
+    if (it == timers.end()) return;
+    schedule.erase({it->second.deadline, id});
+    timers.erase(it);
+}
+
+int EventLoop::addSource(Source source) {
+    int id = nextSourceId++;
+    sources.emplace(id, std::move(source));
+    return id;
+}
+
+void EventLoop::removeSource(int id) {
+    sources.erase(id);
+}
+
+void EventLoop::wake() {
+#if defined(__linux__)
+    if (epollFd >= 0 && timerFd >= 0 && wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t bytes = write(wakeFd, &one, sizeof(one));
+        (void)bytes;
+        return;
+    }
+#endif
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    woken = true;
+    wakeCondition.notify_one();
+}
+
+void EventLoop::resolve(const std::shared_ptr<Promise>& promise, const Value& result) {
+    if (promise->state != Promise::PENDING) return;
+    promise->state = Promise::FULFILLED;
+    promise->result = result;
+    settle(promise);
+}
+
+void EventLoop::reject(const std::shared_ptr<Promise>& promise, const std::string& error) {
+    if (promise->state != Promise::PENDING) return;
+    promise->state = Promise::REJECTED;
+    promise->error = error;
+    settle(promise);
+}
+
+void EventLoop::settle(const std::shared_ptr<Promise>& promise) {
+    if (promise->state == Promise::REJECTED && !promise->handled) {
+        // Обещание могут дождаться позже; проверяется в takeUnhandledErrors
+        rejected.push_back(promise);
+    }
+    for (Task& reaction : promise->reactions) {
+        ready.push_back(std::move(reaction));
+    }
+    promise->reactions.clear();
+}
+
+void EventLoop::run(const std::function<bool()>& done) {
+    while (!(done && done())) {
+        if (!ready.empty()) {
+            Task task = std::move(ready.front());
+            ready.pop_front();
+            task();
+            continue;
+        }
+        bool waiting = pollSources();
+        if (!ready.empty()) continue;
+        if (schedule.empty()) {
+            if (!waiting) return;
+            wait(nullptr);
+            continue;
+        }
+
+        auto [deadline, id] = *schedule.begin();
+        if (deadline > Clock::now()) {
+            wait(&deadline);
+            continue;
+        }
+        schedule.erase(schedule.begin());
+        Timer& timer = timers.at(id);
+        Task callback = timer.callback;
+        if (timer.interval != Clock::duration::zero()) {
+            // Следующий срок — от прошлого, чтобы период не уплывал;
+            // отстав больше чем на период, отсчитываем от текущего момента
+            timer.deadline = std::max(timer.deadline + timer.interval, Clock::now());
+            schedule.emplace(timer.deadline, id);
+        } else {
+            timers.erase(id);
+        }
+        callback();
+    }
+}
+
+// Источник может удалить себя или другие, поэтому обходим снимок номеров
+bool EventLoop::pollSources() {
+    if (sources.empty()) return false;
+    std::vector<int> ids;
+    for (const auto& entry : sources) {
+        ids.push_back(entry.first);
+    }
+    bool waiting = false;
+    for (int id : ids) {
+        auto it = sources.find(id);
+        if (it != sources.end() && it->second()) {
+            waiting = true;
+        }
+    }
+    return waiting;
+}
+
+void EventLoop::clear() {
+    ready.clear();
+    sources.clear();
+    timers.clear();
+    schedule.clear();
+    rejected.clear();
+}
+
+std::vector<std::string> EventLoop::takeUnhandledErrors() {
+    std::vector<std::string> errors;
+    for (const auto& promise : rejected) {
+        if (!promise->handled) {
+            errors.push_back(promise->error);
+        }
+    }
+    rejected.clear();
+    return errors;
+}
+
+void EventLoop::wait(const Clock::time_point* deadline) {
+#if defined(__linux__)
+    if (epollFd >= 0 && timerFd >= 0 && wakeFd >= 0) {
+        itimerspec spec{};
+        if (deadline) {
+            auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline - Clock::now());
+            if (remaining.count() <= 0) return;
+            spec.it_value.tv_sec = static_cast<time_t>(remaining.count() / 1000000000);
+            spec.it_value.tv_nsec = static_cast<long>(remaining.count() % 1000000000);
+        }
+        // Нулевой it_value снимает таймер: ждём только wake
+        timerfd_settime(timerFd, 0, &spec, nullptr);
+        epoll_event events[2];
+        int count = epoll_wait(epollFd, events, 2, -1);
+        for (int i = 0; i < count; i++) {
+            uint64_t value;
+            ssize_t bytes = read(events[i].data.fd, &value, sizeof(value));
+            (void)bytes;
+        }
+        return;
+    }
+#endif
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    if (deadline) {
+        wakeCondition.wait_until(lock, *deadline, [this] { return woken; });
+    } else {
+        wakeCondition.wait(lock, [this] { return woken; });
+    }
+    woken = false;
+}
\ No newline at end of file
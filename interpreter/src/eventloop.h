@@ -0,0 +1,98 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include "environment.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Обещание: результат async-функции или sleep, который появится позже
+class Promise : public HostObject {
+public:
+    enum State { PENDING, FULFILLED, REJECTED };
+
+    State state = PENDING;
+    Value result;       // FULFILLED
+    std::string error;  // REJECTED: сообщение ошибки
+    bool handled = false; // Результат кто-то ждал (await)
+    // Продолжения ждущих; при завершении ставятся в очередь цикла
+    std::vector<std::function<void()>> reactions;
+};
+
+// Однопоточный цикл событий интерпретатора: очередь готовых задач
+// (продолжения после await), таймеры и внешние источники (сообщения
+// воркеров). Пока ждать нечего, поток спит: на Linux — в epoll на timerfd
+// и eventfd, иначе — на условной переменной. Разбудить его можно из
+// любого потока (wake).
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = std::function<void()>;
+    // Опрос источника: готовые события он ставит в очередь (post) и
+    // отвечает, ждать ли от него ещё событий. Вызывается в потоке цикла.
+    using Source = std::function<bool()>;
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Выполнить task после уже поставленных задач
+    void post(Task task);
+    // Таймер через delay мс; interval — повторять с тем же периодом. Номер — для cancelTimer
+    long long addTimer(double delay, bool interval, Task callback);
+    void cancelTimer(long long id);
+    int addSource(Source source);
+    void removeSource(int id);
+    // Из любого потока: источник получил события, цикл опросит источники снова
+    void wake();
+
+    void resolve(const std::shared_ptr<Promise>& promise, const Value& result);
+    void reject(const std::shared_ptr<Promise>& promise, const std::string& error);
+
+    // Выполнять задачи и таймеры, пока есть работа или пока done() не вернёт true
+    void run(const std::function<bool()>& done = nullptr);
+    // Забыть задачи, таймеры, источники и необработанные ошибки (Interpreter::reset)
+    void clear();
+    // Отклонённые обещания, которые никто не ждал; список очищается
+    std::vector<std::string> takeUnhandledErrors();
+
+private:
+    struct Timer {
+        Clock::time_point deadline;
+        Clock::duration interval; // Ноль — однократный
+        Task callback;
+    };
+
+    std::deque<Task> ready;
+    std::map<long long, Timer> timers;
+    // Порядок срабатывания: срок, затем номер (порядок создания)
+    std::set<std::pair<Clock::time_point, long long>> schedule;
+    long long nextTimerId = 1;
+    std::vector<std::shared_ptr<Promise>> rejected;
+    std::map<int, Source> sources;
+    int nextSourceId = 1;
+
+    int epollFd = -1;
+    int timerFd = -1;
+    int wakeFd = -1;
+    // Без epoll: wake поднимает флаг под мьютексом
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    bool woken = false;
+
+    void settle(const std::shared_ptr<Promise>& promise);
+    bool pollSources();
+    // deadline == nullptr — ждать только wake
+    void wait(const Clock::time_point* deadline);
+};
+
+#endif // EVENTLOOP_H
\ No newline at end of file
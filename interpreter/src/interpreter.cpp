@@ -1,5 +1,9 @@
 #include "interpreter.h"
+#include "snapshot.h"
+#include "runtime.h"
+#include "array.h"
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 
 // Класс для передачи значения return
@@ -9,18 +13,39 @@ public:
     ReturnValue(const Value& val) : value(val) {}
 };
 
-Interpreter::Interpreter() {
+// Сколько раз узел может откатиться к общему пути, прежде чем остаться общим
+const int MAX_DEOPTIMIZATIONS = 4;
+
+Interpreter::Interpreter()
+    : output(&std::cout), errorOutput(&std::cerr), memoCapacity(0), maxCallDepth(DEFAULT_MAX_CALL_DEPTH), callDepth(0) {
     globalEnv = std::make_shared<Environment>();
     currentEnv = globalEnv;
+    registerEventNatives();
+    registerWorkerNatives();
+}
+
+Interpreter::~Interpreter() {
+    stopWorkers();
+    cancelTasks();
 }
 
 void Interpreter::interpret(const Program& program) {
+    // Ошибка прерывает программу посреди вызовов; глубина отсчитывается заново
+    callDepth = 0;
+    // Планировщик (scheduler.h) выполняет программу на стеке сопрограммы
+    if (Coroutine* coroutine = Coroutine::current()) {
+        stackGuard.attachToStack(coroutine->stackLowest(), coroutine->stackSize());
+    } else {
+        stackGuard.attachToCurrentThread();
+    }
     try {
         for (const auto& stmt : program.statements) {
             executeStatement(*stmt);
         }
+        // Таймеры и async-функции, ждущие await, продолжаются после программы
+        runEventLoop();
     } catch (const std::exception& e) {
-        std::cerr << "Runtime error: " << e.what() << std::endl;
+        *errorOutput << "Runtime error: " << e.what() << std::endl;
     }
 }
 
@@ -29,167 +54,46 @@ Value Interpreter::evaluateExpression(const Expression& expr) {
         return Value(num->value);
     }
     else if (auto str = dynamic_cast<const StringLiteral*>(&expr)) {
-        return Value(str->value);
+        return Value::string(str->value);
     }
     else if (auto boolean = dynamic_cast<const BooleanLiteral*>(&expr)) {
         return Value(boolean->value);
     }
     else if (auto id = dynamic_cast<const Identifier*>(&expr)) {
-        return currentEnv->get(id->name);
+        return currentEnv->get(id->symbol);
     }
     else if (auto binOp = dynamic_cast<const BinaryOperation*>(&expr)) {
         Value left = evaluateExpression(*binOp->left);
         Value right = evaluateExpression(*binOp->right);
-        
-        if (binOp->op == "+") {
-            if (left.type == Value::NUMBER && right.type == Value::NUMBER) {
-                return Value(left.numberValue + right.numberValue);
-            } else if (left.type == Value::STRING || right.type == Value::STRING) {
-                return Value(left.toString() + right.toString());
-            }
-        }
-        else if (binOp->op == "-") {
-            return Value(left.numberValue - right.numberValue);
-        }
-        else if (binOp->op == "*") {
-            return Value(left.numberValue * right.numberValue);
-        }
-        else if (binOp->op == "/") {
-            if (right.numberValue == 0) {
-                throw std::runtime_error("Division by zero");
-            }
-            return Value(left.numberValue / right.numberValue);
-        }
-        else if (binOp->op == "==") {
-            return Value(left.toString() == right.toString());
-        }
-        else if (binOp->op == "!=") {
-            return Value(left.toString() != right.toString());
-        }
-        else if (binOp->op == "<") {
-            return Value(left.numberValue < right.numberValue);
-        }
-        else if (binOp->op == ">") {
-            return Value(left.numberValue > right.numberValue);
-        }
-        else if (binOp->op == "<=") {
-            return Value(left.numberValue <= right.numberValue);
-        }
-        else if (binOp->op == ">=") {
-            return Value(left.numberValue >= right.numberValue);
-        }
-        else if (binOp->op == "and") {
-            return Value(left.booleanValue && right.booleanValue);
-        }
-        else if (binOp->op == "or") {
-            return Value(left.booleanValue || right.booleanValue);
-        }
+        return evaluateBinaryOperation(*binOp, left, right);
     }
     else if (auto unOp = dynamic_cast<const UnaryOperation*>(&expr)) {
         Value operand = evaluateExpression(*unOp->operand);
-        
-        if (unOp->op == "not") {
-            return Value(!operand.booleanValue);
-        }
-        else if (unOp->op == "-") {
-            return Value(-operand.numberValue);
-        }
+        return unaryOperation(unOp->op, operand);
     }
     else if (auto call = dynamic_cast<const FunctionCall*>(&expr)) {
-        if (call->functionName == "print") {
-            for (const auto& arg : call->arguments) {
-                Value value = evaluateExpression(*arg);
-                std::cout << value.toString() << " ";
-            }
-            std::cout << std::endl;
-            return Value();
-        }
-        
-        Value func = currentEnv->get(call->functionName);
-        if (func.type != Value::FUNCTION) {
-            throw std::runtime_error("Not a function: " + call->functionName);
-        }
-        
-        if (call->arguments.size() != func.parameters.size()) {
-            throw std::runtime_error("Wrong number of arguments for function: " + call->functionName);
-        }
-        
-        auto funcEnv = std::make_shared<Environment>(currentEnv);
-        for (size_t i = 0; i < call->arguments.size(); i++) {
-            Value argValue = evaluateExpression(*call->arguments[i]);
-            funcEnv->define(func.parameters[i], argValue);
-        }
-        
-        auto oldEnv = currentEnv;
-        currentEnv = funcEnv;
-        
-        try {
-            executeBlock(*func.body, funcEnv);
-        } catch (const ReturnValue& returnValue) {
-            currentEnv = oldEnv;
-            return returnValue.value;
-        } catch (const ReturnStatement&) {
-            currentEnv = oldEnv;
-            return Value();
-        }
-        
-        currentEnv = oldEnv;
-        return Value();
+        return evaluateCall(*call);
     }
     else if (auto array = dynamic_cast<const ArrayLiteral*>(&expr)) {
-        std::vector<Value> elements;
-        for (const auto& element : array->elements) {
-            elements.push_back(evaluateExpression(*element));
-        }
-        // Теперь это работает, так как есть конструктор Value(const vector<Value>&)
-        return Value(elements);
+        return evaluateArrayLiteral(*array);
     } 
     else if (auto object = dynamic_cast<const ObjectLiteral*>(&expr)) {
-        std::unordered_map<std::string, Value> properties;
-        for (const auto& [key, value] : object->properties) {
-            properties[key] = evaluateExpression(*value);
-        }
-        // Теперь это работает, так как есть конструктор Value(const unordered_map<string, Value>&)
-        return Value(properties);
+        return evaluateObjectLiteral(*object);
     }     
     else if (auto indexExpr = dynamic_cast<const IndexExpression*>(&expr)) {
         Value objectVal = evaluateExpression(*indexExpr->object);
         Value indexVal = evaluateExpression(*indexExpr->index);
-        
-        if (objectVal.type == Value::ARRAY && indexVal.type == Value::NUMBER) {
-            int index = static_cast<int>(indexVal.numberValue);
-            
-            // ПРОВЕРКА: arrayValue может быть nullptr
-            if (!objectVal.arrayValue) {
-                throw std::runtime_error("Array is null");
-            }
-            
-            // ИСПРАВЛЕНИЕ: разыменовываем unique_ptr перед доступом
-            if (index < 0 || index >= objectVal.arrayValue->size()) {
-                throw std::runtime_error("Array index out of bounds");
-            }
-            
-            return (*objectVal.arrayValue)[index]; // РАЗЫМЕНОВЫВАЕМ указатель!
-        }
-        throw std::runtime_error("Cannot index this type");
+        return indexValue(objectVal, indexVal);
     }  
     else if (auto propAccess = dynamic_cast<const PropertyAccess*>(&expr)) {
         Value objectVal = evaluateExpression(*propAccess->object);
-        
-        if (objectVal.type == Value::OBJECT) {
-            // ПРОВЕРКА: objectValue может быть nullptr
-            if (!objectVal.objectValue) {
-                throw std::runtime_error("Object is null");
-            }
-            
-            // ИСПРАВЛЕНИЕ: разыменовываем unique_ptr перед доступом
-            auto it = objectVal.objectValue->find(propAccess->property);
-            if (it != objectVal.objectValue->end()) {
-                return it->second;
-            }
-            throw std::runtime_error("Property not found: " + propAccess->property);
-        }
-        throw std::runtime_error("Cannot access properties of this type");
+        return propertyValue(objectVal, propAccess->propertySymbol);
+    }
+    else if (auto methodCall = dynamic_cast<const MethodCall*>(&expr)) {
+        return evaluateMethodCall(*methodCall);
+    }
+    else if (auto await = dynamic_cast<const AwaitExpression*>(&expr)) {
+        return evaluateAwait(*await);
     }
     
     else if (dynamic_cast<const NullLiteral*>(&expr)) {
@@ -199,14 +103,308 @@ Value Interpreter::evaluateExpression(const Expression& expr) {
     return Value();
 }
 
+Value Interpreter::evaluateMethodCall(const MethodCall& call) {
+    // Получатель-имя меняется на месте (push, pop) и ищется после аргументов:
+    // их вычисление может переопределить переменную
+    auto id = dynamic_cast<const Identifier*>(call.object.get());
+    Value receiver;
+    if (!id) {
+        receiver = evaluateExpression(*call.object);
+    }
+    
+    std::vector<Value> args;
+    args.reserve(call.arguments.size());
+    for (const auto& arg : call.arguments) {
+        args.push_back(evaluateExpression(*arg));
+    }
+    
+    Value& target = id ? currentEnv->get(id->symbol) : receiver;
+    return callArrayMethod(target, call.methodSymbol, args.data(), args.size(), *this);
+}
+
+Value Interpreter::evaluateArrayLiteral(const ArrayLiteral& array) {
+    std::vector<Value> elements;
+    for (const auto& element : array.elements) {
+        elements.push_back(evaluateExpression(*element));
+    }
+    // Числа складываются в упакованное хранилище (ArrayStorage)
+    return Value(std::move(elements));
+}
+
+Value Interpreter::evaluateObjectLiteral(const ObjectLiteral& object) {
+    std::unordered_map<Symbol, Value> properties;
+    for (size_t i = 0; i < object.properties.size(); i++) {
+        properties[object.keySymbols[i]] = evaluateExpression(*object.properties[i].second);
+    }
+    // Ключи — символы имён свойств (keySymbols), как у PropertyAccess и методов
+    return Value(properties);
+}
+
+Value Interpreter::evaluateCall(const FunctionCall& call) {
+    if (call.functionName == "print") {
+        for (const auto& arg : call.arguments) {
+            Value value = evaluateExpression(*arg);
+            *output << value << " ";
+        }
+        *output << std::endl;
+        return Value();
+    }
+    
+    Value func = lookupFunction(*currentEnv, call.functionSymbol, call.arguments.size());
+    
+    std::vector<Value> args;
+    args.reserve(call.arguments.size());
+    for (const auto& arg : call.arguments) {
+        args.push_back(evaluateExpression(*arg));
+    }
+    
+    return invokeFunction(func, args);
+}
+
+Value Interpreter::call(const Value& function, const Value* args, size_t count) {
+    return invokeFunction(function, std::vector<Value>(args, args + count));
+}
+
+bool Interpreter::isPure(const Value& function) const {
+    return pureBodies.count(function.body.get()) > 0;
+}
+
+std::unique_ptr<FunctionCaller> Interpreter::fork() {
+    auto worker = std::make_unique<Interpreter>();
+    // Функции, которые вызывает колбэк, находятся по имени в окружении вызова.
+    // Чистый колбэк его не меняет, а вызвавший ждёт, поэтому чтение безопасно.
+    worker->currentEnv = std::make_shared<Environment>(currentEnv);
+    worker->pureBodies = pureBodies;
+    worker->output = output;
+    worker->errorOutput = errorOutput;
+    worker->maxCallDepth = maxCallDepth;
+    worker->stackGuard.attachToCurrentThread();
+    return worker;
+}
+
+class Interpreter::EnvironmentScope {
+private:
+    Interpreter& interpreter;
+    std::shared_ptr<Environment> outerEnv;
+    size_t depth;
+
+public:
+    EnvironmentScope(Interpreter& interpreter, std::shared_ptr<Environment> env, size_t depth = 0)
+        : interpreter(interpreter), outerEnv(std::move(env)), depth(depth) {
+        std::swap(interpreter.currentEnv, outerEnv);
+        interpreter.callDepth += depth;
+    }
+    ~EnvironmentScope() {
+        if (Coroutine::unwinding()) {
+            return;
+        }
+        std::swap(interpreter.currentEnv, outerEnv);
+        interpreter.callDepth -= depth;
+    }
+    EnvironmentScope(const EnvironmentScope&) = delete;
+    EnvironmentScope& operator=(const EnvironmentScope&) = delete;
+};
+
+Value Interpreter::invokeFunction(const Value& func, const std::vector<Value>& args) {
+    if (func.type == Value::NATIVE) {
+        return callNative(func, args.data(), args.size(), *this);
+    }
+    if (!asyncBodies.empty() && asyncBodies.count(func.body.get())) {
+        return startAsync(func, args);
+    }
+    if (!generatorBodies.empty() && generatorBodies.count(func.body.get())) {
+        return startGenerator(func, args);
+    }
+    preemptionPoint();
+
+    // Чистая функция с примитивными аргументами — пробуем кэш
+    MemoCache* memo = nullptr;
+    std::string memoKey;
+    if (memoCapacity > 0) {
+        auto it = memoCaches.find(func.body.get());
+        if (it != memoCaches.end() && MemoCache::makeKey(args, memoKey)) {
+            memo = it->second.get();
+            if (const Value* cached = memo->lookup(memoKey)) {
+                return *cached;
+            }
+        }
+    }
+    
+    if (jit) {
+        Value nativeResult;
+        if (jit->tryCall(func.body.get(), args, *globalEnv, nativeResult)) {
+            if (memo) {
+                memo->insert(memoKey, nativeResult);
+            }
+            return nativeResult;
+        }
+    }
+    
+    if (callDepth >= maxCallDepth) {
+        throw std::runtime_error("Stack overflow");
+    }
+    if (stackGuard.exhausted()) {
+        return runOnStackSegment(stackGuard, spareStackSegment, [&] { return invokeFunction(func, args); });
+    }
+    
+    auto funcEnv = std::make_shared<Environment>(currentEnv);
+    for (size_t i = 0; i < args.size(); i++) {
+        funcEnv->define(func.parameters[i], args[i]);
+    }
+    
+    Value result;
+    {
+        EnvironmentScope frame(*this, funcEnv, 1);
+        try {
+            executeBlock(*func.body, funcEnv);
+        } catch (const ReturnValue& returnValue) {
+            result = returnValue.value;
+        } catch (const ReturnStatement&) {
+        }
+    }
+    
+    if (memo) {
+        memo->insert(memoKey, result);
+    }
+    return result;
+}
+
+// Выбор специализации по первым наблюдаемым типам операндов
+static BinaryOperation::Specialization chooseSpecialization(const std::string& op, const Value& left, const Value& right) {
+    bool numbers = left.type == Value::NUMBER && right.type == Value::NUMBER;
+    bool strings = left.type == Value::STRING && right.type == Value::STRING;
+    bool booleans = left.type == Value::BOOLEAN && right.type == Value::BOOLEAN;
+
+    if (op == "+") {
+        if (numbers) return BinaryOperation::NUMBER_ADD;
+        if (left.type == Value::STRING || right.type == Value::STRING) return BinaryOperation::STRING_CONCAT;
+    }
+    else if (numbers) {
+        if (op == "-") return BinaryOperation::NUMBER_SUB;
+        if (op == "*") return BinaryOperation::NUMBER_MUL;
+        if (op == "/") return BinaryOperation::NUMBER_DIV;
+        if (op == "<") return BinaryOperation::NUMBER_LESS;
+        if (op == ">") return BinaryOperation::NUMBER_GREATER;
+        if (op == "<=") return BinaryOperation::NUMBER_LESS_EQUAL;
+        if (op == ">=") return BinaryOperation::NUMBER_GREATER_EQUAL;
+        if (op == "==") return BinaryOperation::NUMBER_EQUALS;
+        if (op == "!=") return BinaryOperation::NUMBER_NOT_EQUALS;
+    }
+    else if (strings) {
+        if (op == "==") return BinaryOperation::STRING_EQUALS;
+        if (op == "!=") return BinaryOperation::STRING_NOT_EQUALS;
+    }
+    else if (booleans) {
+        if (op == "and") return BinaryOperation::BOOLEAN_AND;
+        if (op == "or") return BinaryOperation::BOOLEAN_OR;
+    }
+    return BinaryOperation::GENERIC;
+}
+
+Value Interpreter::evaluateBinaryOperation(const BinaryOperation& binOp, const Value& left, const Value& right) {
+    bool numbers = left.type == Value::NUMBER && right.type == Value::NUMBER;
+    
+    switch (binOp.specialization) {
+        case BinaryOperation::NUMBER_ADD:
+            if (numbers) return Value(left.numberValue + right.numberValue);
+            break;
+        case BinaryOperation::NUMBER_SUB:
+            if (numbers) return Value(left.numberValue - right.numberValue);
+            break;
+        case BinaryOperation::NUMBER_MUL:
+            if (numbers) return Value(left.numberValue * right.numberValue);
+            break;
+        case BinaryOperation::NUMBER_DIV:
+            if (numbers) {
+                if (right.numberValue == 0) {
+                    throw std::runtime_error("Division by zero");
+                }
+                return Value(left.numberValue / right.numberValue);
+            }
+            break;
+        case BinaryOperation::NUMBER_LESS:
+            if (numbers) return Value(left.numberValue < right.numberValue);
+            break;
+        case BinaryOperation::NUMBER_GREATER:
+            if (numbers) return Value(left.numberValue > right.numberValue);
+            break;
+        case BinaryOperation::NUMBER_LESS_EQUAL:
+            if (numbers) return Value(left.numberValue <= right.numberValue);
+            break;
+        case BinaryOperation::NUMBER_GREATER_EQUAL:
+            if (numbers) return Value(left.numberValue >= right.numberValue);
+            break;
+        case BinaryOperation::NUMBER_EQUALS:
+            if (numbers) return Value(numbersEqual(left.numberValue, right.numberValue));
+            break;
+        case BinaryOperation::NUMBER_NOT_EQUALS:
+            if (numbers) return Value(!numbersEqual(left.numberValue, right.numberValue));
+            break;
+        case BinaryOperation::STRING_CONCAT:
+            if (left.type == Value::STRING || right.type == Value::STRING) {
+                return concatenateValues(left, right);
+            }
+            break;
+        case BinaryOperation::STRING_EQUALS:
+            if (left.type == Value::STRING && right.type == Value::STRING) {
+                return Value(stringsEqual(left, right));
+            }
+            break;
+        case BinaryOperation::STRING_NOT_EQUALS:
+            if (left.type == Value::STRING && right.type == Value::STRING) {
+                return Value(!stringsEqual(left, right));
+            }
+            break;
+        case BinaryOperation::BOOLEAN_AND:
+            if (left.type == Value::BOOLEAN && right.type == Value::BOOLEAN) {
+                return Value(left.booleanValue && right.booleanValue);
+            }
+            break;
+        case BinaryOperation::BOOLEAN_OR:
+            if (left.type == Value::BOOLEAN && right.type == Value::BOOLEAN) {
+                return Value(left.booleanValue || right.booleanValue);
+            }
+            break;
+        case BinaryOperation::UNSPECIALIZED:
+            binOp.specialization = chooseSpecialization(binOp.op, left, right);
+            if (binOp.specialization != BinaryOperation::GENERIC) {
+                quickenStats.specialized++;
+                return evaluateBinaryOperation(binOp, left, right);
+            }
+            quickenStats.generic++;
+            return evaluateGenericBinary(binOp, left, right);
+        case BinaryOperation::GENERIC:
+            return evaluateGenericBinary(binOp, left, right);
+    }
+    
+    // Защита не прошла: откатываемся к общему узлу. После нескольких
+    // откатов узел остаётся общим, чтобы не переспециализироваться бесконечно.
+    quickenStats.deoptimized++;
+    binOp.deoptCount++;
+    binOp.specialization = binOp.deoptCount < MAX_DEOPTIMIZATIONS
+        ? BinaryOperation::UNSPECIALIZED : BinaryOperation::GENERIC;
+    return evaluateGenericBinary(binOp, left, right);
+}
+
+// Общий (неспециализированный) путь бинарной операции
+Value Interpreter::evaluateGenericBinary(const BinaryOperation& binOp, const Value& left, const Value& right) {
+    return binaryOperation(binOp.op, left, right);
+}
+
 void Interpreter::executeStatement(const Statement& stmt) {
     if (auto varDecl = dynamic_cast<const VariableDeclaration*>(&stmt)) {
         Value value = varDecl->initializer ? evaluateExpression(*varDecl->initializer) : Value();
-        currentEnv->define(varDecl->variableName, value);
+        if (jit) {
+            jit->onBinding(varDecl->variableName, value.body.get());
+        }
+        currentEnv->define(varDecl->variableSymbol, value);
     }
     else if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
         Value value = evaluateExpression(*assignment->value);
-        currentEnv->set(assignment->variableName, value);
+        if (jit) {
+            jit->onBinding(assignment->variableName, value.body.get());
+        }
+        currentEnv->set(assignment->variableSymbol, value);
     }
     else if (auto ifStmt = dynamic_cast<const IfStatement*>(&stmt)) {
         Value condition = evaluateExpression(*ifStmt->condition);
@@ -218,27 +416,38 @@ void Interpreter::executeStatement(const Statement& stmt) {
     }
     else if (auto whileStmt = dynamic_cast<const WhileStatement*>(&stmt)) {
         while (true) {
+            if (tracer) {
+                tracer->onIteration(*whileStmt, *currentEnv);
+            }
             Value condition = evaluateExpression(*whileStmt->condition);
             if (!condition.booleanValue) break;
             executeBlock(*whileStmt->body, currentEnv);
+            preemptionPoint();
         }
     }
     else if (auto printStmt = dynamic_cast<const PrintStatement*>(&stmt)) {
         Value value = evaluateExpression(*printStmt->expression);
-        std::cout << value.toString() << std::endl;
+        *output << value << std::endl;
+    }
+    else if (auto yieldStmt = dynamic_cast<const YieldStatement*>(&stmt)) {
+        // Из вызванной генератором функции yield тоже допустим: стек сопрограммы общий
+        if (!currentGenerator || Coroutine::current() != currentGenerator->coroutine.get()) {
+            throw std::runtime_error("yield outside a generator function");
+        }
+        Generator* generator = currentGenerator;
+        generator->yielded = evaluateExpression(*yieldStmt->value);
+        generator->hasValue = true;
+        Coroutine::yield();
+    }
+    else if (auto forIn = dynamic_cast<const ForInStatement*>(&stmt)) {
+        executeForIn(*forIn);
     }
     else if (auto returnStmt = dynamic_cast<const ReturnStatement*>(&stmt)) {
         Value returnValue = returnStmt->value ? evaluateExpression(*returnStmt->value) : Value();
         throw ReturnValue(returnValue);
     }
     else if (auto funcDecl = dynamic_cast<const FunctionDeclaration*>(&stmt)) {
-        // Глубокое копирование блока функции
-        auto clonedBody = std::shared_ptr<Block>(
-            static_cast<Block*>(funcDecl->body->clone().release())
-        );
-        
-        Value funcValue(funcDecl->parameters, clonedBody);
-        currentEnv->define(funcDecl->functionName, funcValue);
+        executeFunctionDeclaration(*funcDecl);
     }
     else if (auto block = dynamic_cast<const Block*>(&stmt)) {
         executeBlock(*block, currentEnv);
@@ -255,6 +464,9 @@ void Interpreter::executeStatement(const Statement& stmt) {
         
         // Цикл
         while (true) {
+            if (tracer) {
+                tracer->onIteration(*forStmt, *currentEnv);
+            }
             if (forStmt->condition) {
                 Value condition = evaluateExpression(*forStmt->condition);
                 if (!condition.booleanValue) break;
@@ -265,6 +477,7 @@ void Interpreter::executeStatement(const Statement& stmt) {
             if (forStmt->increment) {
                 evaluateExpression(*forStmt->increment);
             }
+            preemptionPoint();
         }
     }
     else if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
@@ -275,7 +488,7 @@ void Interpreter::executeStatement(const Statement& stmt) {
             evaluateArrayAssignment(*assignment->target, value);
         } else {
             // Обычное присваивание переменной
-            currentEnv->set(assignment->variableName, value);
+            currentEnv->set(assignment->variableSymbol, value);
         }
     }
     else if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
@@ -286,11 +499,44 @@ void Interpreter::executeStatement(const Statement& stmt) {
             evaluateTargetAssignment(*assignment->target, value);
         } else {
             // Обычное присваивание переменной
-            currentEnv->set(assignment->variableName, value);
+            currentEnv->set(assignment->variableSymbol, value);
         }
     }        
 }
 
+void Interpreter::executeFunctionDeclaration(const FunctionDeclaration& funcDecl) {
+    currentEnv->define(funcDecl.functionSymbol, declareFunction(funcDecl));
+}
+
+Value Interpreter::declareFunction(const FunctionDeclaration& funcDecl) {
+    // Тело общее с объявлением: повторное выполнение (цикл, новый запуск
+    // той же программы) находит готовые кэш мемоизации и машинный код
+    const std::shared_ptr<Block>& body = funcDecl.body;
+    if (funcDecl.isPure) {
+        pureBodies.insert(body.get());
+    }
+    if (funcDecl.isAsync) {
+        asyncBodies.insert(body.get());
+    }
+    if (funcDecl.isGenerator) {
+        generatorBodies.insert(body.get());
+    }
+    
+    if (memoCapacity > 0 && funcDecl.isPure && !memoCaches.count(body.get())) {
+        memoCaches[body.get()] = std::make_shared<MemoCache>(
+            funcDecl.functionName, body, memoCapacity);
+    }
+    
+    if (jit) {
+        jit->onBinding(funcDecl.functionName, body.get());
+        if (funcDecl.isPure && !jit->find(body.get())) {
+            jit->registerFunction(funcDecl.functionName, funcDecl.parameters, body);
+        }
+    }
+    
+    return Value(funcDecl.parameterSymbols, body);
+}
+
 void Interpreter::evaluateTargetAssignment(const Expression& target, const Value& value) {
     if (auto indexExpr = dynamic_cast<const IndexExpression*>(&target)) {
         // Присваивание элементу массива: arr[index] = value
@@ -298,18 +544,18 @@ void Interpreter::evaluateTargetAssignment(const Expression& target, const Value
         Value indexVal = evaluateExpression(*indexExpr->index);
         
         if (arrayVal.type == Value::ARRAY && indexVal.type == Value::NUMBER) {
-            int index = static_cast<int>(indexVal.numberValue);
+            long long index = static_cast<long long>(indexVal.numberValue);
             
             if (!arrayVal.arrayValue) {
                 throw std::runtime_error("Array is null");
             }
             
-            if (index < 0 || index >= arrayVal.arrayValue->size()) {
+            if (index < 0 || index >= static_cast<long long>(arrayVal.arrayValue->size())) {
                 throw std::runtime_error("Array index out of bounds");
             }
             
             // Обновляем элемент массива
-            (*arrayVal.arrayValue)[index] = value;
+            arrayVal.mutableArray().set(index, value);
             return;
         }
         throw std::runtime_error("Cannot assign to array element");
@@ -324,7 +570,7 @@ void Interpreter::evaluateTargetAssignment(const Expression& target, const Value
             }
             
             // Обновляем или добавляем свойство
-            (*objectVal.objectValue)[propAccess->property] = value;
+            (*objectVal.objectValue)[propAccess->propertySymbol] = value;
             return;
         }
         throw std::runtime_error("Cannot assign to object property");
@@ -339,18 +585,18 @@ void Interpreter::evaluateArrayAssignment(const Expression& target, const Value&
         Value indexVal = evaluateExpression(*indexExpr->index);
         
         if (arrayVal.type == Value::ARRAY && indexVal.type == Value::NUMBER) {
-            int index = static_cast<int>(indexVal.numberValue);
+            long long index = static_cast<long long>(indexVal.numberValue);
             
             if (!arrayVal.arrayValue) {
                 throw std::runtime_error("Array is null");
             }
             
-            if (index < 0 || index >= arrayVal.arrayValue->size()) {
+            if (index < 0 || index >= static_cast<long long>(arrayVal.arrayValue->size())) {
                 throw std::runtime_error("Array index out of bounds");
             }
             
             // Обновляем элемент массива
-            (*arrayVal.arrayValue)[index] = value;
+            arrayVal.mutableArray().set(index, value);
             return;
         }
         throw std::runtime_error("Cannot assign to this type");
@@ -359,26 +605,479 @@ void Interpreter::evaluateArrayAssignment(const Expression& target, const Value&
 }
 
 void Interpreter::executeBlock(const Block& block, std::shared_ptr<Environment> env) {
-    auto oldEnv = currentEnv;
-    currentEnv = env;
-    
+    // ReturnValue и ошибки пробрасываются наверх, окружение возвращает scope
+    EnvironmentScope scope(*this, std::move(env));
     for (const auto& stmt : block.statements) {
+        executeStatement(*stmt);
+    }
+}
+
+void Interpreter::setGlobal(const std::string& name, const Value& value) {
+    globalEnv->define(intern(name), value);
+}
+
+Value Interpreter::getGlobal(const std::string& name) const {
+    return globalEnv->get(intern(name));
+}
+
+void Interpreter::reset() {
+    stopWorkers();
+    cancelTasks();
+    eventLoop.clear();
+    globalEnv = std::make_shared<Environment>();
+    globalEnv->variables = natives;
+    for (const auto& [name, value] : snapshotGlobals) {
+        globalEnv->variables[name] = value;
+    }
+    currentEnv = globalEnv;
+}
+
+size_t Interpreter::saveSnapshot(const std::string& path) const {
+    std::vector<std::pair<Symbol, Value>> globals(globalEnv->variables.begin(), globalEnv->variables.end());
+    return writeSnapshot(path, globals, [this](const Block* body) {
+        return (pureBodies.count(body) ? SNAPSHOT_PURE : 0u) | (asyncBodies.count(body) ? SNAPSHOT_ASYNC : 0u) |
+               (generatorBodies.count(body) ? SNAPSHOT_GENERATOR : 0u);
+    });
+}
+
+size_t Interpreter::loadSnapshot(const std::string& path) {
+    SnapshotImage image = readSnapshot(path);
+    for (const auto& funcDecl : image.functions) {
+        declareFunction(*funcDecl);
+    }
+    for (auto& [name, value] : image.globals) {
+        globalEnv->define(name, value);
+        snapshotGlobals[name] = std::move(value);
+    }
+    return image.globals.size();
+}
+
+void Interpreter::setOutput(std::ostream& out, std::ostream& errors) {
+    output = &out;
+    errorOutput = &errors;
+    if (tracer) {
+        tracer->setOutput(out);
+    }
+}
+
+void Interpreter::registerNative(const std::string& name, size_t arity, NativeCallback function) {
+    Value native = Value::native(std::make_shared<NativeFunction>(
+        NativeFunction{name, arity, std::move(function)}));
+    natives[intern(name)] = native;
+    globalEnv->define(intern(name), native);
+}
+
+void Interpreter::setMaxCallDepth(size_t depth) {
+    maxCallDepth = depth;
+}
+
+void Interpreter::enableMemoization(size_t capacity) {
+    memoCapacity = capacity;
+}
+
+void Interpreter::enableJit(size_t threshold) {
+    jit = std::make_unique<Jit>(threshold);
+}
+
+void Interpreter::enableTracing(size_t hotThreshold) {
+    tracer = std::make_unique<Tracer>(hotThreshold);
+    tracer->setOutput(*output);
+    if (preemptInterval) {
+        tracer->setBackEdgeHook([this] { preemptionPoint(); });
+    }
+}
+
+void Interpreter::setPreemption(size_t interval, std::function<void()> hook) {
+    preemptInterval = interval;
+    preemptCountdown = interval;
+    preemptHook = interval ? std::move(hook) : nullptr;
+    if (tracer) {
+        tracer->setBackEdgeHook(interval ? [this] { preemptionPoint(); } : std::function<void()>());
+    }
+}
+
+void Interpreter::printStats(std::ostream& os) const {
+    os << "Quickening: specialized=" << quickenStats.specialized
+       << " deoptimized=" << quickenStats.deoptimized
+       << " generic=" << quickenStats.generic << std::endl;
+    
+    if (!memoCaches.empty()) {
+        os << "Memoization:" << std::endl;
+        for (const auto& [body, cache] : memoCaches) {
+            os << "  " << cache->name() << ": hits=" << cache->hits()
+               << " misses=" << cache->misses()
+               << " entries=" << cache->size() << std::endl;
+        }
+    }
+    
+    if (jit) {
+        jit->printStats(os);
+    }
+    
+    if (tracer) {
+        tracer->printStats(os);
+    }
+}
+
+// Async-функции и цикл событий
+
+void Interpreter::registerEventNatives() {
+    auto timer = [this](const char* name, bool interval) {
+        return [this, name, interval](const Value* args, size_t) {
+            Value callback = args[0];
+            bool callable = callback.type == Value::FUNCTION ? callback.arity() == 0
+                          : callback.type == Value::NATIVE && callback.nativeFunction->arity == 0;
+            if (!callable) {
+                throw std::runtime_error(std::string(name) + " expects a function of 0 arguments");
+            }
+            if (args[1].type != Value::NUMBER) {
+                throw std::runtime_error(std::string(name) + " expects a delay in milliseconds");
+            }
+            long long id = eventLoop.addTimer(args[1].numberValue, interval, [this, callback] {
+                invokeFunction(callback, {});
+            });
+            return Value(static_cast<double>(id));
+        };
+    };
+    auto cancel = [this](const Value* args, size_t) {
+        if (args[0].type == Value::NUMBER) {
+            eventLoop.cancelTimer(static_cast<long long>(args[0].numberValue));
+        }
+        return Value();
+    };
+    registerNative("setTimeout", 2, timer("setTimeout", false));
+    registerNative("setInterval", 2, timer("setInterval", true));
+    registerNative("clearTimeout", 1, cancel);
+    registerNative("clearInterval", 1, cancel);
+    registerNative("sleep", 1, [this](const Value* args, size_t) {
+        if (args[0].type != Value::NUMBER) {
+            throw std::runtime_error("sleep expects a delay in milliseconds");
+        }
+        auto promise = std::make_shared<Promise>();
+        eventLoop.addTimer(args[0].numberValue, false, [this, promise] {
+            eventLoop.resolve(promise, Value());
+        });
+        return Value::host(Value::PROMISE, promise);
+    });
+}
+
+// Окружение с параметрами и сопрограмма для вызова, который будет приостанавливаться
+void Interpreter::prepareCall(const Value& func, const std::vector<Value>& args, SuspendedCall& call,
+                              Coroutine::Body body) {
+    // Тело выполняется на стеке сопрограммы, поэтому родной стек не проверяется
+    if (callDepth >= maxCallDepth) {
+        throw std::runtime_error("Stack overflow");
+    }
+    call.env = std::make_shared<Environment>(currentEnv);
+    for (size_t i = 0; i < args.size(); i++) {
+        call.env->define(func.parameters[i], args[i]);
+    }
+    call.callDepth = callDepth + 1;
+    call.coroutine = std::make_unique<Coroutine>(std::move(body));
+    call.stackGuard.attachToStack(call.coroutine->stackLowest(), call.coroutine->stackSize());
+}
+
+Value Interpreter::executeFunctionBody(const Block& body) {
+    try {
+        executeBlock(body, currentEnv);
+    } catch (const ReturnValue& returnValue) {
+        return returnValue.value;
+    } catch (const ReturnStatement&) {
+    }
+    return Value();
+}
+
+// Тело выполняется сразу, до первого await; вызвавший получает обещание результата
+Value Interpreter::startAsync(const Value& func, const std::vector<Value>& args) {
+    auto task = std::make_shared<AsyncTask>();
+    task->promise = std::make_shared<Promise>();
+    AsyncTask* self = task.get();
+    std::shared_ptr<Block> body = func.body;
+    prepareCall(func, args, *task, [this, self, body] {
         try {
-            executeStatement(*stmt);
-        } catch (const ReturnValue&) {
-            // Пробрасываем ReturnValue наверх
-            currentEnv = oldEnv;
-            throw;
-        } catch (const ReturnStatement&) {
-            // Для обратной совместимости
-            currentEnv = oldEnv;
-            throw;
+            eventLoop.resolve(self->promise, executeFunctionBody(*body));
+        } catch (const std::exception& e) {
+            eventLoop.reject(self->promise, e.what());
         }
+    });
+    tasks.insert(task);
+    
+    Value promise = Value::host(Value::PROMISE, task->promise);
+    resumeTask(task);
+    return promise;
+}
+
+// Пока вызов выполняется, интерпретатор работает с его состоянием.
+// Исключение тела возвращается, когда состояние уже восстановлено.
+std::exception_ptr Interpreter::resumeSuspended(SuspendedCall& call) {
+    std::swap(currentEnv, call.env);
+    std::swap(callDepth, call.callDepth);
+    std::swap(stackGuard, call.stackGuard);
+    
+    std::exception_ptr error;
+    try {
+        call.coroutine->resume();
+    } catch (...) {
+        error = std::current_exception();
     }
     
-    currentEnv = oldEnv;
+    std::swap(currentEnv, call.env);
+    std::swap(callDepth, call.callDepth);
+    std::swap(stackGuard, call.stackGuard);
+    return error;
 }
 
-void Interpreter::setGlobal(const std::string& name, const Value& value) {
-    globalEnv->define(name, value);
+void Interpreter::resumeTask(const std::shared_ptr<AsyncTask>& task) {
+    std::shared_ptr<AsyncTask> outer = std::move(currentTask);
+    currentTask = task;
+    std::exception_ptr error = resumeSuspended(*task);
+    currentTask = std::move(outer);
+    if (task->coroutine->finished()) {
+        tasks.erase(task);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Генератор ленив: тело начинает выполняться при первом запросе значения
+Value Interpreter::startGenerator(const Value& func, const std::vector<Value>& args) {
+    auto generator = std::make_shared<Generator>();
+    std::shared_ptr<Block> body = func.body;
+    prepareCall(func, args, *generator, [this, body] {
+        executeFunctionBody(*body);
+    });
+    return Value::host(Value::GENERATOR, generator);
+}
+
+bool Interpreter::nextGeneratorValue(const std::shared_ptr<Generator>& generator, Value& value) {
+    if (generator->coroutine->finished()) {
+        return false;
+    }
+    if (Coroutine::current() == generator->coroutine.get()) {
+        throw std::runtime_error("Generator is already running");
+    }
+    // generator держит объект, даже если тело забудет последнюю ссылку на него
+    Generator* outer = currentGenerator;
+    currentGenerator = generator.get();
+    generator->hasValue = false;
+    std::exception_ptr error = resumeSuspended(*generator);
+    currentGenerator = outer;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (!generator->hasValue) {
+        return false;
+    }
+    value = std::move(generator->yielded);
+    return true;
+}
+
+// Массив обходится по снимку элементов, генератор — по одному значению за шаг
+void Interpreter::executeForIn(const ForInStatement& loop) {
+    Value iterable = evaluateExpression(*loop.iterable);
+    if (iterable.type == Value::ARRAY) {
+        std::shared_ptr<const ArrayStorage> elements = iterable.arrayValue;
+        for (size_t i = 0; i < elements->size(); i++) {
+            currentEnv->define(loop.variableSymbol, elements->get(i));
+            executeBlock(*loop.body, currentEnv);
+            preemptionPoint();
+        }
+    } else if (iterable.type == Value::GENERATOR) {
+        auto generator = std::static_pointer_cast<Generator>(iterable.hostObject);
+        Value value;
+        while (nextGeneratorValue(generator, value)) {
+            currentEnv->define(loop.variableSymbol, value);
+            executeBlock(*loop.body, currentEnv);
+            preemptionPoint();
+        }
+    } else {
+        throw std::runtime_error("for..in expects an array or a generator");
+    }
+}
+
+// В async-функции await приостанавливает её сопрограмму до результата.
+// В самой программе (и в функциях, вызванных не из async) поток не с кем
+// делить: цикл событий выполняется здесь же, пока обещание не выполнится.
+Value Interpreter::evaluateAwait(const AwaitExpression& await) {
+    Value value = evaluateExpression(*await.operand);
+    if (value.type != Value::PROMISE) {
+        return value;
+    }
+    std::shared_ptr<Promise> promise = std::static_pointer_cast<Promise>(value.hostObject);
+    promise->handled = true;
+    
+    if (promise->state == Promise::PENDING) {
+        if (currentTask && Coroutine::current() == currentTask->coroutine.get()) {
+            std::weak_ptr<AsyncTask> waiting = currentTask;
+            promise->reactions.push_back([this, waiting] {
+                if (std::shared_ptr<AsyncTask> task = waiting.lock()) {
+                    resumeTask(task);
+                }
+            });
+            Coroutine::yield();
+        } else {
+            eventLoop.run([&promise] { return promise->state != Promise::PENDING; });
+            if (promise->state == Promise::PENDING) {
+                throw std::runtime_error("await: the promise is never settled");
+            }
+        }
+    }
+    
+    if (promise->state == Promise::REJECTED) {
+        throw std::runtime_error(promise->error);
+    }
+    return promise->result;
+}
+
+void Interpreter::runEventLoop() {
+    eventLoop.run();
+    for (const std::string& error : eventLoop.takeUnhandledErrors()) {
+        *errorOutput << "Runtime error: " << error << std::endl;
+    }
+}
+
+// Незавершённые задачи раскручиваются (Coroutine::Cancelled); их продолжения
+// в цикле находят пустую слабую ссылку
+void Interpreter::cancelTasks() {
+    std::unordered_set<std::shared_ptr<AsyncTask>> cancelled = std::move(tasks);
+    tasks.clear();
+    cancelled.clear();
+}
+
+// Воркеры: интерпретаторы в своих потоках, обмен сообщениями через WorkerChannel
+
+void Interpreter::registerWorkerNatives() {
+    registerNative("Worker", 1, [this](const Value* args, size_t) {
+        if (args[0].type != Value::FUNCTION || args[0].arity() != 1) {
+            throw std::runtime_error("Worker expects a function of 1 argument");
+        }
+        return spawnWorker(args[0]);
+    });
+    registerNative("postMessage", 2, [](const Value* args, size_t) {
+        if (args[0].type != Value::WORKER) {
+            throw std::runtime_error("postMessage expects a worker");
+        }
+        if (!isTransferable(args[1])) {
+            throw std::runtime_error("postMessage can send only numbers, strings, booleans, null, arrays and objects");
+        }
+        std::static_pointer_cast<MessagePort>(args[0].hostObject)->post(args[1]);
+        return Value();
+    });
+    registerNative("onMessage", 2, [](const Value* args, size_t) {
+        auto worker = args[0].type == Value::WORKER ? std::dynamic_pointer_cast<WorkerHandle>(args[0].hostObject) : nullptr;
+        if (!worker || args[1].type != Value::FUNCTION || args[1].arity() != 1) {
+            throw std::runtime_error("onMessage expects a worker and a function of 1 argument");
+        }
+        worker->onMessage = args[1];
+        return Value();
+    });
+    registerNative("terminate", 1, [](const Value* args, size_t) {
+        auto worker = args[0].type == Value::WORKER ? std::dynamic_pointer_cast<WorkerHandle>(args[0].hostObject) : nullptr;
+        if (!worker) {
+            throw std::runtime_error("terminate expects a worker");
+        }
+        worker->terminate();
+        return Value();
+    });
+}
+
+// Воркер получает снимок видимых привязок: функции (AST общий) и данные.
+// Родные функции у него свои, а обещания и генераторы принадлежат родителю.
+// handler вызывается в потоке воркера для каждого сообщения; ответ —
+// postMessage(parent, value).
+Value Interpreter::spawnWorker(const Value& handler) {
+    auto channel = std::make_shared<WorkerChannel>();
+    auto child = std::make_shared<Interpreter>();
+    for (Environment* env = currentEnv.get(); env; env = env->parent.get()) {
+        for (const auto& [name, value] : env->variables) {
+            if (value.type == Value::FUNCTION || isTransferable(value)) {
+                child->globalEnv->variables.emplace(name, value);
+            }
+        }
+    }
+    child->pureBodies = pureBodies;
+    child->asyncBodies = asyncBodies;
+    child->generatorBodies = generatorBodies;
+    child->maxCallDepth = maxCallDepth;
+    
+    // Вывод воркера уходит родителю и печатается в его потоке
+    auto printed = std::make_shared<std::ostringstream>();
+    auto errors = std::make_shared<std::ostringstream>();
+    child->output = printed.get();
+    child->errorOutput = errors.get();
+    auto flushOutput = [channel, printed, errors] {
+        for (auto* buffer : {printed.get(), errors.get()}) {
+            if (buffer->tellp() > 0) {
+                WorkerEvent event;
+                event.kind = buffer == printed.get() ? WorkerEvent::OUTPUT : WorkerEvent::ERROR_OUTPUT;
+                event.text = buffer->str();
+                buffer->str("");
+                channel->outbox.push(std::move(event));
+            }
+        }
+    };
+    child->globalEnv->define(intern("parent"), Value::host(Value::WORKER, std::make_shared<ParentPort>(channel, flushOutput)));
+    
+    channel->parentLoop = &eventLoop;
+    channel->workerLoop = &child->eventLoop;
+    auto worker = std::make_shared<WorkerHandle>(channel);
+    std::weak_ptr<WorkerHandle> weakWorker = worker;
+    
+    // Родитель забирает события воркера, пока тот занят его сообщениями
+    worker->sourceId = eventLoop.addSource([this, weakWorker] {
+        std::shared_ptr<WorkerHandle> worker = weakWorker.lock();
+        if (!worker) return false;
+        // busy читается до очереди: всё, что воркер отправил до обнуления, уже в ней
+        bool waiting = worker->channel->busy.load(std::memory_order_acquire) > 0;
+        WorkerEvent event;
+        while (worker->channel->outbox.pop(event)) {
+            eventLoop.post([this, weakWorker, event] {
+                if (event.kind == WorkerEvent::OUTPUT) {
+                    *output << event.text;
+                } else if (event.kind == WorkerEvent::ERROR_OUTPUT) {
+                    *errorOutput << event.text;
+                } else if (std::shared_ptr<WorkerHandle> worker = weakWorker.lock()) {
+                    if (worker->onMessage.type == Value::FUNCTION) {
+                        invokeFunction(worker->onMessage, {event.message});
+                    }
+                }
+            });
+        }
+        return waiting;
+    });
+    
+    worker->interpreter = child;
+    Interpreter* self = child.get();
+    worker->start([self, channel, handler, flushOutput] {
+        self->stackGuard.attachToCurrentThread();
+        self->eventLoop.addSource([self, channel, handler, flushOutput] {
+            Value message;
+            while (channel->inbox.pop(message)) {
+                self->eventLoop.post([self, channel, handler, flushOutput, message] {
+                    try {
+                        self->invokeFunction(handler, {message});
+                    } catch (const std::exception& e) {
+                        *self->errorOutput << "Runtime error: " << e.what() << std::endl;
+                        self->callDepth = 0;
+                        self->currentEnv = self->globalEnv;
+                    }
+                    flushOutput();
+                    channel->busy.fetch_sub(1, std::memory_order_release);
+                    channel->parentLoop->wake();
+                });
+            }
+            return !channel->stopping.load();
+        });
+        self->eventLoop.run([&channel] { return channel->stopping.load(); });
+    });
+    workers.push_back(worker);
+    return Value::host(Value::WORKER, worker);
+}
+
+void Interpreter::stopWorkers() {
+    for (const auto& worker : workers) {
+        worker->terminate();
+    }
+    workers.clear();
 }
\ No newline at end of file
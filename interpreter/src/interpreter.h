@@ -2,23 +2,171 @@
 #define INTERPRETER_H
 
 #include "ast.h"
+#include "coroutine.h"
 #include "environment.h"
+#include "eventloop.h"
+#include "jit.h"
+#include "memo.h"
+#include "runtime.h"
+#include "tracer.h"
+#include "worker.h"
+#include <functional>
 #include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <unordered_set>
 
-class Interpreter {
+class Interpreter : public FunctionCaller {
 private:
     std::shared_ptr<Environment> globalEnv;
     std::shared_ptr<Environment> currentEnv;
+    // Родные функции (registerNative) переживают reset
+    std::unordered_map<Symbol, Value> natives;
+    // Глобальные из снимка (loadSnapshot) тоже переживают reset
+    std::unordered_map<Symbol, Value> snapshotGlobals;
+    // Вывод print и сообщения об ошибках (по умолчанию std::cout и std::cerr)
+    std::ostream* output;
+    std::ostream* errorOutput;
+    
+    // Мемоизация чистых функций: 0 — выключена
+    size_t memoCapacity;
+    std::unordered_map<const Block*, std::shared_ptr<MemoCache>> memoCaches;
+    // Тела чистых функций (FunctionDeclaration::isPure), для parallelMap
+    std::unordered_set<const Block*> pureBodies;
+    
+    // Цикл событий: таймеры (setTimeout, sleep) и async-функции, ждущие await
+    EventLoop eventLoop;
+    // Вызов async-функции или генератора выполняется в своей сопрограмме.
+    // Пока он приостановлен, здесь хранятся его окружение, глубина вызовов
+    // и граница стека.
+    struct SuspendedCall {
+        std::unique_ptr<Coroutine> coroutine;
+        std::shared_ptr<Environment> env;
+        size_t callDepth = 0;
+        StackGuard stackGuard;
+    };
+    struct AsyncTask : SuspendedCall {
+        std::shared_ptr<Promise> promise;
+    };
+    // Значение вызова fun*: тело выполняется по шагам, от yield до yield
+    struct Generator : HostObject, SuspendedCall {
+        Value yielded;
+        bool hasValue = false;
+    };
+    std::unordered_set<const Block*> asyncBodies;
+    std::unordered_set<const Block*> generatorBodies;
+    // Незавершённые задачи; продолжения в цикле ссылаются на них слабо
+    std::unordered_set<std::shared_ptr<AsyncTask>> tasks;
+    std::shared_ptr<AsyncTask> currentTask; // nullptr — выполняется сама программа
+    Generator* currentGenerator = nullptr;
+    // Запущенные воркеры. Воркер живёт, даже если скрипт забыл его значение:
+    // до terminate или до конца интерпретатора (stopWorkers).
+    std::vector<std::shared_ptr<WorkerHandle>> workers;
+    
+    // Базовый JIT для горячих чистых функций (nullptr — выключен)
+    std::unique_ptr<Jit> jit;
+    
+    // Трассирующий JIT для горячих циклов (nullptr — выключен)
+    std::unique_ptr<Tracer> tracer;
+    
+    // Вытеснение (setPreemption): раз в preemptInterval обратных переходов
+    // циклов и вызовов функций вызывается preemptHook; 0 — выключено
+    size_t preemptInterval = 0;
+    size_t preemptCountdown = 0;
+    std::function<void()> preemptHook;
+    void preemptionPoint() {
+        if (preemptInterval && --preemptCountdown == 0) {
+            preemptCountdown = preemptInterval;
+            preemptHook();
+        }
+    }
+    
+    // Глубина вызовов функций языка и её предел (--max-depth)
+    size_t maxCallDepth;
+    size_t callDepth;
+    StackGuard stackGuard;
+    // Когда родной стек кончается, вызовы продолжаются на сегментах в куче;
+    // последний освободившийся сегмент остаётся для следующего раза
+    std::unique_ptr<StackSegment> spareStackSegment;
+    // Подменяет currentEnv (и callDepth для вызова функции) и возвращает их при
+    // выходе из области, в том числе по исключению, как resumeSuspended.
+    // Раскрутка отменённой сопрограммы (Coroutine::unwinding) их не трогает.
+    class EnvironmentScope;
+    
+    // Счётчики самоспециализации узлов BinaryOperation
+    struct QuickenStats {
+        size_t specialized = 0;
+        size_t deoptimized = 0;
+        size_t generic = 0;
+    } quickenStats;
     
     Value evaluateExpression(const Expression& expr);
+    // Ветви с большими локальными вынесены из evaluateExpression, чтобы не
+    // увеличивать его кадр на каждом уровне рекурсии
+    Value evaluateCall(const FunctionCall& call);
+    Value evaluateMethodCall(const MethodCall& call);
+    Value invokeFunction(const Value& func, const std::vector<Value>& args);
+    Value startAsync(const Value& func, const std::vector<Value>& args);
+    void resumeTask(const std::shared_ptr<AsyncTask>& task);
+    std::exception_ptr resumeSuspended(SuspendedCall& call);
+    void prepareCall(const Value& func, const std::vector<Value>& args, SuspendedCall& call, Coroutine::Body body);
+    Value executeFunctionBody(const Block& body);
+    Value startGenerator(const Value& func, const std::vector<Value>& args);
+    // Следующее значение генератора; false — тело завершилось
+    bool nextGeneratorValue(const std::shared_ptr<Generator>& generator, Value& value);
+    void executeForIn(const ForInStatement& loop);
+    Value evaluateAwait(const AwaitExpression& await);
+    void registerEventNatives();
+    void registerWorkerNatives();
+    Value spawnWorker(const Value& handler);
+    void stopWorkers();
+    void runEventLoop();
+    void cancelTasks();
+    Value evaluateArrayLiteral(const ArrayLiteral& array);
+    Value evaluateObjectLiteral(const ObjectLiteral& object);
+    Value evaluateBinaryOperation(const BinaryOperation& binOp, const Value& left, const Value& right);
+    Value evaluateGenericBinary(const BinaryOperation& binOp, const Value& left, const Value& right);
     void executeStatement(const Statement& stmt);
+    void executeFunctionDeclaration(const FunctionDeclaration& funcDecl);
+    // Зарегистрировать тело (чистота, async, мемоизация, JIT) и вернуть значение-функцию
+    Value declareFunction(const FunctionDeclaration& funcDecl);
     void executeBlock(const Block& block, std::shared_ptr<Environment> env);
     void evaluateTargetAssignment(const Expression& target, const Value& value); // НОВЫЙ МЕТОД
     void evaluateArrayAssignment(const Expression& target, const Value& value);
 public:
     Interpreter();
+    ~Interpreter();
     void interpret(const Program& program);
     void setGlobal(const std::string& name, const Value& value);
+    // Значение глобальной переменной после выполнения; нет такой — ошибка
+    Value getGlobal(const std::string& name) const;
+    // Забыть переменные прошлых запусков (Script); родные функции, кэши
+    // мемоизации, машинный код JIT и трассы остаются
+    void reset();
+    // Свой вывод для каждого интерпретатора (изоляты, см. isolate.h)
+    void setOutput(std::ostream& out, std::ostream& errors);
+    // Функция C++ под именем name; скрипт вызывает её как обычную функцию
+    void registerNative(const std::string& name, size_t arity, NativeCallback function);
+    // Записать глобальные переменные в снимок (snapshot.h); возвращает размер образа
+    size_t saveSnapshot(const std::string& path) const;
+    // Определить глобальные из снимка; они остаются и после reset. Возвращает их число.
+    size_t loadSnapshot(const std::string& path);
+    void setMaxCallDepth(size_t depth);
+    void enableMemoization(size_t capacity);
+    void enableJit(size_t threshold);
+    void enableTracing(size_t hotThreshold);
+    // Раз в interval обратных переходов циклов (и в трассах Tracer) и вызовов
+    // функций вызывать hook — обычно Scheduler::checkpoint, который уступает
+    // поток другим скриптам. Машинный код --jit проверок не содержит.
+    // interval = 0 — выключить.
+    void setPreemption(size_t interval, std::function<void()> hook);
+    void printStats(std::ostream& os) const;
+    // Колбэки методов массива (map, filter, reduce)
+    Value call(const Value& function, const Value* args, size_t count) override;
+    bool isPure(const Value& function) const override;
+    // Интерпретатор без кэшей и JIT, окружение которого продолжает текущее
+    std::unique_ptr<FunctionCaller> fork() override;
+    bool canFork() const override { return true; }
 };
 
 #endif // INTERPRETER_H
\ No newline at end of file
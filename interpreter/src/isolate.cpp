@@ -0,0 +1,29 @@
+#include "isolate.h"
+
+Isolate::Isolate() {
+    interpreter.setOutput(output, errors);
+}
+
+Interpreter& Isolate::getInterpreter() {
+    return interpreter;
+}
+
+void Isolate::run(const Script& script, const std::vector<std::pair<std::string, Value>>& inputs) {
+    interpreter.reset();
+    for (const auto& [name, value] : inputs) {
+        interpreter.setGlobal(name, value);
+    }
+    script.run(interpreter);
+}
+
+std::string Isolate::takeOutput() {
+    std::string text = output.str();
+    output.str("");
+    return text;
+}
+
+std::string Isolate::takeErrors() {
+    std::string text = errors.str();
+    errors.str("");
+    return text;
+}
\ No newline at end of file
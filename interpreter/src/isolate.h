@@ -0,0 +1,45 @@
+#ifndef ISOLATE_H
+#define ISOLATE_H
+
+#include "interpreter.h"
+#include "script.h"
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Изолят — интерпретатор со своими значениями, окружениями, кэшами и выводом.
+// Один изолят выполняет один поток за раз; разные изоляты работают в разных
+// потоках без блокировок. Общее у них только то, что не меняется или меняется
+// атомарно:
+//   - разобранный скрипт (Script): AST только читается, кроме атомарных
+//     подсказок — специализации BinaryOperation и номеров циклов для Tracer;
+//   - таблица символов (symbol.h) под мьютексом, к ней обращаются при разборе
+//     и в сообщениях об ошибках;
+//   - хранилища строковых литералов и тела функций: неизменяемы, счётчики
+//     ссылок shared_ptr атомарные.
+// Значения между изолятами не передаются. Внутри изолята хранилища массивов
+// всё же переходят между потоками (сообщения воркеров, части parallelMap),
+// поэтому копирование при записи (Value::mutableArray) признаёт единственного
+// владельца только с упорядочиванием acquire.
+class Isolate {
+private:
+    std::ostringstream output;
+    std::ostringstream errors;
+    Interpreter interpreter;
+
+public:
+    Isolate();
+
+    // Для настройки (JIT, мемоизация, родные функции) и ввода-вывода через глобальные
+    Interpreter& getInterpreter();
+
+    // Выполнить скрипт с чистыми глобальными переменными и входными данными inputs
+    void run(const Script& script, const std::vector<std::pair<std::string, Value>>& inputs = {});
+
+    // Накопленный вывод print и сообщения об ошибках; буферы очищаются
+    std::string takeOutput();
+    std::string takeErrors();
+};
+
+#endif // ISOLATE_H
\ No newline at end of file
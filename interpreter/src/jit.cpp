@@ -0,0 +1,666 @@
+#include "jit.h"
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <unordered_set>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define JIT_X64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Предел глубины рекурсии машинного кода; глубже — повтор в интерпретаторе
+const long JIT_MAX_DEPTH = 10000;
+
+namespace {
+
+// Регистры x86-64 в порядке кодирования
+enum Reg { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7 };
+
+// Коды условий для jcc (0F 80+cc) и setcc (0F 90+cc)
+enum Cond { COND_AE = 0x3, COND_E = 0x4, COND_NE = 0x5, COND_A = 0x7, COND_LE = 0xE };
+
+struct Label {
+    size_t position = SIZE_MAX;
+    std::vector<size_t> patches;
+};
+
+// Минимальный ассемблер: только инструкции, нужные базовому JIT
+class Assembler {
+public:
+    std::vector<uint8_t> code;
+
+    void bytes(std::initializer_list<uint8_t> values) {
+        code.insert(code.end(), values);
+    }
+
+    void imm32(int32_t value) {
+        for (int i = 0; i < 4; i++) code.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void imm64(uint64_t value) {
+        for (int i = 0; i < 8; i++) code.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void bind(Label& label) {
+        label.position = code.size();
+        for (size_t site : label.patches) {
+            patch(site, label.position);
+        }
+        label.patches.clear();
+    }
+
+    void jmp(Label& label) {
+        bytes({0xE9});
+        target(label);
+    }
+
+    void jcc(Cond cond, Label& label) {
+        bytes({0x0F, static_cast<uint8_t>(0x80 | cond)});
+        target(label);
+    }
+
+    void setcc(Cond cond) {
+        bytes({0x0F, static_cast<uint8_t>(0x90 | cond), 0xC0}); // setcc al
+        bytes({0x0F, 0xB6, 0xC0});                             // movzx eax, al
+    }
+
+    void push(Reg reg) { bytes({static_cast<uint8_t>(0x50 + reg)}); }
+    void pop(Reg reg) { bytes({static_cast<uint8_t>(0x58 + reg)}); }
+
+    void movImm64(Reg reg, uint64_t value) {
+        bytes({0x48, static_cast<uint8_t>(0xB8 + reg)});
+        imm64(value);
+    }
+
+    void movImm32(Reg reg, int32_t value) {
+        bytes({static_cast<uint8_t>(0xB8 + reg)});
+        imm32(value);
+    }
+
+    void store(Reg base, int32_t disp, Reg src) { memoryOp({0x48, 0x89}, src, base, disp); }
+    void load(Reg dst, Reg base, int32_t disp) { memoryOp({0x48, 0x8B}, dst, base, disp); }
+    void lea(Reg dst, Reg base, int32_t disp) { memoryOp({0x48, 0x8D}, dst, base, disp); }
+
+    void subRsp(int32_t value) { bytes({0x48, 0x81, 0xEC}); imm32(value); }
+    void addRsp(int32_t value) { bytes({0x48, 0x81, 0xC4}); imm32(value); }
+
+    // SSE2: xmm-регистры кодируются номерами 0..7
+    void movsdLoad(int xmm, Reg base, int32_t disp) { memoryOp({0xF2, 0x0F, 0x10}, xmm, base, disp); }
+    void movsdStore(Reg base, int32_t disp, int xmm) { memoryOp({0xF2, 0x0F, 0x11}, xmm, base, disp); }
+    void addsd(int dst, int src) { registerOp({0xF2, 0x0F, 0x58}, dst, src); }
+    void subsd(int dst, int src) { registerOp({0xF2, 0x0F, 0x5C}, dst, src); }
+    void mulsd(int dst, int src) { registerOp({0xF2, 0x0F, 0x59}, dst, src); }
+    void divsd(int dst, int src) { registerOp({0xF2, 0x0F, 0x5E}, dst, src); }
+    void movapd(int dst, int src) { registerOp({0x66, 0x0F, 0x28}, dst, src); }
+    void xorpd(int dst, int src) { registerOp({0x66, 0x0F, 0x57}, dst, src); }
+    void ucomisd(int a, int b) { registerOp({0x66, 0x0F, 0x2E}, a, b); }
+    void movqFromRax(int xmm) { bytes({0x66, 0x48, 0x0F, 0x6E, static_cast<uint8_t>(0xC0 | xmm << 3)}); }
+
+private:
+    void target(Label& label) {
+        size_t site = code.size();
+        imm32(0);
+        if (label.position != SIZE_MAX) {
+            patch(site, label.position);
+        } else {
+            label.patches.push_back(site);
+        }
+    }
+
+    void patch(size_t site, size_t position) {
+        int32_t rel = static_cast<int32_t>(position - (site + 4));
+        std::memcpy(&code[site], &rel, sizeof(rel));
+    }
+
+    void memoryOp(std::initializer_list<uint8_t> opcode, int reg, Reg base, int32_t disp) {
+        code.insert(code.end(), opcode);
+        code.push_back(static_cast<uint8_t>(0x80 | (reg & 7) << 3 | base)); // [base + disp32]
+        if (base == RSP) code.push_back(0x24);                              // SIB для rsp
+        imm32(disp);
+    }
+
+    void registerOp(std::initializer_list<uint8_t> opcode, int dst, int src) {
+        code.insert(code.end(), opcode);
+        code.push_back(static_cast<uint8_t>(0xC0 | dst << 3 | src));
+    }
+};
+
+enum class JitType { NUMBER, BOOLEAN };
+
+// Вызывается из машинного кода: результат в al
+bool jitNumbersEqual(double a, double b) {
+    return numbersEqual(a, b);
+}
+
+// Компилирует тело одной функции.
+// Кадр: [rbp-8] — адрес результата, [rbp-16] — глубина, далее слоты локальных.
+// Временные значения выражений живут на машинном стеке.
+class FunctionCompiler {
+private:
+    Jit& jit;
+    JitFunction& function;
+    const Environment& globals;
+    Assembler as;
+    std::unordered_map<std::string, int> slots;
+    Label bailout;
+    int stackDepth; // Байт временных значений поверх кадра (для выравнивания вызовов)
+    std::vector<std::pair<std::string, const Block*>> callees;
+
+    static int32_t slotOffset(int slot) { return -24 - 8 * slot; }
+
+    void collectSlots(const Statement& stmt) {
+        if (auto varDecl = dynamic_cast<const VariableDeclaration*>(&stmt)) {
+            slots.emplace(varDecl->variableName, static_cast<int>(slots.size()));
+        }
+        else if (auto block = dynamic_cast<const Block*>(&stmt)) {
+            for (const auto& s : block->statements) collectSlots(*s);
+        }
+        else if (auto ifStmt = dynamic_cast<const IfStatement*>(&stmt)) {
+            collectSlots(*ifStmt->thenBlock);
+            if (ifStmt->elseBlock) collectSlots(*ifStmt->elseBlock);
+        }
+        else if (auto whileStmt = dynamic_cast<const WhileStatement*>(&stmt)) {
+            collectSlots(*whileStmt->body);
+        }
+        else if (auto forStmt = dynamic_cast<const ForStatement*>(&stmt)) {
+            if (forStmt->initializer) collectSlots(*forStmt->initializer);
+            collectSlots(*forStmt->body);
+        }
+    }
+
+    int slotOf(const std::string& name, const std::unordered_set<std::string>& defined) const {
+        // Переменная, ещё не объявленная на этом пути, искалась бы в динамическом окружении
+        if (!defined.count(name)) {
+            throw std::runtime_error("variable may be undefined: " + name);
+        }
+        return slots.at(name);
+    }
+
+    void pushNumber() {
+        as.subRsp(8);
+        as.movsdStore(RSP, 0, 0);
+        stackDepth += 8;
+    }
+
+    void popNumber(int xmm) {
+        as.movsdLoad(xmm, RSP, 0);
+        as.addRsp(8);
+        stackDepth -= 8;
+    }
+
+    void expectType(JitType actual, JitType expected) {
+        if (actual != expected) {
+            throw std::runtime_error("unsupported operand types");
+        }
+    }
+
+    void emitReturn() {
+        as.load(RAX, RBP, -8);
+        as.movsdStore(RAX, 0, 0);
+        as.bytes({0x31, 0xC0}); // xor eax, eax
+        as.bytes({0xC9, 0xC3}); // leave; ret
+    }
+
+    void compileStatement(const Statement& stmt, std::unordered_set<std::string>& defined) {
+        if (auto varDecl = dynamic_cast<const VariableDeclaration*>(&stmt)) {
+            if (!varDecl->initializer) throw std::runtime_error("declaration without initializer");
+            expectType(compileExpression(*varDecl->initializer, defined), JitType::NUMBER);
+            as.movsdStore(RBP, slotOffset(slots.at(varDecl->variableName)), 0);
+            defined.insert(varDecl->variableName);
+        }
+        else if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
+            if (assignment->target) throw std::runtime_error("element assignment");
+            int slot = slotOf(assignment->variableName, defined);
+            expectType(compileExpression(*assignment->value, defined), JitType::NUMBER);
+            as.movsdStore(RBP, slotOffset(slot), 0);
+        }
+        else if (auto ifStmt = dynamic_cast<const IfStatement*>(&stmt)) {
+            Label elseLabel, endLabel;
+            expectType(compileExpression(*ifStmt->condition, defined), JitType::BOOLEAN);
+            as.bytes({0x85, 0xC0}); // test eax, eax
+            as.jcc(COND_E, elseLabel);
+            auto thenDefined = defined;
+            compileStatement(*ifStmt->thenBlock, thenDefined);
+            as.jmp(endLabel);
+            as.bind(elseLabel);
+            if (ifStmt->elseBlock) {
+                auto elseDefined = defined;
+                compileStatement(*ifStmt->elseBlock, elseDefined);
+            }
+            as.bind(endLabel);
+        }
+        else if (auto whileStmt = dynamic_cast<const WhileStatement*>(&stmt)) {
+            Label top, end;
+            as.bind(top);
+            expectType(compileExpression(*whileStmt->condition, defined), JitType::BOOLEAN);
+            as.bytes({0x85, 0xC0});
+            as.jcc(COND_E, end);
+            auto bodyDefined = defined;
+            compileStatement(*whileStmt->body, bodyDefined);
+            as.jmp(top);
+            as.bind(end);
+        }
+        else if (auto forStmt = dynamic_cast<const ForStatement*>(&stmt)) {
+            Label top, end;
+            if (forStmt->initializer) compileStatement(*forStmt->initializer, defined);
+            as.bind(top);
+            if (forStmt->condition) {
+                expectType(compileExpression(*forStmt->condition, defined), JitType::BOOLEAN);
+                as.bytes({0x85, 0xC0});
+                as.jcc(COND_E, end);
+            }
+            auto bodyDefined = defined;
+            compileStatement(*forStmt->body, bodyDefined);
+            if (forStmt->increment) compileExpression(*forStmt->increment, defined);
+            as.jmp(top);
+            as.bind(end);
+        }
+        else if (auto returnStmt = dynamic_cast<const ReturnStatement*>(&stmt)) {
+            // return без значения вернул бы null — это делает интерпретатор
+            if (!returnStmt->value) throw std::runtime_error("return without value");
+            expectType(compileExpression(*returnStmt->value, defined), JitType::NUMBER);
+            emitReturn();
+        }
+        else if (auto block = dynamic_cast<const Block*>(&stmt)) {
+            for (const auto& s : block->statements) {
+                compileStatement(*s, defined);
+            }
+        }
+        else if (auto exprStmt = dynamic_cast<const ExpressionStatement*>(&stmt)) {
+            compileExpression(*exprStmt->expression, defined);
+        }
+        else {
+            throw std::runtime_error("unsupported statement");
+        }
+    }
+
+    JitType compileBinary(const BinaryOperation& binOp, const std::unordered_set<std::string>& defined) {
+        const std::string& op = binOp.op;
+        JitType leftType = compileExpression(*binOp.left, defined);
+
+        if (leftType == JitType::BOOLEAN) {
+            as.push(RAX);
+            stackDepth += 8;
+            expectType(compileExpression(*binOp.right, defined), JitType::BOOLEAN);
+            as.pop(RCX);
+            stackDepth -= 8;
+
+            if (op == "and") {
+                as.bytes({0x21, 0xC8}); // and eax, ecx
+            } else if (op == "or") {
+                as.bytes({0x09, 0xC8}); // or eax, ecx
+            } else if (op == "==" || op == "!=") {
+                as.bytes({0x39, 0xC8}); // cmp eax, ecx
+                as.setcc(op == "==" ? COND_E : COND_NE);
+            } else {
+                throw std::runtime_error("unsupported boolean operator: " + op);
+            }
+            return JitType::BOOLEAN;
+        }
+
+        pushNumber();
+        expectType(compileExpression(*binOp.right, defined), JitType::NUMBER);
+        as.movapd(1, 0);
+        popNumber(0); // xmm0 — левый операнд, xmm1 — правый
+
+        if (op == "+") {
+            as.addsd(0, 1);
+        } else if (op == "-") {
+            as.subsd(0, 1);
+        } else if (op == "*") {
+            as.mulsd(0, 1);
+        } else if (op == "/") {
+            // Деление на ноль бросает ошибку — это делает интерпретатор
+            as.xorpd(2, 2);
+            as.ucomisd(1, 2);
+            as.jcc(COND_E, bailout);
+            as.divsd(0, 1);
+        } else if (op == "<") {
+            as.ucomisd(1, 0);
+            as.setcc(COND_A);
+            return JitType::BOOLEAN;
+        } else if (op == "<=") {
+            as.ucomisd(1, 0);
+            as.setcc(COND_AE);
+            return JitType::BOOLEAN;
+        } else if (op == ">") {
+            as.ucomisd(0, 1);
+            as.setcc(COND_A);
+            return JitType::BOOLEAN;
+        } else if (op == ">=") {
+            as.ucomisd(0, 1);
+            as.setcc(COND_AE);
+            return JitType::BOOLEAN;
+        } else if (op == "==" || op == "!=") {
+            // Равенство чисел сравнивает строковые представления — зовём общую функцию
+            bool pad = stackDepth % 16 != 0;
+            if (pad) as.subRsp(8);
+            as.movImm64(RAX, reinterpret_cast<uint64_t>(&jitNumbersEqual));
+            as.bytes({0xFF, 0xD0}); // call rax
+            if (pad) as.addRsp(8);
+            as.bytes({0x0F, 0xB6, 0xC0}); // movzx eax, al
+            if (op == "!=") as.bytes({0x83, 0xF0, 0x01}); // xor eax, 1
+            return JitType::BOOLEAN;
+        } else {
+            throw std::runtime_error("unsupported numeric operator: " + op);
+        }
+        return JitType::NUMBER;
+    }
+
+    JitType compileCall(const FunctionCall& call, const std::unordered_set<std::string>& defined) {
+        auto it = globals.variables.find(call.functionSymbol);
+        if (it == globals.variables.end() || it->second.type != Value::FUNCTION) {
+            throw std::runtime_error("callee is not a global function: " + call.functionName);
+        }
+        JitFunction* callee = jit.find(it->second.body.get());
+        if (!callee) {
+            throw std::runtime_error("callee is not pure: " + call.functionName);
+        }
+        if (callee->parameters.size() != call.arguments.size()) {
+            throw std::runtime_error("wrong number of arguments for " + call.functionName);
+        }
+        callees.emplace_back(call.functionName, callee->body.get());
+
+        // Слот результата и аргументы (первый — по младшему адресу)
+        int32_t argsBytes = static_cast<int32_t>(8 * call.arguments.size());
+        int32_t pad = (stackDepth + argsBytes + 8) % 16 != 0 ? 8 : 0;
+        as.subRsp(pad + 8);
+        stackDepth += pad + 8;
+        for (size_t i = call.arguments.size(); i-- > 0;) {
+            expectType(compileExpression(*call.arguments[i], defined), JitType::NUMBER);
+            pushNumber();
+        }
+
+        as.lea(RDI, RSP, 0);
+        as.lea(RSI, RSP, argsBytes);
+        as.load(RDX, RBP, -16);
+        as.bytes({0x48, 0x83, 0xEA, 0x01}); // sub rdx, 1
+        as.movImm64(RAX, reinterpret_cast<uint64_t>(&callee->code));
+        as.bytes({0xFF, 0x10}); // call [rax]
+        as.bytes({0x85, 0xC0});
+        as.jcc(COND_NE, bailout);
+
+        as.movsdLoad(0, RSP, argsBytes);
+        as.addRsp(argsBytes + 8 + pad);
+        stackDepth -= argsBytes + 8 + pad;
+        return JitType::NUMBER;
+    }
+
+    JitType compileExpression(const Expression& expr, const std::unordered_set<std::string>& defined) {
+        if (auto num = dynamic_cast<const NumberLiteral*>(&expr)) {
+            uint64_t bits;
+            std::memcpy(&bits, &num->value, sizeof(bits));
+            as.movImm64(RAX, bits);
+            as.movqFromRax(0);
+            return JitType::NUMBER;
+        }
+        else if (auto boolean = dynamic_cast<const BooleanLiteral*>(&expr)) {
+            as.movImm32(RAX, boolean->value ? 1 : 0);
+            return JitType::BOOLEAN;
+        }
+        else if (auto id = dynamic_cast<const Identifier*>(&expr)) {
+            as.movsdLoad(0, RBP, slotOffset(slotOf(id->name, defined)));
+            return JitType::NUMBER;
+        }
+        else if (auto binOp = dynamic_cast<const BinaryOperation*>(&expr)) {
+            return compileBinary(*binOp, defined);
+        }
+        else if (auto unOp = dynamic_cast<const UnaryOperation*>(&expr)) {
+            JitType type = compileExpression(*unOp->operand, defined);
+            if (unOp->op == "-" && type == JitType::NUMBER) {
+                as.movImm64(RAX, 0x8000000000000000ULL);
+                as.movqFromRax(1);
+                as.xorpd(0, 1);
+                return JitType::NUMBER;
+            }
+            if (unOp->op == "not" && type == JitType::BOOLEAN) {
+                as.bytes({0x83, 0xF0, 0x01}); // xor eax, 1
+                return JitType::BOOLEAN;
+            }
+            throw std::runtime_error("unsupported unary operation: " + unOp->op);
+        }
+        else if (auto call = dynamic_cast<const FunctionCall*>(&expr)) {
+            return compileCall(*call, defined);
+        }
+        throw std::runtime_error("unsupported expression");
+    }
+
+public:
+    FunctionCompiler(Jit& jit, JitFunction& function, const Environment& globals)
+        : jit(jit), function(function), globals(globals), stackDepth(0) {}
+
+    std::vector<uint8_t> compile() {
+        std::unordered_set<std::string> defined;
+        for (const auto& param : function.parameters) {
+            slots.emplace(param, static_cast<int>(slots.size()));
+            defined.insert(param);
+        }
+        collectSlots(*function.body);
+
+        int32_t frameSize = static_cast<int32_t>(16 + 8 * slots.size());
+        frameSize = (frameSize + 15) / 16 * 16;
+
+        as.push(RBP);
+        as.bytes({0x48, 0x89, 0xE5}); // mov rbp, rsp
+        as.subRsp(frameSize);
+        as.store(RBP, -8, RSI);
+        as.store(RBP, -16, RDX);
+        as.bytes({0x48, 0x85, 0xD2}); // test rdx, rdx
+        as.jcc(COND_LE, bailout);
+
+        for (size_t i = 0; i < function.parameters.size(); i++) {
+            as.movsdLoad(0, RDI, static_cast<int32_t>(8 * i));
+            as.movsdStore(RBP, slotOffset(slots.at(function.parameters[i])), 0);
+        }
+
+        compileStatement(*function.body, defined);
+
+        // Выход без return (результат null) и все отказы
+        as.bind(bailout);
+        as.movImm32(RAX, 1);
+        as.bytes({0xC9, 0xC3}); // leave; ret
+        return as.code;
+    }
+
+    const std::vector<std::pair<std::string, const Block*>>& calledFunctions() const { return callees; }
+};
+
+void* allocateExecutable(const std::vector<uint8_t>& code, size_t& size) {
+#ifdef JIT_X64
+    long page = sysconf(_SC_PAGESIZE);
+    size = (code.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    return memory;
+#else
+    (void)code;
+    size = 0;
+    return nullptr;
+#endif
+}
+
+void freeExecutable(void* memory, size_t size) {
+#ifdef JIT_X64
+    if (memory) munmap(memory, size);
+#else
+    (void)memory;
+    (void)size;
+#endif
+}
+
+} // namespace
+
+Jit::Jit(size_t threshold) : threshold(threshold), stubMemory(nullptr), stubSize(0), bailoutStub(nullptr) {
+    // Заглушка для ещё не скомпилированных вызываемых: mov eax, 1; ret
+    stubMemory = allocateExecutable({0xB8, 0x01, 0x00, 0x00, 0x00, 0xC3}, stubSize);
+    bailoutStub = reinterpret_cast<JitCode>(stubMemory);
+}
+
+Jit::~Jit() {
+    for (auto& [body, function] : functions) {
+        release(*function);
+    }
+    freeExecutable(stubMemory, stubSize);
+}
+
+bool Jit::isSupported() {
+#ifdef JIT_X64
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Jit::registerFunction(const std::string& name, const std::vector<std::string>& parameters,
+                           std::shared_ptr<Block> body) {
+    auto function = std::make_unique<JitFunction>();
+    function->name = name;
+    function->parameters = parameters;
+    function->body = body;
+    function->code = bailoutStub;
+    if (!bailoutStub) {
+        function->state = JitFunction::FAILED;
+        function->failure = "JIT is not supported on this platform";
+    }
+    functions[body.get()] = std::move(function);
+}
+
+void Jit::onBinding(const std::string& name, const Block* body) {
+    auto it = boundCallees.find(name);
+    if (it == boundCallees.end() || it->second == body) return;
+
+    // Машинный код вызывает прежнюю функцию напрямую — выбрасываем его
+    for (auto& [key, function] : functions) {
+        for (const auto& callee : function->callees) {
+            if (callee == name && function->state == JitFunction::COMPILED) {
+                release(*function);
+                function->state = JitFunction::FAILED;
+                function->failure = "callee rebound: " + name;
+                break;
+            }
+        }
+    }
+    boundCallees.erase(it);
+}
+
+JitFunction* Jit::find(const Block* body) {
+    auto it = functions.find(body);
+    return it != functions.end() ? it->second.get() : nullptr;
+}
+
+bool Jit::compile(JitFunction& function, const Environment& globals) {
+    function.state = JitFunction::COMPILING;
+
+    std::vector<std::pair<std::string, const Block*>> called;
+    try {
+        FunctionCompiler compiler(*this, function, globals);
+        std::vector<uint8_t> code = compiler.compile();
+        function.memory = allocateExecutable(code, function.memorySize);
+        if (!function.memory) {
+            throw std::runtime_error("cannot allocate executable memory");
+        }
+        called = compiler.calledFunctions();
+    } catch (const std::exception& e) {
+        function.state = JitFunction::FAILED;
+        function.failure = e.what();
+        function.code = bailoutStub;
+        return false;
+    }
+
+    function.code = reinterpret_cast<JitCode>(function.memory);
+    function.state = JitFunction::COMPILED;
+    for (const auto& [name, body] : called) {
+        function.callees.push_back(name);
+        boundCallees[name] = body;
+    }
+
+    // Вызываемые компилируются сразу: до этого их слот указывает на заглушку
+    for (const auto& [name, body] : called) {
+        JitFunction* callee = find(body);
+        if (callee && callee->state == JitFunction::INTERPRETED) {
+            compile(*callee, globals);
+        }
+    }
+    return true;
+}
+
+void Jit::release(JitFunction& function) {
+    freeExecutable(function.memory, function.memorySize);
+    function.memory = nullptr;
+    function.memorySize = 0;
+    function.code = bailoutStub;
+    function.callees.clear();
+}
+
+bool Jit::tryCall(const Block* body, const std::vector<Value>& args, const Environment& globals, Value& result) {
+    JitFunction* function = find(body);
+    if (!function) return false;
+
+    function->callCount++;
+    if (function->state == JitFunction::INTERPRETED && function->callCount >= threshold) {
+        compile(*function, globals);
+    }
+    if (function->state != JitFunction::COMPILED || args.size() != function->parameters.size()) {
+        return false;
+    }
+
+    // Защита входа: машинный код работает только с числами
+    double stackArgs[8];
+    std::vector<double> heapArgs;
+    double* nativeArgs = stackArgs;
+    if (args.size() > 8) {
+        heapArgs.resize(args.size());
+        nativeArgs = heapArgs.data();
+    }
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i].type != Value::NUMBER) return false;
+        nativeArgs[i] = args[i].numberValue;
+    }
+
+    double nativeResult;
+    if (function->code(nativeArgs, &nativeResult, JIT_MAX_DEPTH) != 0) {
+        // Следующие вызовы, в том числе из машинного кода через слот code,
+        // сразу идут в интерпретатор
+        function->bailouts++;
+        release(*function);
+        function->state = JitFunction::DEOPTIMIZED;
+        return false;
+    }
+
+    function->nativeCalls++;
+    result = Value(nativeResult);
+    return true;
+}
+
+void Jit::printStats(std::ostream& os) const {
+    os << "JIT:" << std::endl;
+    for (const auto& [body, function] : functions) {
+        os << "  " << function->name << ": calls=" << function->callCount;
+        switch (function->state) {
+            case JitFunction::COMPILED:
+                os << " compiled (" << function->memorySize << " bytes)"
+                   << " native=" << function->nativeCalls
+                   << " bailouts=" << function->bailouts;
+                break;
+            case JitFunction::FAILED:
+                os << " not compiled: " << function->failure;
+                break;
+            case JitFunction::DEOPTIMIZED:
+                os << " deoptimized after bailout, native=" << function->nativeCalls;
+                break;
+            default:
+                os << " interpreted";
+                break;
+        }
+        os << std::endl;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "ast.h"
+#include "environment.h"
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Сигнатура скомпилированной функции: аргументы, адрес результата и
+// оставшаяся глубина рекурсии. Возвращает 0 при успехе и 1, если нужно
+// выполнить вызов в интерпретаторе (деление на ноль, неподдерживаемый путь).
+using JitCode = int (*)(const double* args, double* result, long depth);
+
+// Чистая функция — кандидат на компиляцию
+struct JitFunction {
+    // DEOPTIMIZED — машинный код отказал и выброшен: иначе каждый вызов
+    // сначала пробовал бы его и повторял работу в интерпретаторе
+    enum State { INTERPRETED, COMPILING, COMPILED, FAILED, DEOPTIMIZED };
+
+    std::string name;
+    std::vector<std::string> parameters;
+    std::shared_ptr<Block> body;
+    State state = INTERPRETED;
+    JitCode code = nullptr;         // Через этот слот идут и вызовы из другого машинного кода
+    void* memory = nullptr;
+    size_t memorySize = 0;
+    std::vector<std::string> callees;
+    std::string failure;
+    size_t callCount = 0;
+    size_t nativeCalls = 0;
+    size_t bailouts = 0;
+};
+
+// Базовый JIT-компилятор x86-64 для горячих чистых числовых функций.
+// Машинный код не имеет побочных эффектов, поэтому при любом отказе
+// вызов просто повторяется в интерпретаторе.
+class Jit {
+private:
+    size_t threshold;
+    void* stubMemory;
+    size_t stubSize;
+    JitCode bailoutStub;
+    std::unordered_map<const Block*, std::unique_ptr<JitFunction>> functions;
+    std::unordered_map<std::string, const Block*> boundCallees; // Имя вызываемой -> тело, с которым скомпилированы
+
+    bool compile(JitFunction& function, const Environment& globals);
+    void release(JitFunction& function);
+
+public:
+    explicit Jit(size_t threshold);
+    ~Jit();
+    Jit(const Jit&) = delete;
+    Jit& operator=(const Jit&) = delete;
+
+    static bool isSupported();
+
+    void registerFunction(const std::string& name, const std::vector<std::string>& parameters,
+                          std::shared_ptr<Block> body);
+    // Новое связывание имени (body == nullptr, если значение не функция) могло
+    // перекрыть функцию, которую машинный код вызывает напрямую
+    void onBinding(const std::string& name, const Block* body);
+    // true — вызов выполнен машинным кодом, результат записан в result
+    bool tryCall(const Block* body, const std::vector<Value>& args, const Environment& globals, Value& result);
+
+    JitFunction* find(const Block* body);
+    void printStats(std::ostream& os) const;
+};
+
+#endif // JIT_H
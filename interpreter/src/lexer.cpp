@@ -93,6 +93,10 @@ Token Lexer::identifier() {
     else if (text == "or") type = TokenType::OR;
     else if (text == "not") type = TokenType::NOT;
     else if (text == "null") type = TokenType::NULL_TOKEN;
+    else if (text == "async") type = TokenType::ASYNC;
+    else if (text == "await") type = TokenType::AWAIT;
+    else if (text == "in") type = TokenType::IN;
+    else if (text == "yield") type = TokenType::YIELD;
 
     return Token(type, text, line, column);
 }
@@ -114,7 +118,14 @@ void Lexer::skipWhitespace() {
             case '/':
                 if (peekNext() == '/') {
                     // Комментарий до конца строки
+                    int commentStart = current;
                     while (peekChar() != '\n' && !isAtEnd()) advance();
+                    
+                    // Прагма: "// @имя аргументы"
+                    size_t at = source.find_first_not_of("/ \t", commentStart);
+                    if (at < static_cast<size_t>(current) && source[at] == '@') {
+                        pragmas.push_back(source.substr(at + 1, current - at - 1));
+                    }
                 } else {
                     return;
                 }
@@ -175,6 +186,7 @@ Token Lexer::scanToken() {
         case '[': return Token(TokenType::LEFT_BRACKET, "[", line, column);
         case ']': return Token(TokenType::RIGHT_BRACKET, "]", line, column);
         case ':': return Token(TokenType::COLON, ":", line, column);
+        case '.': return Token(TokenType::DOT, ".", line, column);
     }
 
     return Token(TokenType::ERROR, std::string(1, c), line, column);
@@ -190,6 +202,7 @@ Token Lexer::peek() {
     int savedCurrent = current;
     int savedLine = line;
     int savedColumn = column;
+    size_t savedPragmas = pragmas.size();
     
     // Получаем следующий токен
     Token token = getNextToken();
@@ -199,6 +212,11 @@ Token Lexer::peek() {
     current = savedCurrent;
     line = savedLine;
     column = savedColumn;
+    pragmas.resize(savedPragmas);
     
     return token;
+}
+
+const std::vector<std::string>& Lexer::getPragmas() const {
+    return pragmas;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define LEXER_H
 
 #include <string>
+#include <vector>
 #include "token.h"  // Используем Token из token.h
 
 class Lexer {
@@ -11,6 +12,7 @@ private:
     int current;
     int line;
     int column;
+    std::vector<std::string> pragmas; // Комментарии вида "// @memoize"
 
     char advance();
     char peekChar();
@@ -31,6 +33,7 @@ public:
     Lexer(const std::string& source);
     Token getNextToken();
     Token peek();
+    const std::vector<std::string>& getPragmas() const;
 };
 
 #endif // LEXER_H
\ No newline at end of file
@@ -1,74 +1,824 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
 #include "lexer.h"
 #include "parser.h"
 #include "interpreter.h"
+#include "purity.h"
+#include "cppemitter.h"
+#include "isolate.h"
+#include "scheduler.h"
+#include "server.h"
+#include "snapshot.h"
+#include "script.h"
+#include "threadpool.h"
+#include "vm.h"
+
+// Размер LRU-кэша мемоизации по умолчанию
+const size_t DEFAULT_MEMO_CAPACITY = 1024;
+// Число вызовов, после которого функция компилируется JIT
+const size_t DEFAULT_JIT_THRESHOLD = 10;
+// Число итераций, после которого цикл трассируется
+const size_t DEFAULT_TRACE_THRESHOLD = 50;
+
+struct Options {
+    std::string filename;
+    size_t memoCapacity = 0;
+    bool jit = false;
+    size_t jitThreshold = DEFAULT_JIT_THRESHOLD;
+    bool traceJit = false;
+    size_t traceThreshold = DEFAULT_TRACE_THRESHOLD;
+    bool stats = false;
+    size_t repeat = 1;
+    size_t isolates = 0; // 0 — выполнять в главном потоке
+    std::string batchManifest;
+    size_t threads = 0;  // 0 — по числу ядер
+    double timeSlice = 0; // мс; 0 — скрипты пакета выполняются без вытеснения
+    std::string snapshot;    // --snapshot: глобальные из снимка до выполнения скрипта
+    std::string snapshotOut; // --snapshot-out: записать глобальные после выполнения
+    std::string serve;  // --serve: сокет службы
+    std::string client; // --client: сокет службы, к которой отправлять запросы
+    size_t connections = 1;
+    std::string input;  // --input: ввод скрипта для --client
+    bool shutdown = false;
+    size_t maxDepth = DEFAULT_MAX_CALL_DEPTH;
+    bool vm = false;
+    bool vmProfile = false;
+    bool emitCpp = false;
+    std::string emitPath; // Пусто — в stdout
+};
 
 std::string readFile(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         throw std::runtime_error("Could not open file: " + filename);
     }
-    
+
     std::stringstream buffer;
     buffer << file.rdbuf();
     return buffer.str();
 }
 
-void runRepl() {
+// Прагмы в комментариях скрипта включают оптимизации без флагов командной строки
+void applyPragmas(const std::vector<std::string>& pragmas, Options& options) {
+    for (const auto& pragma : pragmas) {
+        std::istringstream words(pragma);
+        std::string name;
+        words >> name;
+
+        if (name == "memoize") {
+            size_t capacity = DEFAULT_MEMO_CAPACITY;
+            words >> capacity;
+            options.memoCapacity = capacity;
+        }
+    }
+}
+
+void configure(Interpreter& interpreter, const Options& options) {
+    interpreter.setMaxCallDepth(options.maxDepth);
+    interpreter.enableMemoization(options.memoCapacity);
+    if (options.jit) {
+        interpreter.enableJit(options.jitThreshold);
+    }
+    if (options.traceJit) {
+        interpreter.enableTracing(options.traceThreshold);
+    }
+    if (!options.snapshot.empty()) {
+        interpreter.loadSnapshot(options.snapshot);
+    }
+}
+
+void runRepl(const Options& options) {
     Interpreter interpreter;
+    Vm vm;
+    vm.setMaxCallDepth(options.maxDepth);
+    if (options.vmProfile) {
+        vm.enableProfiling();
+    }
+    configure(interpreter, options);
     std::string line;
-    
+
     std::cout << "Interpreter REPL. Type 'exit' to quit.\n";
-    
+
     while (true) {
         std::cout << "> ";
         std::getline(std::cin, line);
-        
+
         if (line == "exit" || line == "quit") {
             break;
         }
-        
+
         if (line.empty()) {
             continue;
         }
-        
+
         try {
             Lexer lexer(line);
             Parser parser(lexer);
             auto program = parser.parse();
-            
+
+            // Как в Script: чистоту проверяют мемоизация, JIT и parallelMap
+            PurityAnalyzer().analyze(*program);
+
+            // Байткод-VM вместо обхода AST; мемоизация и JIT есть только у интерпретатора
+            if (options.vm) {
+                vm.interpret(*program);
+                continue;
+            }
+
             // Приводим тип к Program&
             interpreter.interpret(static_cast<Program&>(*program));
         } catch (const std::exception& e) {
             std::cerr << "Error: " << e.what() << std::endl;
         }
     }
+
+    if (options.vmProfile) {
+        vm.printStats(std::cerr);
+    } else if (options.stats) {
+        interpreter.printStats(std::cerr);
+    }
+}
+
+// Ahead-of-time режим: вместо выполнения печатаем программу на C++
+int emitCpp(const Program& program, const Options& options) {
+    std::string code = CppEmitter().emit(program, options.filename, options.maxDepth);
+    if (options.emitPath.empty()) {
+        std::cout << code;
+        return 0;
+    }
+    
+    std::ofstream file(options.emitPath);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not write file: " + options.emitPath);
+    }
+    file << code;
+    return 0;
+}
+
+using Clock = std::chrono::steady_clock;
+
+double microsecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// --repeat=N: скрипт разобран один раз и выполняется N раз в сброшенном
+// интерпретаторе; в stderr — время разбора и задержка одного запуска
+void runRepeated(const Script& script, Interpreter& interpreter, const Options& options,
+                 double parseMicroseconds) {
+    double total = 0;
+    double best = 0;
+    for (size_t i = 0; i < options.repeat; i++) {
+        interpreter.reset();
+        Clock::time_point start = Clock::now();
+        script.run(interpreter);
+        double elapsed = microsecondsSince(start);
+        total += elapsed;
+        best = i == 0 ? elapsed : std::min(best, elapsed);
+    }
+    std::cerr << "Script: parse=" << parseMicroseconds << "us runs=" << options.repeat
+              << " mean=" << total / static_cast<double>(options.repeat) << "us best=" << best << "us"
+              << std::endl;
+}
+
+// --isolates=N: нагрузочная проверка изолятов. N потоков выполняют один
+// разобранный скрипт (каждый --repeat раз), вывод всех запусков должен совпасть
+// и печатается один раз — как при обычном выполнении.
+int runIsolates(const Script& script, const Options& options) {
+    struct Result {
+        std::vector<std::string> outputs; // Вывод и ошибки каждого запуска
+        std::exception_ptr failure;
+    };
+    std::vector<Result> results(options.isolates);
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < options.isolates; i++) {
+        threads.emplace_back([&script, &options, &result = results[i]] {
+            try {
+                Isolate isolate;
+                configure(isolate.getInterpreter(), options);
+                for (size_t run = 0; run < options.repeat; run++) {
+                    isolate.run(script);
+                    result.outputs.push_back(isolate.takeOutput());
+                    result.outputs.push_back(isolate.takeErrors());
+                }
+            } catch (...) {
+                result.failure = std::current_exception();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = microsecondsSince(start);
+
+    // Исключение вне std::exception (return вне функции) завершает процесс, как без изолятов
+    for (const Result& result : results) {
+        if (result.failure) std::rethrow_exception(result.failure);
+    }
+    const std::vector<std::string>& first = results[0].outputs;
+    for (const Result& result : results) {
+        for (size_t i = 0; i < result.outputs.size(); i++) {
+            if (result.outputs[i] != first[i % 2]) {
+                std::cerr << "Error: isolate output differs" << std::endl;
+                return 1;
+            }
+        }
+    }
+    std::cout << first[0] << std::flush;
+    std::cerr << first[1];
+
+    if (options.stats) {
+        size_t runs = options.isolates * options.repeat;
+        std::cerr << "Isolates: threads=" << options.isolates << " runs=" << runs
+                  << " wall=" << elapsed / 1000 << "ms throughput="
+                  << static_cast<double>(runs) / (elapsed / 1e6) << "/s" << std::endl;
+    }
+    return 0;
+}
+
+// Скрипт из манифеста --batch, разобранный один раз на все его строки
+struct BatchScript {
+    std::unique_ptr<Script> script;
+    std::string errors; // Ошибки чтения и разбора — часть вывода каждого запуска
+};
+
+struct BatchJob {
+    const BatchScript* script;
+    std::vector<std::pair<std::string, Value>> inputs;
+    unsigned priority = 1; // priority=N в манифесте, для --time-slice
+    std::string output;
+    std::string errors;
+    double latency = 0; // мкс от запуска пакета до конца скрипта
+    bool done = false;
+};
+
+void runBatchJob(BatchJob& job, Isolate& isolate) {
+    job.errors = job.script->errors;
+    if (!job.script->script) return;
+    bool completed = true;
+    try {
+        isolate.run(*job.script->script, job.inputs);
+    } catch (const Coroutine::Cancelled&) {
+        throw;
+    } catch (...) {
+        // return вне функции: без пакета он завершил бы процесс
+        completed = false;
+    }
+    job.output = isolate.takeOutput();
+    job.errors += isolate.takeErrors();
+    if (!completed) {
+        job.errors += "Error: script terminated by return outside a function\n";
+    }
+}
+
+// Parser печатает ошибки в std::cerr; здесь они попадают в вывод своего скрипта.
+// Разбор идёт в главном потоке до запуска пула, подменять std::cerr безопасно.
+BatchScript prepareBatchScript(const std::string& path) {
+    BatchScript prepared;
+    std::ostringstream parseErrors;
+    std::streambuf* saved = std::cerr.rdbuf(parseErrors.rdbuf());
+    try {
+        prepared.script = std::make_unique<Script>(readFile(path));
+    } catch (const std::exception& e) {
+        parseErrors << "Error: " << e.what() << std::endl;
+    }
+    std::cerr.rdbuf(saved);
+    prepared.errors = parseErrors.str();
+    return prepared;
+}
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(values.size() - 1) + 0.5);
+    return values[index];
+}
+
+// Строка манифеста --batch (и запросов --client)
+struct ManifestEntry {
+    std::string path; // Относительно текущего каталога
+    unsigned priority = 1;
+    std::string input; // Пусто — без ввода
+};
+
+// Каждая строка манифеста — путь к скрипту (относительно манифеста) и, через
+// пробел, необязательные priority=N и ввод. false — ошибка уже напечатана.
+bool readManifest(const std::string& filename, std::vector<ManifestEntry>& entries) {
+    std::ifstream manifest(filename);
+    if (!manifest.is_open()) {
+        std::cerr << "Error: Could not open file: " << filename << std::endl;
+        return false;
+    }
+    std::filesystem::path base = std::filesystem::path(filename).parent_path();
+
+    std::string line;
+    while (std::getline(manifest, line)) {
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+        size_t pathEnd = line.find_first_of(" \t\r", start);
+        ManifestEntry entry;
+        entry.path = (base / line.substr(start, pathEnd - start)).string();
+        size_t inputStart = pathEnd == std::string::npos ? pathEnd : line.find_first_not_of(" \t\r", pathEnd);
+        if (inputStart != std::string::npos && line.compare(inputStart, 9, "priority=") == 0) {
+            size_t priorityEnd = line.find_first_of(" \t\r", inputStart);
+            try {
+                entry.priority = static_cast<unsigned>(std::stoul(line.substr(inputStart + 9, priorityEnd - inputStart - 9)));
+            } catch (const std::exception&) {
+                entry.priority = 0;
+            }
+            if (entry.priority == 0) {
+                std::cerr << "Error: invalid priority in manifest line: " << line << std::endl;
+                return false;
+            }
+            inputStart = priorityEnd == std::string::npos ? priorityEnd : line.find_first_not_of(" \t\r", priorityEnd);
+        }
+        if (inputStart != std::string::npos) {
+            size_t inputEnd = line.find_last_not_of(" \t\r");
+            entry.input = line.substr(inputStart, inputEnd - inputStart + 1);
+        }
+        entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+// --batch MANIFEST: строки манифеста (readManifest) выполняются на пуле
+// потоков, у каждого работника свой изолят. priority=N — доля времени при
+// --time-slice, ввод доступен скрипту как глобальная input. Вывод каждого
+// скрипта копится отдельно и печатается в порядке манифеста.
+int runBatch(const Options& options) {
+    std::vector<ManifestEntry> entries;
+    if (!readManifest(options.batchManifest, entries)) {
+        return 1;
+    }
+
+    std::unordered_map<std::string, BatchScript> scripts;
+    std::vector<BatchJob> jobs;
+    for (const ManifestEntry& entry : entries) {
+        auto found = scripts.find(entry.path);
+        if (found == scripts.end()) {
+            found = scripts.emplace(entry.path, prepareBatchScript(entry.path)).first;
+        }
+        BatchJob job;
+        job.script = &found->second;
+        job.priority = entry.priority;
+        if (!entry.input.empty()) {
+            job.inputs.emplace_back("input", scriptInput(entry.input));
+        }
+        jobs.push_back(std::move(job));
+    }
+
+    size_t threadCount = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::mutex doneMutex;
+    std::condition_variable jobDone;
+    auto finish = [&doneMutex, &jobDone](BatchJob& job) {
+        {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            job.done = true;
+        }
+        jobDone.notify_all();
+    };
+    // Вывод печатается по порядку, как только готов очередной скрипт
+    auto printInOrder = [&jobs, &doneMutex, &jobDone] {
+        for (BatchJob& job : jobs) {
+            {
+                std::unique_lock<std::mutex> lock(doneMutex);
+                jobDone.wait(lock, [&job] { return job.done; });
+            }
+            std::cout << job.output << std::flush;
+            std::cerr << job.errors;
+            std::string().swap(job.output);
+            std::string().swap(job.errors);
+        }
+    };
+    std::atomic<size_t> switches{0};
+    Clock::time_point start = Clock::now();
+    if (options.timeSlice > 0) {
+        // --time-slice: скрипты раздаются потокам по кругу, и в каждом потоке
+        // планировщик делит время между ними по приоритетам. Долгий скрипт
+        // не задерживает короткие, попавшие в тот же поток, дольше кванта.
+        auto slice = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(options.timeSlice));
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < std::min(threadCount, jobs.size()); t++) {
+            threads.emplace_back([t, slice, threadCount, start, &jobs, &options, &finish, &switches] {
+                Scheduler scheduler(slice);
+                for (size_t i = t; i < jobs.size(); i += threadCount) {
+                    BatchJob& job = jobs[i];
+                    // Приостановленный скрипт держит состояние интерпретатора: изолят на скрипт
+                    scheduler.spawn([&job, &options, &finish, start] {
+                        Isolate isolate;
+                        configure(isolate.getInterpreter(), options);
+                        isolate.getInterpreter().setPreemption(Scheduler::CHECKPOINT_INTERVAL,
+                                                               Scheduler::checkpoint);
+                        runBatchJob(job, isolate);
+                        job.latency = microsecondsSince(start);
+                        finish(job);
+                    }, job.priority);
+                }
+                scheduler.run();
+                switches += scheduler.switches();
+            });
+        }
+        printInOrder();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    } else {
+        ThreadPool pool(threadCount);
+        // Изолят на работника: кэши и JIT переживают скрипты одного работника
+        std::vector<std::unique_ptr<Isolate>> isolates(pool.size());
+
+        for (BatchJob& job : jobs) {
+            pool.submit([&pool, &job, &isolates, &options, &finish, start] {
+                std::unique_ptr<Isolate>& isolate = isolates[pool.currentWorker()];
+                if (!isolate) {
+                    isolate = std::make_unique<Isolate>();
+                    configure(isolate->getInterpreter(), options);
+                }
+                runBatchJob(job, *isolate);
+                job.latency = microsecondsSince(start);
+                finish(job);
+            });
+        }
+        printInOrder();
+    }
+    double elapsed = microsecondsSince(start);
+
+    std::vector<double> latencies;
+    for (const BatchJob& job : jobs) {
+        latencies.push_back(job.latency);
+    }
+    std::cerr << "Batch: scripts=" << jobs.size() << " threads=" << threadCount
+              << " wall=" << elapsed / 1000 << "ms throughput="
+              << (elapsed > 0 ? static_cast<double>(jobs.size()) / (elapsed / 1e6) : 0) << "/s"
+              << " p50=" << percentile(latencies, 0.5) << "us p99=" << percentile(latencies, 0.99) << "us";
+    if (options.timeSlice > 0) {
+        std::cerr << " slice=" << options.timeSlice << "ms switches=" << switches;
+    }
+    std::cerr << std::endl;
+    return 0;
+}
+
+// --serve SOCKET: служба с тёплыми интерпретаторами (server.h), по одному
+// на поток пула; каждый настроен как при обычном запуске, с --snapshot
+int runServe(const Options& options) {
+    size_t threadCount = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    try {
+        Server server(options.serve, threadCount, [&options](Interpreter& interpreter) {
+            configure(interpreter, options);
+        });
+        server.run();
+        if (options.stats) {
+            server.printStats(std::cerr);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Сколько клиент ждёт, пока служба, запущенная вместе с ним, начнёт слушать
+const std::chrono::milliseconds CLIENT_CONNECT_TIMEOUT(5000);
+
+// --client SOCKET: отправить службе скрипт (с --input) или строки манифеста
+// --batch. Один запрос печатает вывод по мере прихода. Иначе это нагрузочный
+// тест: --repeat проходов по запросам через --connections соединений; вывод
+// первого ответа на каждую строку печатается в порядке манифеста, остальные
+// ответы должны с ним совпасть. В stderr — пропускная способность и задержки.
+int runClient(const Options& options) {
+    std::vector<ManifestEntry> entries;
+    if (!options.batchManifest.empty()) {
+        if (!readManifest(options.batchManifest, entries)) {
+            return 1;
+        }
+    } else if (!options.filename.empty()) {
+        entries.push_back({options.filename, 1, options.input});
+    }
+    // Пути отправляются абсолютными: у службы свой текущий каталог
+    for (ManifestEntry& entry : entries) {
+        entry.path = std::filesystem::absolute(entry.path).string();
+    }
+
+    try {
+        size_t total = entries.size() * options.repeat;
+        if (total == 1 && options.connections == 1) {
+            ServerClient client(options.client, CLIENT_CONNECT_TIMEOUT);
+            Clock::time_point start = Clock::now();
+            client.run(entries[0].path, entries[0].input, std::cout, std::cerr);
+            if (options.stats) {
+                std::cerr << "Request: latency=" << microsecondsSince(start) << "us" << std::endl;
+            }
+        } else if (total > 0) {
+            struct Response {
+                std::string output;
+                std::string errors;
+                bool received = false;
+            };
+            std::vector<Response> first(entries.size());
+            std::vector<double> latencies(total);
+            std::atomic<size_t> next{0};
+            size_t mismatched = 0;
+            std::mutex responseMutex;
+            std::vector<std::exception_ptr> failures(options.connections);
+
+            Clock::time_point start = Clock::now();
+            std::vector<std::thread> threads;
+            for (size_t c = 0; c < options.connections; c++) {
+                threads.emplace_back([&, c] {
+                    try {
+                        ServerClient client(options.client, CLIENT_CONNECT_TIMEOUT);
+                        for (size_t i = next++; i < total; i = next++) {
+                            const ManifestEntry& entry = entries[i % entries.size()];
+                            std::ostringstream output;
+                            std::ostringstream errors;
+                            Clock::time_point sent = Clock::now();
+                            client.run(entry.path, entry.input, output, errors);
+                            latencies[i] = microsecondsSince(sent);
+
+                            std::lock_guard<std::mutex> lock(responseMutex);
+                            Response& response = first[i % entries.size()];
+                            if (!response.received) {
+                                response = {output.str(), errors.str(), true};
+                            } else if (response.output != output.str() || response.errors != errors.str()) {
+                                mismatched++;
+                            }
+                        }
+                    } catch (...) {
+                        failures[c] = std::current_exception();
+                    }
+                });
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+            double elapsed = microsecondsSince(start);
+            for (const std::exception_ptr& failure : failures) {
+                if (failure) std::rethrow_exception(failure);
+            }
+
+            for (const Response& response : first) {
+                std::cout << response.output << std::flush;
+                std::cerr << response.errors;
+            }
+            std::cerr << "Load: requests=" << total << " connections=" << options.connections
+                      << " wall=" << elapsed / 1000 << "ms throughput="
+                      << (elapsed > 0 ? static_cast<double>(total) / (elapsed / 1e6) : 0) << "/s"
+                      << " p50=" << percentile(latencies, 0.5) << "us p90=" << percentile(latencies, 0.9)
+                      << "us p99=" << percentile(latencies, 0.99) << "us max=" << percentile(latencies, 1)
+                      << "us" << std::endl;
+            if (mismatched > 0) {
+                std::cerr << "Error: " << mismatched << " responses differ from the first response to their script"
+                          << std::endl;
+                return 1;
+            }
+        }
+
+        if (options.shutdown) {
+            ServerClient(options.client, CLIENT_CONNECT_TIMEOUT).shutdown();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int runFile(Options options) {
+    try {
+        std::string source = readFile(options.filename);
+        Clock::time_point parseStart = Clock::now();
+        Script script(source);
+        double parseMicroseconds = microsecondsSince(parseStart);
+        applyPragmas(script.getPragmas(), options);
+        
+        if (options.emitCpp) {
+            return emitCpp(script.getProgram(), options);
+        }
+
+        if (options.vm) {
+            Vm vm;
+            vm.setMaxCallDepth(options.maxDepth);
+            if (options.vmProfile) {
+                vm.enableProfiling();
+            }
+            vm.interpret(script.getProgram());
+            vm.printStats(std::cerr);
+            return 0;
+        }
+
+        if (options.isolates > 0) {
+            return runIsolates(script, options);
+        }
+
+        Interpreter interpreter;
+        Clock::time_point configureStart = Clock::now();
+        configure(interpreter, options);
+        double configureMicroseconds = microsecondsSince(configureStart);
+
+        if (options.repeat > 1) {
+            runRepeated(script, interpreter, options, parseMicroseconds);
+        } else {
+            script.run(interpreter);
+        }
+
+        size_t snapshotBytes = 0;
+        if (!options.snapshotOut.empty()) {
+            snapshotBytes = interpreter.saveSnapshot(options.snapshotOut);
+        }
+
+        if (options.stats) {
+            // Холодный старт: разбор скрипта и восстановление снимка
+            std::cerr << "Startup: parse=" << parseMicroseconds << "us";
+            if (!options.snapshot.empty()) {
+                std::cerr << " snapshot=" << configureMicroseconds << "us";
+            }
+            std::cerr << std::endl;
+            if (snapshotBytes > 0) {
+                std::cerr << "Snapshot: " << options.snapshotOut << " bytes=" << snapshotBytes << std::endl;
+            }
+            interpreter.printStats(std::cerr);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--memoize") {
+            options.memoCapacity = DEFAULT_MEMO_CAPACITY;
+        } else if (arg.rfind("--memoize=", 0) == 0) {
+            try {
+                options.memoCapacity = std::stoul(arg.substr(10));
+            } catch (const std::exception&) {
+                return false;
+            }
+        } else if (arg == "--jit") {
+            options.jit = true;
+        } else if (arg.rfind("--jit-threshold=", 0) == 0) {
+            try {
+                options.jit = true;
+                options.jitThreshold = std::stoul(arg.substr(16));
+            } catch (const std::exception&) {
+                return false;
+            }
+        } else if (arg == "--trace-jit") {
+            options.traceJit = true;
+        } else if (arg.rfind("--trace-threshold=", 0) == 0) {
+            try {
+                options.traceJit = true;
+                options.traceThreshold = std::stoul(arg.substr(18));
+            } catch (const std::exception&) {
+                return false;
+            }
+        } else if (arg == "--vm") {
+            options.vm = true;
+        } else if (arg == "--vm-profile") {
+            options.vm = true;
+            options.vmProfile = true;
+        } else if (arg == "--emit-cpp") {
+            options.emitCpp = true;
+        } else if (arg.rfind("--emit-cpp=", 0) == 0) {
+            options.emitCpp = true;
+            options.emitPath = arg.substr(11);
+        } else if (arg.rfind("--max-depth=", 0) == 0) {
+            try {
+                options.maxDepth = std::stoul(arg.substr(12));
+            } catch (const std::exception&) {
+                return false;
+            }
+        } else if (arg.rfind("--repeat=", 0) == 0) {
+            try {
+                options.repeat = std::stoul(arg.substr(9));
+            } catch (const std::exception&) {
+                return false;
+            }
+            if (options.repeat == 0) return false;
+        } else if (arg == "--batch" && i + 1 < argc) {
+            options.batchManifest = argv[++i];
+        } else if (arg.rfind("--batch=", 0) == 0) {
+            options.batchManifest = arg.substr(8);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            try {
+                options.threads = std::stoul(arg.substr(10));
+            } catch (const std::exception&) {
+                return false;
+            }
+        } else if (arg.rfind("--time-slice=", 0) == 0) {
+            try {
+                options.timeSlice = std::stod(arg.substr(13));
+            } catch (const std::exception&) {
+                return false;
+            }
+            if (options.timeSlice <= 0) return false;
+        } else if (arg.rfind("--snapshot=", 0) == 0) {
+            options.snapshot = arg.substr(11);
+        } else if (arg.rfind("--snapshot-out=", 0) == 0) {
+            options.snapshotOut = arg.substr(15);
+        } else if (arg.rfind("--isolates=", 0) == 0) {
+            try {
+                options.isolates = std::stoul(arg.substr(11));
+            } catch (const std::exception&) {
+                return false;
+            }
+        } else if (arg == "--serve" && i + 1 < argc) {
+            options.serve = argv[++i];
+        } else if (arg.rfind("--serve=", 0) == 0) {
+            options.serve = arg.substr(8);
+        } else if (arg == "--client" && i + 1 < argc) {
+            options.client = argv[++i];
+        } else if (arg.rfind("--client=", 0) == 0) {
+            options.client = arg.substr(9);
+        } else if (arg.rfind("--connections=", 0) == 0) {
+            try {
+                options.connections = std::stoul(arg.substr(14));
+            } catch (const std::exception&) {
+                return false;
+            }
+            if (options.connections == 0) return false;
+        } else if (arg.rfind("--input=", 0) == 0) {
+            options.input = arg.substr(8);
+        } else if (arg == "--shutdown") {
+            options.shutdown = true;
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg.rfind("--", 0) == 0 || !options.filename.empty()) {
+            return false;
+        } else {
+            options.filename = arg;
+        }
+    }
+    return true;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc == 1) {
-        runRepl();
-    } else if (argc == 2) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cout << "Usage: " << argv[0] << " [--memoize[=N]] [--jit] [--jit-threshold=N] [--trace-jit] [--trace-threshold=N] [--vm] [--vm-profile] [--emit-cpp[=FILE]] [--max-depth=N] [--repeat=N] [--isolates=N] [--batch MANIFEST [--threads=N] [--time-slice=MS]] [--snapshot=FILE] [--snapshot-out=FILE] [--serve SOCKET [--threads=N]] [--client SOCKET [--batch MANIFEST | --input=TEXT filename] [--repeat=N] [--connections=N] [--shutdown]] [--stats] [filename]" << std::endl;
+        return 1;
+    }
+
+    // В пакете, службе и REPL снимок загружается вне обработки ошибок запуска: проверяем образ заранее
+    if (!options.snapshot.empty() && (!options.batchManifest.empty() || !options.serve.empty() ||
+                                      options.filename.empty())) {
         try {
-            std::string source = readFile(argv[1]);
-            Lexer lexer(source);
-            Parser parser(lexer);
-            auto program = parser.parse();
-            
-            Interpreter interpreter;
-            // Приводим тип к Program&
-            interpreter.interpret(static_cast<Program&>(*program));
-            
+            readSnapshot(options.snapshot);
         } catch (const std::exception& e) {
             std::cerr << "Error: " << e.what() << std::endl;
             return 1;
         }
-    } else {
-        std::cout << "Usage: " << argv[0] << " [filename]" << std::endl;
-        return 1;
     }
-    
-    return 0;
-}
\ No newline at end of file
+
+    if (!options.serve.empty()) {
+        if (!options.filename.empty() || !options.batchManifest.empty() || !options.client.empty()) {
+            std::cout << "--serve does not take a filename" << std::endl;
+            return 1;
+        }
+        return runServe(options);
+    }
+
+    if (!options.client.empty()) {
+        if (!options.filename.empty() && !options.batchManifest.empty()) {
+            std::cout << "--client takes either a filename or --batch" << std::endl;
+            return 1;
+        }
+        return runClient(options);
+    }
+
+    if (!options.batchManifest.empty()) {
+        if (!options.filename.empty()) {
+            std::cout << "--batch does not take a filename" << std::endl;
+            return 1;
+        }
+        return runBatch(options);
+    }
+
+    if (options.filename.empty()) {
+        if (options.emitCpp) {
+            std::cout << "--emit-cpp requires a filename" << std::endl;
+            return 1;
+        }
+        runRepl(options);
+        return 0;
+    }
+
+    return runFile(options);
+}
@@ -0,0 +1,70 @@
+#include "memo.h"
+#include <cstring>
+
+MemoCache::MemoCache(const std::string& functionName, std::shared_ptr<Block> body, size_t capacity)
+    : functionName(functionName), body(std::move(body)), capacity(capacity), hitCount(0), missCount(0) {}
+
+bool MemoCache::makeKey(const std::vector<Value>& args, std::string& key) {
+    key.clear();
+    for (const auto& arg : args) {
+        switch (arg.type) {
+            case Value::NUMBER: {
+                char bytes[sizeof(double)];
+                std::memcpy(bytes, &arg.numberValue, sizeof(double));
+                key += 'n';
+                key.append(bytes, sizeof(double));
+                break;
+            }
+            case Value::STRING: {
+                size_t length = arg.stringValue().size();
+                char bytes[sizeof(size_t)];
+                std::memcpy(bytes, &length, sizeof(size_t));
+                key += 's';
+                key.append(bytes, sizeof(size_t));
+                key += arg.stringValue();
+                break;
+            }
+            case Value::BOOLEAN:
+                key += arg.booleanValue ? 'T' : 'F';
+                break;
+            case Value::NIL:
+                key += 'z';
+                break;
+            default:
+                // Массивы, объекты и функции не кэшируем
+                return false;
+        }
+    }
+    return true;
+}
+
+const Value* MemoCache::lookup(const std::string& key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        missCount++;
+        return nullptr;
+    }
+
+    hitCount++;
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->second;
+}
+
+void MemoCache::insert(const std::string& key, const Value& result) {
+    if (capacity == 0) return;
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        it->second->second = result;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+
+    if (entries.size() >= capacity) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+
+    entries.emplace_front(key, result);
+    index[key] = entries.begin();
+}
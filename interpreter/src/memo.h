@@ -0,0 +1,39 @@
+#ifndef MEMO_H
+#define MEMO_H
+
+#include "environment.h"
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Кэш результатов чистой функции с вытеснением LRU
+class MemoCache {
+private:
+    using Entry = std::pair<std::string, Value>;
+
+    std::string functionName;
+    std::shared_ptr<Block> body; // Удерживаем тело, чтобы адрес-ключ оставался валидным
+    size_t capacity;
+    std::list<Entry> entries;    // Голова списка — самые свежие записи
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t hitCount;
+    size_t missCount;
+
+public:
+    MemoCache(const std::string& functionName, std::shared_ptr<Block> body, size_t capacity);
+
+    // Ключ строится только из примитивных аргументов (число, строка, bool, null)
+    static bool makeKey(const std::vector<Value>& args, std::string& key);
+
+    const Value* lookup(const std::string& key);
+    void insert(const std::string& key, const Value& result);
+
+    const std::string& name() const { return functionName; }
+    size_t size() const { return entries.size(); }
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+};
+
+#endif // MEMO_H
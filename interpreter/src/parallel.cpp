@@ -0,0 +1,185 @@
+#include "parallel.h"
+#include "array.h"
+#include "runtime.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// На меньших частях копия исполнителя и задача пула дороже самой работы
+const size_t MIN_CHUNK_SIZE = 256;
+// Частей больше, чем потоков: захват работы выравнивает неравные части
+const size_t MAX_CHUNKS = 64;
+
+ThreadPool& parallelPool() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+struct Range {
+    size_t begin;
+    size_t end;
+};
+
+std::vector<Range> splitRanges(size_t size) {
+    size_t count = std::min(MAX_CHUNKS, (size + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE);
+    std::vector<Range> ranges;
+    for (size_t i = 0; i < count; i++) {
+        ranges.push_back({size * i / count, size * (i + 1) / count});
+    }
+    return ranges;
+}
+
+std::shared_ptr<const ArrayStorage> arrayArgument(const Value& value, const char* name) {
+    if (value.type != Value::ARRAY || !value.arrayValue) {
+        throw std::runtime_error(std::string(name) + " expects an array");
+    }
+    return value.arrayValue;
+}
+
+// Родные функции отвергаются: о потокобезопасности встраивающего кода ничего не известно
+Value pureCallback(const Value& value, const FunctionCaller& caller, const char* name, size_t arity) {
+    if (value.type != Value::FUNCTION || value.arity() != arity || !caller.isPure(value)) {
+        throw std::runtime_error(std::string(name) + " expects a pure function of " + std::to_string(arity) +
+                                 (arity == 1 ? " argument" : " arguments"));
+    }
+    return value;
+}
+
+// work(index, caller) для каждой части. Одна часть или исполнитель без fork —
+// по очереди в этом потоке. Иначе части уходят в пул, а вызвавший выполняет
+// задачи из очередей, пока его части не готовы. Ошибка первой по порядку
+// части пробрасывается, как при последовательном обходе.
+void runRanges(size_t count, FunctionCaller& caller, const std::function<void(size_t, FunctionCaller&)>& work) {
+    if (count <= 1 || !caller.canFork()) {
+        for (size_t i = 0; i < count; i++) {
+            work(i, caller);
+        }
+        return;
+    }
+
+    ThreadPool& pool = parallelPool();
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t remaining = count;
+    std::vector<std::exception_ptr> errors(count);
+
+    // fork дорог (новый интерпретатор), поэтому копия создаётся один раз на
+    // поток: по слоту на работника пула и последний — для вызвавшего потока.
+    // Слот трогает только его поток. Пока копия занята (вложенный вызов взял
+    // из очереди ещё одну нашу часть), та часть получает свою копию.
+    struct Fork {
+        std::unique_ptr<FunctionCaller> caller;
+        bool busy = false;
+    };
+    std::vector<Fork> forks(pool.size() + 1);
+    std::thread::id callingThread = std::this_thread::get_id();
+    auto runPart = [&](size_t i) {
+        int worker = pool.currentWorker();
+        size_t slot = forks.size(); // Чужой поток вне пула: своя копия на часть
+        if (std::this_thread::get_id() == callingThread) {
+            slot = pool.size();
+        } else if (worker >= 0) {
+            slot = static_cast<size_t>(worker);
+        }
+        if (slot == forks.size() || forks[slot].busy) {
+            std::unique_ptr<FunctionCaller> own = caller.fork();
+            work(i, *own);
+            return;
+        }
+        Fork& fork = forks[slot];
+        if (!fork.caller) {
+            fork.caller = caller.fork();
+        }
+        // После ошибки слот остаётся занятым: оставшиеся части возьмут свои копии
+        fork.busy = true;
+        work(i, *fork.caller);
+        fork.busy = false;
+    };
+
+    for (size_t i = 0; i < count; i++) {
+        pool.submit([&, i] {
+            try {
+                runPart(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            // Уведомление под замком: увидев remaining == 0, вызвавший
+            // сразу уничтожает mutex и finished
+            std::lock_guard<std::mutex> lock(mutex);
+            remaining--;
+            finished.notify_all();
+        });
+    }
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (remaining == 0) break;
+        }
+        if (!pool.runPendingTask()) {
+            // Очереди пусты, последние части выполняются работниками
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&remaining] { return remaining == 0; });
+            break;
+        }
+    }
+
+    for (const std::exception_ptr& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+} // namespace
+
+// args лежат в регистрах VM, которые колбэк может перераспределить, —
+// всё нужное копируется до обхода
+Value parallelMap(const Value* args, FunctionCaller& caller) {
+    std::shared_ptr<const ArrayStorage> elements = arrayArgument(args[0], "parallelMap");
+    Value function = pureCallback(args[1], caller, "parallelMap", 1);
+    std::vector<Range> ranges = splitRanges(elements->size());
+
+    std::vector<Value> results(elements->size());
+    runRanges(ranges.size(), caller, [&](size_t index, FunctionCaller& worker) {
+        for (size_t i = ranges[index].begin; i < ranges[index].end; i++) {
+            Value element = elements->get(i);
+            results[i] = worker.call(function, &element, 1);
+        }
+    });
+    return Value(std::move(results));
+}
+
+Value parallelReduce(const Value* args, FunctionCaller& caller) {
+    std::shared_ptr<const ArrayStorage> elements = arrayArgument(args[0], "parallelReduce");
+    Value function = pureCallback(args[1], caller, "parallelReduce", 2);
+    Value initial = args[2];
+    std::vector<Range> ranges = splitRanges(elements->size());
+    if (ranges.empty()) {
+        return initial;
+    }
+
+    // Первая часть начинается с init, остальные — со своего первого элемента
+    std::vector<Value> partial(ranges.size());
+    runRanges(ranges.size(), caller, [&](size_t index, FunctionCaller& worker) {
+        size_t i = ranges[index].begin;
+        Value pair[2] = {index == 0 ? initial : elements->get(i++), Value()}; // Аккумулятор и элемент
+        for (; i < ranges[index].end; i++) {
+            pair[1] = elements->get(i);
+            pair[0] = worker.call(function, pair, 2);
+        }
+        partial[index] = std::move(pair[0]);
+    });
+
+    Value pair[2] = {std::move(partial[0]), Value()};
+    for (size_t index = 1; index < partial.size(); index++) {
+        pair[1] = std::move(partial[index]);
+        pair[0] = caller.call(function, pair, 2);
+    }
+    return pair[0];
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "environment.h"
+
+// Встроенные parallelMap(array, fn) и parallelReduce(array, fn, init).
+// Массив делится на части, и колбэк выполняется над ними на общем пуле
+// потоков (threadpool.h); у каждой части свой исполнитель (FunctionCaller::fork),
+// AST функции общий. Колбэк должен быть чистым (PurityAnalyzer), а для reduce
+// ещё и ассоциативным: результаты частей объединяются тем же колбэком.
+// Деление зависит только от длины массива, поэтому результат не зависит
+// ни от числа потоков, ни от режима исполнения.
+Value parallelMap(const Value* args, FunctionCaller& caller);
+Value parallelReduce(const Value* args, FunctionCaller& caller);
+
+#endif // PARALLEL_H
\ No newline at end of file
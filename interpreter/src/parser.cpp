@@ -54,8 +54,20 @@ std::unique_ptr<Statement> Parser::parseStatement() {
             return parseForStatement();
         case TokenType::FUN:
             return parseFunctionDeclaration();
+        case TokenType::ASYNC: {
+            advance();
+            auto funcDecl = parseFunctionDeclaration();
+            funcDecl->isAsync = true;
+            return funcDecl;
+        }
         case TokenType::RETURN:
             return parseReturnStatement();
+        case TokenType::YIELD: {
+            advance();
+            auto value = parseExpression();
+            expect(TokenType::SEMICOLON, "Expected ';' after yield value");
+            return std::make_unique<YieldStatement>(std::move(value));
+        }
         case TokenType::PRINT:
             return parsePrintStatement();
         case TokenType::LEFT_BRACE:
@@ -93,6 +105,12 @@ std::unique_ptr<Assignment> Parser::parseAssignment(const std::string& variableN
 }
 
 std::unique_ptr<Statement> Parser::parseAssignmentOrExpression() {
+    // Вызов функции или метода: смотрим вперёд, не съедая имя
+    TokenType next = peek().type;
+    if (next != TokenType::ASSIGN && next != TokenType::LEFT_BRACKET) {
+        return parseExpressionStatement();
+    }
+    
     // Сохраняем позицию для отката
     Token identifierToken = currentToken;
     advance();
@@ -169,6 +187,11 @@ std::unique_ptr<WhileStatement> Parser::parseWhileStatement() {
 
 std::unique_ptr<FunctionDeclaration> Parser::parseFunctionDeclaration() {
     expect(TokenType::FUN, "Expected 'fun'");
+    bool isGenerator = false;
+    if (currentToken.type == TokenType::MULTIPLY) {
+        advance(); // fun* — генератор
+        isGenerator = true;
+    }
     
     Token nameToken = expect(TokenType::IDENTIFIER, "Expected function name");
     
@@ -191,7 +214,9 @@ std::unique_ptr<FunctionDeclaration> Parser::parseFunctionDeclaration() {
     
     auto body = parseBlock();
     
-    return std::make_unique<FunctionDeclaration>(nameToken.lexeme, parameters, std::move(body));
+    auto funcDecl = std::make_unique<FunctionDeclaration>(nameToken.lexeme, parameters, std::move(body));
+    funcDecl->isGenerator = isGenerator;
+    return funcDecl;
 }
 
 std::unique_ptr<ReturnStatement> Parser::parseReturnStatement() {
@@ -246,24 +271,7 @@ std::unique_ptr<ExpressionStatement> Parser::parseExpressionStatement() {
 }
 
 std::unique_ptr<Expression> Parser::parseExpression() {
-    auto expr = parseLogicalOr();
-    
-    // Обработка индексов и свойств
-    while (currentToken.type == TokenType::LEFT_BRACKET || 
-           currentToken.type == TokenType::DOT) {
-        if (currentToken.type == TokenType::LEFT_BRACKET) {
-            advance(); // Пропускаем '['
-            auto index = parseExpression();
-            expect(TokenType::RIGHT_BRACKET, "Expected ']' after index");
-            expr = std::make_unique<IndexExpression>(std::move(expr), std::move(index));
-        } else if (currentToken.type == TokenType::DOT) {
-            advance(); // Пропускаем '.'
-            Token property = expect(TokenType::IDENTIFIER, "Expected property name after '.'");
-            expr = std::make_unique<PropertyAccess>(std::move(expr), property.lexeme);
-        }
-    }
-    
-    return expr;
+    return parseLogicalOr();
 }
 
 std::unique_ptr<Expression> Parser::parseLogicalOr() {
@@ -352,8 +360,39 @@ std::unique_ptr<Expression> Parser::parseUnary() {
         auto operand = parseUnary();
         return std::make_unique<UnaryOperation>(op.lexeme, std::move(operand));
     }
+    if (currentToken.type == TokenType::AWAIT) {
+        advance();
+        return std::make_unique<AwaitExpression>(parseUnary());
+    }
+    
+    return parsePostfix();
+}
+
+// Индексы, свойства и вызовы методов связываются сильнее любых операторов:
+// "a = " + arr[0] — это "a = " + (arr[0])
+std::unique_ptr<Expression> Parser::parsePostfix() {
+    auto expr = parsePrimary();
+    
+    while (currentToken.type == TokenType::LEFT_BRACKET || 
+           currentToken.type == TokenType::DOT) {
+        if (currentToken.type == TokenType::LEFT_BRACKET) {
+            advance(); // Пропускаем '['
+            auto index = parseExpression();
+            expect(TokenType::RIGHT_BRACKET, "Expected ']' after index");
+            expr = std::make_unique<IndexExpression>(std::move(expr), std::move(index));
+        } else {
+            advance(); // Пропускаем '.'
+            Token property = expect(TokenType::IDENTIFIER, "Expected property name after '.'");
+            if (currentToken.type == TokenType::LEFT_PAREN) {
+                auto arguments = parseArguments();
+                expr = std::make_unique<MethodCall>(std::move(expr), property.lexeme, std::move(arguments));
+            } else {
+                expr = std::make_unique<PropertyAccess>(std::move(expr), property.lexeme);
+            }
+        }
+    }
     
-    return parsePrimary();
+    return expr;
 }
 
 std::unique_ptr<Expression> Parser::parsePrimary() {
@@ -365,7 +404,7 @@ std::unique_ptr<Expression> Parser::parsePrimary() {
         }
         
         case TokenType::STRING: {
-            std::string value = currentToken.lexeme;
+            StringStorage value = internString(currentToken.lexeme);
             advance();
             return std::make_unique<StringLiteral>(value);
         }
@@ -418,7 +457,21 @@ Token Parser::peek() {
     return lexer.peek();  // Предполагая, что в Lexer есть метод peek()
 }
 
+StringStorage Parser::internString(const std::string& text) {
+    auto it = stringPool.find(text);
+    if (it != stringPool.end()) {
+        return it->second;
+    }
+    StringStorage storage = std::make_shared<const std::string>(text);
+    stringPool.emplace(text, storage);
+    return storage;
+}
+
 std::unique_ptr<FunctionCall> Parser::parseFunctionCall(const std::string& functionName) {
+    return std::make_unique<FunctionCall>(functionName, parseArguments());
+}
+
+std::vector<std::unique_ptr<Expression>> Parser::parseArguments() {
     expect(TokenType::LEFT_PAREN, "Expected '(' after function name");
     
     std::vector<std::unique_ptr<Expression>> arguments;
@@ -435,7 +488,7 @@ std::unique_ptr<FunctionCall> Parser::parseFunctionCall(const std::string& funct
     
     expect(TokenType::RIGHT_PAREN, "Expected ')' after function arguments");
     
-    return std::make_unique<FunctionCall>(functionName, std::move(arguments));
+    return arguments;
 }
 
 // Новые методы парсинга
@@ -485,17 +538,39 @@ std::unique_ptr<Statement> Parser::parseForStatement() {
     expect(TokenType::FOR, "Expected 'for'");
     expect(TokenType::LEFT_PAREN, "Expected '(' after 'for'");
     
+    // for (let x in ...) или for (x in ...)
+    if (currentToken.type == TokenType::LET || (currentToken.type == TokenType::IDENTIFIER && peek().type == TokenType::IN)) {
+        if (currentToken.type == TokenType::LET) {
+            advance();
+        }
+        Token nameToken = expect(TokenType::IDENTIFIER, "Expected variable name in 'for'");
+        if (currentToken.type == TokenType::IN) {
+            advance();
+            auto iterable = parseExpression();
+            expect(TokenType::RIGHT_PAREN, "Expected ')' after for..in");
+            auto body = parseBlock();
+            return std::make_unique<ForInStatement>(nameToken.lexeme, std::move(iterable), std::move(body));
+        }
+        // Обычный for с let в инициализаторе: let уже прочитан
+        expect(TokenType::ASSIGN, "Expected '=' after variable name");
+        auto value = parseExpression();
+        expect(TokenType::SEMICOLON, "Expected ';' after variable declaration");
+        return parseForClauses(std::make_unique<VariableDeclaration>(nameToken.lexeme, std::move(value)));
+    }
+    
     // Инициализатор
     std::unique_ptr<Statement> initializer;
-    if (currentToken.type == TokenType::LET) {
-        initializer = parseVariableDeclaration();
-    } else if (currentToken.type == TokenType::SEMICOLON) {
+    if (currentToken.type == TokenType::SEMICOLON) {
         advance(); // Пропускаем ';'
         initializer = nullptr;
     } else {
         initializer = parseExpressionStatement();
     }
-    
+    return parseForClauses(std::move(initializer));
+}
+
+// Условие, инкремент и тело for после инициализатора
+std::unique_ptr<Statement> Parser::parseForClauses(std::unique_ptr<Statement> initializer) {
     // Условие
     std::unique_ptr<Expression> condition;
     if (currentToken.type != TokenType::SEMICOLON) {
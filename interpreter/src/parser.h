@@ -4,15 +4,20 @@
 #include "lexer.h"
 #include "ast.h"
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 class Parser {
 private:
     Lexer& lexer;
     Token currentToken{TokenType::END_OF_FILE, "", 0, 0};
+    // Пул строковых констант программы: одинаковые литералы делят хранилище
+    std::unordered_map<std::string, StringStorage> stringPool;
 
     void advance();
     Token expect(TokenType expectedType, const std::string& errorMessage);
     Token peek();
+    StringStorage internString(const std::string& text);
     
     std::unique_ptr<Expression> parseExpression();
     std::unique_ptr<Expression> parseLogicalOr();
@@ -22,8 +27,10 @@ private:
     std::unique_ptr<Expression> parseTerm();
     std::unique_ptr<Expression> parseFactor();
     std::unique_ptr<Expression> parseUnary();
+    std::unique_ptr<Expression> parsePostfix();
     std::unique_ptr<Expression> parsePrimary();
     std::unique_ptr<FunctionCall> parseFunctionCall(const std::string& functionName);
+    std::vector<std::unique_ptr<Expression>> parseArguments();
     std::unique_ptr<Expression> parseArrayLiteral();
     std::unique_ptr<Expression> parseObjectLiteral();
     
@@ -35,6 +42,7 @@ private:
     std::unique_ptr<IfStatement> parseIfStatement();
     std::unique_ptr<WhileStatement> parseWhileStatement();
     std::unique_ptr<Statement> parseForStatement();
+    std::unique_ptr<Statement> parseForClauses(std::unique_ptr<Statement> initializer);
     std::unique_ptr<FunctionDeclaration> parseFunctionDeclaration();
     std::unique_ptr<ReturnStatement> parseReturnStatement();
     std::unique_ptr<PrintStatement> parsePrintStatement();
@@ -0,0 +1,203 @@
+#include "purity.h"
+
+void PurityAnalyzer::analyze(Program& program) {
+    for (auto& stmt : program.statements) {
+        if (auto funcDecl = dynamic_cast<const FunctionDeclaration*>(stmt.get())) {
+            topLevel.insert(funcDecl);
+        }
+        collect(*stmt);
+    }
+
+    // Локальная проверка каждой функции
+    for (auto& [name, decls] : declarations) {
+        for (auto* decl : decls) {
+            std::unordered_set<std::string> locals(decl->parameters.begin(), decl->parameters.end());
+            collectLocals(*decl->body, locals);
+
+            std::unordered_set<std::string> calls;
+            // Вызов async-функции возвращает новое обещание, а не результат
+            decl->isPure = !decl->isAsync && !decl->isGenerator && checkStatement(*decl->body, locals, calls);
+            if (decl->isPure) {
+                callees[decl] = std::move(calls);
+            }
+        }
+    }
+
+    // Наибольшая неподвижная точка: рекурсивные функции остаются чистыми,
+    // пока не найден нечистый вызываемый
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& [decl, calls] : callees) {
+            if (!decl->isPure) continue;
+            for (const auto& callee : calls) {
+                if (!isPureCallee(callee)) {
+                    decl->isPure = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void PurityAnalyzer::collect(Statement& stmt) {
+    if (auto funcDecl = dynamic_cast<FunctionDeclaration*>(&stmt)) {
+        declarations[funcDecl->functionName].push_back(funcDecl);
+        for (const auto& param : funcDecl->parameters) {
+            otherBindings.insert(param);
+        }
+        collect(*funcDecl->body);
+    }
+    else if (auto varDecl = dynamic_cast<VariableDeclaration*>(&stmt)) {
+        otherBindings.insert(varDecl->variableName);
+    }
+    else if (auto assignment = dynamic_cast<Assignment*>(&stmt)) {
+        otherBindings.insert(assignment->variableName);
+    }
+    else if (auto block = dynamic_cast<Block*>(&stmt)) {
+        for (auto& s : block->statements) {
+            collect(*s);
+        }
+    }
+    else if (auto ifStmt = dynamic_cast<IfStatement*>(&stmt)) {
+        collect(*ifStmt->thenBlock);
+        if (ifStmt->elseBlock) collect(*ifStmt->elseBlock);
+    }
+    else if (auto whileStmt = dynamic_cast<WhileStatement*>(&stmt)) {
+        collect(*whileStmt->body);
+    }
+    else if (auto forStmt = dynamic_cast<ForStatement*>(&stmt)) {
+        if (forStmt->initializer) collect(*forStmt->initializer);
+        collect(*forStmt->body);
+    }
+}
+
+void PurityAnalyzer::collectLocals(const Statement& stmt, std::unordered_set<std::string>& locals) const {
+    if (auto varDecl = dynamic_cast<const VariableDeclaration*>(&stmt)) {
+        locals.insert(varDecl->variableName);
+    }
+    else if (auto block = dynamic_cast<const Block*>(&stmt)) {
+        for (const auto& s : block->statements) {
+            collectLocals(*s, locals);
+        }
+    }
+    else if (auto ifStmt = dynamic_cast<const IfStatement*>(&stmt)) {
+        collectLocals(*ifStmt->thenBlock, locals);
+        if (ifStmt->elseBlock) collectLocals(*ifStmt->elseBlock, locals);
+    }
+    else if (auto whileStmt = dynamic_cast<const WhileStatement*>(&stmt)) {
+        collectLocals(*whileStmt->body, locals);
+    }
+    else if (auto forStmt = dynamic_cast<const ForStatement*>(&stmt)) {
+        if (forStmt->initializer) collectLocals(*forStmt->initializer, locals);
+        collectLocals(*forStmt->body, locals);
+    }
+}
+
+bool PurityAnalyzer::checkStatement(const Statement& stmt, const std::unordered_set<std::string>& locals,
+                                    std::unordered_set<std::string>& calls) const {
+    if (auto varDecl = dynamic_cast<const VariableDeclaration*>(&stmt)) {
+        return !varDecl->initializer || checkExpression(*varDecl->initializer, locals, calls);
+    }
+    else if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
+        if (!locals.count(assignment->variableName)) return false;
+        if (assignment->target && !checkExpression(*assignment->target, locals, calls)) return false;
+        return checkExpression(*assignment->value, locals, calls);
+    }
+    else if (auto ifStmt = dynamic_cast<const IfStatement*>(&stmt)) {
+        return checkExpression(*ifStmt->condition, locals, calls) &&
+               checkStatement(*ifStmt->thenBlock, locals, calls) &&
+               (!ifStmt->elseBlock || checkStatement(*ifStmt->elseBlock, locals, calls));
+    }
+    else if (auto whileStmt = dynamic_cast<const WhileStatement*>(&stmt)) {
+        return checkExpression(*whileStmt->condition, locals, calls) &&
+               checkStatement(*whileStmt->body, locals, calls);
+    }
+    else if (auto forStmt = dynamic_cast<const ForStatement*>(&stmt)) {
+        return (!forStmt->initializer || checkStatement(*forStmt->initializer, locals, calls)) &&
+               (!forStmt->condition || checkExpression(*forStmt->condition, locals, calls)) &&
+               (!forStmt->increment || checkExpression(*forStmt->increment, locals, calls)) &&
+               checkStatement(*forStmt->body, locals, calls);
+    }
+    else if (auto returnStmt = dynamic_cast<const ReturnStatement*>(&stmt)) {
+        return !returnStmt->value || checkExpression(*returnStmt->value, locals, calls);
+    }
+    else if (auto block = dynamic_cast<const Block*>(&stmt)) {
+        for (const auto& s : block->statements) {
+            if (!checkStatement(*s, locals, calls)) return false;
+        }
+        return true;
+    }
+    else if (auto exprStmt = dynamic_cast<const ExpressionStatement*>(&stmt)) {
+        return checkExpression(*exprStmt->expression, locals, calls);
+    }
+
+    // print, вложенные функции (видят динамическое окружение) и всё неизвестное
+    return false;
+}
+
+bool PurityAnalyzer::checkExpression(const Expression& expr, const std::unordered_set<std::string>& locals,
+                                     std::unordered_set<std::string>& calls) const {
+    if (dynamic_cast<const NumberLiteral*>(&expr) ||
+        dynamic_cast<const StringLiteral*>(&expr) ||
+        dynamic_cast<const BooleanLiteral*>(&expr) ||
+        dynamic_cast<const NullLiteral*>(&expr)) {
+        return true;
+    }
+    else if (auto id = dynamic_cast<const Identifier*>(&expr)) {
+        return locals.count(id->name) > 0;
+    }
+    else if (auto binOp = dynamic_cast<const BinaryOperation*>(&expr)) {
+        return checkExpression(*binOp->left, locals, calls) &&
+               checkExpression(*binOp->right, locals, calls);
+    }
+    else if (auto unOp = dynamic_cast<const UnaryOperation*>(&expr)) {
+        return checkExpression(*unOp->operand, locals, calls);
+    }
+    else if (auto call = dynamic_cast<const FunctionCall*>(&expr)) {
+        if (call->functionName == "print" || locals.count(call->functionName)) {
+            return false;
+        }
+        calls.insert(call->functionName);
+        for (const auto& arg : call->arguments) {
+            if (!checkExpression(*arg, locals, calls)) return false;
+        }
+        return true;
+    }
+    else if (auto array = dynamic_cast<const ArrayLiteral*>(&expr)) {
+        for (const auto& element : array->elements) {
+            if (!checkExpression(*element, locals, calls)) return false;
+        }
+        return true;
+    }
+    else if (auto object = dynamic_cast<const ObjectLiteral*>(&expr)) {
+        for (const auto& [key, value] : object->properties) {
+            if (!checkExpression(*value, locals, calls)) return false;
+        }
+        return true;
+    }
+    else if (auto indexExpr = dynamic_cast<const IndexExpression*>(&expr)) {
+        return checkExpression(*indexExpr->object, locals, calls) &&
+               checkExpression(*indexExpr->index, locals, calls);
+    }
+    else if (auto propAccess = dynamic_cast<const PropertyAccess*>(&expr)) {
+        return checkExpression(*propAccess->object, locals, calls);
+    }
+
+    return false;
+}
+
+bool PurityAnalyzer::isPureCallee(const std::string& name) const {
+    // Имя должно однозначно разрешаться в объявленную функцию
+    if (otherBindings.count(name)) return false;
+
+    // Кэш мемоизации помнит только аргументы, поэтому вызываемая функция не
+    // должна переопределяться: повторное объявление или вложенное объявление
+    // с тем же именем подменяют её во время выполнения
+    auto it = declarations.find(name);
+    if (it == declarations.end() || it->second.size() != 1) return false;
+
+    const auto* decl = it->second.front();
+    return topLevel.count(decl) && decl->isPure;
+}
@@ -0,0 +1,37 @@
+#ifndef PURITY_H
+#define PURITY_H
+
+#include "ast.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Анализ чистоты функций.
+// Функция считается чистой, если она читает только свои параметры и локальные
+// переменные, ничего не печатает, не присваивает внешним переменным и вызывает
+// только чистые функции. Результат записывается в FunctionDeclaration::isPure.
+class PurityAnalyzer {
+private:
+    // Все объявления функций программы (включая вложенные), по имени
+    std::unordered_map<std::string, std::vector<FunctionDeclaration*>> declarations;
+    // Объявления непосредственно на верхнем уровне программы
+    std::unordered_set<const FunctionDeclaration*> topLevel;
+    // Имена, связанные не только объявлениями функций (let, параметры, присваивания)
+    std::unordered_set<std::string> otherBindings;
+    // Вызываемые функции для каждого кандидата в чистые
+    std::unordered_map<FunctionDeclaration*, std::unordered_set<std::string>> callees;
+
+    void collect(Statement& stmt);
+    void collectLocals(const Statement& stmt, std::unordered_set<std::string>& locals) const;
+    bool checkStatement(const Statement& stmt, const std::unordered_set<std::string>& locals,
+                        std::unordered_set<std::string>& calls) const;
+    bool checkExpression(const Expression& expr, const std::unordered_set<std::string>& locals,
+                         std::unordered_set<std::string>& calls) const;
+    bool isPureCallee(const std::string& name) const;
+
+public:
+    void analyze(Program& program);
+};
+
+#endif // PURITY_H
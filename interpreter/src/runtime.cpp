@@ -0,0 +1,420 @@
+#include "runtime.h"
+#include "array.h"
+#include "parallel.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sys/resource.h>
+#endif
+
+// Текст операнда конкатенации: у строки — её хранилище, иначе toString() в scratch
+static const std::string& concatenationText(const Value& value, std::string& scratch) {
+    if (value.type == Value::STRING) {
+        return value.stringValue();
+    }
+    scratch = value.toString();
+    return scratch;
+}
+
+Value concatenateValues(const Value& left, const Value& right) {
+    std::string leftScratch;
+    std::string rightScratch;
+    const std::string& leftText = concatenationText(left, leftScratch);
+    const std::string& rightText = concatenationText(right, rightScratch);
+
+    auto result = std::make_shared<std::string>();
+    result->reserve(leftText.size() + rightText.size());
+    result->append(leftText).append(rightText);
+    return Value::string(std::move(result));
+}
+
+Value addValues(const Value& left, const Value& right) {
+    if (left.type == Value::NUMBER && right.type == Value::NUMBER) {
+        return Value(left.numberValue + right.numberValue);
+    } else if (left.type == Value::STRING || right.type == Value::STRING) {
+        return concatenateValues(left, right);
+    }
+    return Value();
+}
+
+Value subtractValues(const Value& left, const Value& right) {
+    return Value(left.numberValue - right.numberValue);
+}
+
+Value multiplyValues(const Value& left, const Value& right) {
+    return Value(left.numberValue * right.numberValue);
+}
+
+Value divideValues(const Value& left, const Value& right) {
+    if (right.numberValue == 0) {
+        throw std::runtime_error("Division by zero");
+    }
+    return Value(left.numberValue / right.numberValue);
+}
+
+// Равенство — по строковому представлению; для чисел то же без форматирования
+Value equalValues(const Value& left, const Value& right) {
+    if (left.type == Value::NUMBER && right.type == Value::NUMBER) {
+        return Value(numbersEqual(left.numberValue, right.numberValue));
+    }
+    if (left.type == Value::STRING && right.type == Value::STRING) {
+        return Value(stringsEqual(left, right));
+    }
+    return Value(left.toString() == right.toString());
+}
+
+Value notEqualValues(const Value& left, const Value& right) {
+    return Value(!equalValues(left, right).booleanValue);
+}
+
+Value lessValues(const Value& left, const Value& right) {
+    return Value(left.numberValue < right.numberValue);
+}
+
+Value greaterValues(const Value& left, const Value& right) {
+    return Value(left.numberValue > right.numberValue);
+}
+
+Value lessEqualValues(const Value& left, const Value& right) {
+    return Value(left.numberValue <= right.numberValue);
+}
+
+Value greaterEqualValues(const Value& left, const Value& right) {
+    return Value(left.numberValue >= right.numberValue);
+}
+
+Value andValues(const Value& left, const Value& right) {
+    return Value(left.booleanValue && right.booleanValue);
+}
+
+Value orValues(const Value& left, const Value& right) {
+    return Value(left.booleanValue || right.booleanValue);
+}
+
+Value binaryOperation(const std::string& op, const Value& left, const Value& right) {
+    if (op == "+") return addValues(left, right);
+    if (op == "-") return subtractValues(left, right);
+    if (op == "*") return multiplyValues(left, right);
+    if (op == "/") return divideValues(left, right);
+    if (op == "==") return equalValues(left, right);
+    if (op == "!=") return notEqualValues(left, right);
+    if (op == "<") return lessValues(left, right);
+    if (op == ">") return greaterValues(left, right);
+    if (op == "<=") return lessEqualValues(left, right);
+    if (op == ">=") return greaterEqualValues(left, right);
+    if (op == "and") return andValues(left, right);
+    if (op == "or") return orValues(left, right);
+    return Value();
+}
+
+Value negateValue(const Value& operand) {
+    return Value(-operand.numberValue);
+}
+
+Value unaryOperation(const std::string& op, const Value& operand) {
+    if (op == "not") {
+        return Value(!operand.booleanValue);
+    }
+    else if (op == "-") {
+        return negateValue(operand);
+    }
+    return Value();
+}
+
+Value indexValue(const Value& object, const Value& index) {
+    if (object.type == Value::ARRAY && index.type == Value::NUMBER) {
+        long long position = static_cast<long long>(index.numberValue);
+
+        if (!object.arrayValue) {
+            throw std::runtime_error("Array is null");
+        }
+
+        if (position < 0 || position >= static_cast<long long>(object.arrayValue->size())) {
+            throw std::runtime_error("Array index out of bounds");
+        }
+
+        return object.arrayValue->get(position);
+    }
+    throw std::runtime_error("Cannot index this type");
+}
+
+Value propertyValue(const Value& object, Symbol property) {
+    static const Symbol LENGTH = intern("length");
+    if (object.type == Value::ARRAY && property == LENGTH) {
+        return Value(object.arrayValue ? static_cast<double>(object.arrayValue->size()) : 0.0);
+    }
+    if (object.type == Value::OBJECT) {
+        if (!object.objectValue) {
+            throw std::runtime_error("Object is null");
+        }
+
+        auto it = object.objectValue->find(property);
+        if (it != object.objectValue->end()) {
+            return it->second;
+        }
+        throw std::runtime_error("Property not found: " + symbolName(property));
+    }
+    throw std::runtime_error("Cannot access properties of this type");
+}
+
+Value lookupFunction(Environment& env, Symbol name, size_t argumentCount) {
+    const Value* bound = env.find(name);
+    if (!bound) {
+        bound = findBuiltin(name);
+    }
+    if (!bound) {
+        throw std::runtime_error("Undefined variable: " + symbolName(name));
+    }
+    const Value& function = *bound;
+    if (!function.isCallable()) {
+        throw std::runtime_error("Not a function: " + symbolName(name));
+    }
+
+    if (argumentCount != function.arity()) {
+        throw std::runtime_error("Wrong number of arguments for function: " + symbolName(name));
+    }
+    return function;
+}
+
+namespace {
+
+struct BuiltinEntry {
+    const char* name;
+    size_t arity;
+    Value (*function)(const Value* args);
+    HigherOrderNative higherOrder;
+};
+
+const BuiltinEntry BUILTINS[] = {
+    {"sum", 1, arraySum, nullptr},
+    {"min", 1, arrayMin, nullptr},
+    {"max", 1, arrayMax, nullptr},
+    {"dot", 2, arrayDot, nullptr},
+    {"scale", 2, arrayScale, nullptr},
+    {"add", 2, arrayAdd, nullptr},
+    {"parallelMap", 2, nullptr, parallelMap},
+    {"parallelReduce", 3, nullptr, parallelReduce},
+};
+
+// Значения-функции встроенных по символу имени
+const std::unordered_map<Symbol, Value>& builtinValues() {
+    static const std::unordered_map<Symbol, Value> values = [] {
+        std::unordered_map<Symbol, Value> result;
+        for (const BuiltinEntry& entry : BUILTINS) {
+            auto function = std::make_shared<NativeFunction>();
+            function->name = entry.name;
+            function->arity = entry.arity;
+            if (entry.function) {
+                function->function = [body = entry.function](const Value* args, size_t) { return body(args); };
+            }
+            function->higherOrder = entry.higherOrder;
+            result.emplace(intern(entry.name), Value::native(std::move(function)));
+        }
+        return result;
+    }();
+    return values;
+}
+
+} // namespace
+
+const Value* findBuiltin(Symbol name) {
+    const auto& values = builtinValues();
+    auto it = values.find(name);
+    return it != values.end() ? &it->second : nullptr;
+}
+
+struct CompiledEntry {
+    CompiledFunction function;
+    bool pure;
+};
+
+// Тело-метка -> машинный код функции
+static std::unordered_map<const Block*, CompiledEntry>& compiledFunctions() {
+    static std::unordered_map<const Block*, CompiledEntry> functions;
+    return functions;
+}
+
+std::shared_ptr<Block> registerCompiledFunction(CompiledFunction function, bool pure) {
+    auto marker = std::make_shared<Block>();
+    compiledFunctions()[marker.get()] = {function, pure};
+    return marker;
+}
+
+// Запас стека на кадры между проверками и на раскрутку исключения
+const size_t STACK_GUARD_MARGIN = 256 * 1024;
+// Размер стека, если границы узнать нельзя
+const size_t DEFAULT_STACK_SIZE = 1024 * 1024;
+
+// Запас растёт со стеком; стек потока и стек сопрограммы одного размера
+// получают одинаковый запас
+static size_t stackMargin(size_t size) {
+    return std::min(std::max(STACK_GUARD_MARGIN, size / 8), size / 2);
+}
+
+void StackGuard::attachToCurrentThread() {
+    char marker;
+    uintptr_t here = reinterpret_cast<uintptr_t>(&marker);
+    size_t size = DEFAULT_STACK_SIZE;
+    segments = 0;
+#if defined(__linux__)
+    // Точные границы: над началом стека лежат аргументы и окружение процесса
+    pthread_attr_t attributes;
+    if (pthread_getattr_np(pthread_self(), &attributes) == 0) {
+        void* address = nullptr;
+        size_t stackSize = 0;
+        bool known = pthread_attr_getstack(&attributes, &address, &stackSize) == 0;
+        pthread_attr_destroy(&attributes);
+        if (known) {
+            // Стек главного потока растёт по требованию, и ядро не даёт ему
+            // подойти к соседнему отображению вплотную — нижняя часть
+            // может оказаться недоступной, поэтому запас растёт со стеком
+            limit = reinterpret_cast<uintptr_t>(address) + stackMargin(stackSize);
+            return;
+        }
+    }
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+    struct rlimit stackLimit;
+    if (getrlimit(RLIMIT_STACK, &stackLimit) == 0 && stackLimit.rlim_cur != RLIM_INFINITY) {
+        size = static_cast<size_t>(stackLimit.rlim_cur);
+    }
+#endif
+    // Границы неизвестны: отсчитываем от текущего кадра с двойным запасом
+    size_t budget = size > 4 * STACK_GUARD_MARGIN ? size - 2 * STACK_GUARD_MARGIN : size / 2;
+    limit = here > budget ? here - budget : 0;
+}
+
+void StackGuard::attachToStack(const void* lowest, size_t size, size_t segmentDepth) {
+    segments = segmentDepth;
+    limit = reinterpret_cast<uintptr_t>(lowest) + stackMargin(size);
+}
+
+static size_t pageSize() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+StackSegment::StackSegment(size_t size) : length(size) {
+    // Нижняя страница недоступна: переполнение падает сразу, а не портит чужую память
+    void* mapped = mmap(nullptr, length + pageSize(), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Stack overflow");
+    }
+    memory = static_cast<char*>(mapped);
+    mprotect(memory, pageSize(), PROT_NONE);
+}
+
+StackSegment::~StackSegment() {
+    munmap(memory, length + pageSize());
+}
+
+const void* StackSegment::lowest() const {
+    return memory + pageSize();
+}
+
+namespace {
+
+// Состояние переключения лежит на кадре run, на прежнем стеке
+struct SegmentCall {
+    const std::function<void()>* body;
+    std::exception_ptr error;
+    ucontext_t caller;
+    ucontext_t context;
+};
+
+thread_local SegmentCall* startingSegmentCall = nullptr;
+
+void segmentEntry() {
+    SegmentCall* call = startingSegmentCall;
+    try {
+        (*call->body)();
+    } catch (...) {
+        call->error = std::current_exception();
+    }
+    // Вернуться в run на прежний стек; сюда выполнение больше не придёт
+    setcontext(&call->caller);
+}
+
+} // namespace
+
+void StackSegment::run(const std::function<void()>& body) {
+    SegmentCall call{&body, nullptr, {}, {}};
+    getcontext(&call.context);
+    call.context.uc_stack.ss_sp = memory + pageSize();
+    call.context.uc_stack.ss_size = length;
+    call.context.uc_link = nullptr;
+    makecontext(&call.context, &segmentEntry, 0);
+    startingSegmentCall = &call;
+    swapcontext(&call.caller, &call.context);
+    if (call.error) {
+        std::rethrow_exception(call.error);
+    }
+}
+
+// Глубина вызовов скомпилированной программы (она одна на процесс)
+static size_t compiledCallDepth = 0;
+static size_t compiledMaxCallDepth = DEFAULT_MAX_CALL_DEPTH;
+static StackGuard compiledStackGuard;
+// Сегмент стека, оставшийся от прошлого выхода за родной стек
+static std::unique_ptr<StackSegment> spareCompiledSegment;
+
+Value callCompiledFunction(const std::shared_ptr<Environment>& env, const Value& function,
+                           const std::vector<Value>& args) {
+    if (function.type == Value::NATIVE) {
+        CompiledFunctionCaller caller(env);
+        return callNative(function, args.data(), args.size(), caller);
+    }
+    auto it = compiledFunctions().find(function.body.get());
+    if (it == compiledFunctions().end()) {
+        throw std::runtime_error("Function is not compiled");
+    }
+
+    if (compiledCallDepth >= compiledMaxCallDepth) {
+        throw std::runtime_error("Stack overflow");
+    }
+    if (compiledStackGuard.exhausted()) {
+        return runOnStackSegment(compiledStackGuard, spareCompiledSegment,
+                                 [&] { return callCompiledFunction(env, function, args); });
+    }
+
+    // Окружение вызова наследует окружение вызывающего (динамическая область видимости)
+    auto funcEnv = std::make_shared<Environment>(env);
+    for (size_t i = 0; i < args.size(); i++) {
+        funcEnv->define(function.parameters[i], args[i]);
+    }
+    compiledCallDepth++;
+    Value result = it->second.function(funcEnv);
+    compiledCallDepth--;
+    return result;
+}
+
+Value CompiledFunctionCaller::call(const Value& function, const Value* args, size_t count) {
+    return callCompiledFunction(env, function, std::vector<Value>(args, args + count));
+}
+
+bool CompiledFunctionCaller::isPure(const Value& function) const {
+    auto it = compiledFunctions().find(function.body.get());
+    return it != compiledFunctions().end() && it->second.pure;
+}
+
+int runCompiledProgram(CompiledProgram program, size_t maxCallDepth) {
+    auto globals = std::make_shared<Environment>();
+    compiledMaxCallDepth = maxCallDepth;
+    compiledStackGuard.attachToCurrentThread();
+    try {
+        program(globals);
+    } catch (const std::exception& e) {
+        std::cout << std::flush;
+        std::cerr << "Runtime error: " << e.what() << std::endl;
+    }
+    std::cout << std::flush;
+    return 0;
+}
@@ -0,0 +1,184 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include "environment.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Операции языка над значениями. Общие для интерпретатора и для C++-кода,
+// который порождает --emit-cpp (см. cppemitter.h).
+Value addValues(const Value& left, const Value& right);
+Value subtractValues(const Value& left, const Value& right);
+Value multiplyValues(const Value& left, const Value& right);
+Value divideValues(const Value& left, const Value& right);
+Value equalValues(const Value& left, const Value& right);
+Value notEqualValues(const Value& left, const Value& right);
+Value lessValues(const Value& left, const Value& right);
+Value greaterValues(const Value& left, const Value& right);
+Value lessEqualValues(const Value& left, const Value& right);
+Value greaterEqualValues(const Value& left, const Value& right);
+Value andValues(const Value& left, const Value& right);
+Value orValues(const Value& left, const Value& right);
+// Конкатенация с одним выделением памяти: строки читаются из общего хранилища
+Value concatenateValues(const Value& left, const Value& right);
+// Две строки; одно хранилище — равны без сравнения символов
+inline bool stringsEqual(const Value& left, const Value& right) {
+    return left.stringStorage == right.stringStorage || left.stringValue() == right.stringValue();
+}
+Value binaryOperation(const std::string& op, const Value& left, const Value& right);
+Value negateValue(const Value& operand);
+Value unaryOperation(const std::string& op, const Value& operand);
+
+Value indexValue(const Value& object, const Value& index);
+Value propertyValue(const Value& object, Symbol property);
+
+// Вызов значения-функции из встроенного метода (map, filter, reduce).
+// У каждого исполнителя свой: обход AST, окно VM, скомпилированный код.
+// Функция уже проверена: это FUNCTION нужной арности.
+class FunctionCaller {
+public:
+    virtual ~FunctionCaller() = default;
+    virtual Value call(const Value& function, const Value* args, size_t count) = 0;
+    // Функция скрипта чистая (PurityAnalyzer): не присваивает внешним
+    // переменным, не печатает, вызывает только чистые функции
+    virtual bool isPure(const Value& function) const = 0;
+    // Исполнитель для другого потока (parallelMap): видит привязки текущего
+    // вызова только для чтения и работает в потоке, где создан.
+    // nullptr — исполнитель умеет вызывать функции только в своём потоке.
+    virtual std::unique_ptr<FunctionCaller> fork() { return nullptr; }
+    // Дешёвый ответ, вернёт ли fork исполнитель, без создания копии
+    virtual bool canFork() const { return false; }
+};
+
+// Методы массива: push, pop, slice, indexOf, concat, map, filter, reduce.
+// push и pop меняют receiver на месте — вызывающий передаёт саму переменную.
+// Остальные читают снимок элементов, даже если колбэк изменит receiver.
+Value callArrayMethod(Value& receiver, Symbol method, const Value* args, size_t count,
+                      FunctionCaller& caller);
+
+// Проверки перед вызовом: имя связано с функцией подходящей арности.
+// Выполняются до вычисления аргументов, как в интерпретаторе.
+// Имя, которое нигде не определено, ищется среди встроенных функций.
+Value lookupFunction(Environment& env, Symbol name, size_t argumentCount);
+
+// Встроенные функции над массивами чисел: sum, min, max, dot, scale, add (array.h).
+// Это родные функции (Value::NATIVE), как и зарегистрированные встраивающим
+// приложением. Определения скрипта важнее: встроенная находится, только если имя не связано.
+const Value* findBuiltin(Symbol name);
+
+// Вызов родной функции: аргументы передаются без копирования, результат — перемещением
+inline Value callNative(const Value& function, const Value* args, size_t count, FunctionCaller& caller) {
+    const NativeFunction& native = *function.nativeFunction;
+    return native.higherOrder ? native.higherOrder(args, caller) : native.function(args, count);
+}
+
+// Предел глубины вызовов по умолчанию (--max-depth); глубже — "Stack overflow"
+const size_t DEFAULT_MAX_CALL_DEPTH = 10000;
+
+// Сторож родного стека для рекурсивных исполнителей (обход AST, код --emit-cpp).
+// Кадр вызова функции языка занимает на стеке от сотен байт до нескольких
+// килобайт в зависимости от сборки, поэтому одного предела глубины мало:
+// при каждом вызове проверяется, что до конца стека потока остался запас.
+class StackGuard {
+private:
+    uintptr_t limit = 0; // Ниже этого адреса стек считается исчерпанным
+    size_t segments = 0; // Сколько сегментов стека (StackSegment) уже под текущим
+
+public:
+    // Определить границы стека текущего потока
+    void attachToCurrentThread();
+    // Стек, выделенный вручную (сопрограммы, coroutine.h): lowest — нижний адрес;
+    // segmentDepth — глубина цепочки сегментов, на вершине которой лежит этот стек
+    void attachToStack(const void* lowest, size_t size, size_t segmentDepth = 0);
+    size_t segmentCount() const { return segments; }
+    bool exhausted() const {
+        char marker;
+        return reinterpret_cast<uintptr_t>(&marker) < limit;
+    }
+};
+
+// Продолжение стека в куче. Когда StackGuard видит, что родной стек кончается,
+// вызов выполняется на новом сегменте, а после него управление возвращается на
+// прежний стек. Сегмент только резервируется (mmap), страницы отображаются при
+// касании. Цепочка сегментов одного стека не длиннее MAX_STACK_SEGMENTS: глубже
+// вызов завершается ошибкой "Stack overflow", даже если --max-depth не достигнут.
+class StackSegment {
+public:
+    static constexpr size_t DEFAULT_SIZE = 8 * 1024 * 1024;
+
+    explicit StackSegment(size_t size = DEFAULT_SIZE);
+    ~StackSegment();
+    StackSegment(const StackSegment&) = delete;
+    StackSegment& operator=(const StackSegment&) = delete;
+
+    // Выполнить body на сегменте; исключение body пробрасывается здесь.
+    // Сопрограмма может приостановиться внутри body: сегмент живёт, пока run не вернётся.
+    void run(const std::function<void()>& body);
+
+    // Границы для StackGuard::attachToStack
+    const void* lowest() const;
+    size_t size() const { return length; }
+
+private:
+    char* memory = nullptr; // Вместе со сторожевой страницей внизу
+    size_t length;
+};
+
+const size_t MAX_STACK_SEGMENTS = 1;
+
+// Выполнить body на сегменте из spare (или новом), пока guard следит за ним;
+// затем вернуть guard и сохранить сегмент в spare для следующего раза
+template <typename Body>
+auto runOnStackSegment(StackGuard& guard, std::unique_ptr<StackSegment>& spare, Body body) -> decltype(body()) {
+    if (guard.segmentCount() >= MAX_STACK_SEGMENTS) {
+        throw std::runtime_error("Stack overflow");
+    }
+    std::unique_ptr<StackSegment> segment = spare ? std::move(spare) : std::make_unique<StackSegment>();
+    StackGuard outer = guard;
+    guard.attachToStack(segment->lowest(), segment->size(), outer.segmentCount() + 1);
+    decltype(body()) result;
+    try {
+        segment->run([&] { result = body(); });
+    } catch (...) {
+        guard = outer;
+        spare = std::move(segment);
+        throw;
+    }
+    guard = outer;
+    spare = std::move(segment);
+    return result;
+}
+
+// Скомпилированная функция получает окружение вызова с уже связанными параметрами
+using CompiledFunction = Value (*)(const std::shared_ptr<Environment>& env);
+using CompiledProgram = void (*)(const std::shared_ptr<Environment>& globals);
+
+// Тело-метка, по которому значение-функция находит свой машинный код
+std::shared_ptr<Block> registerCompiledFunction(CompiledFunction function, bool pure = false);
+Value callCompiledFunction(const std::shared_ptr<Environment>& env, const Value& function,
+                           const std::vector<Value>& args);
+
+// Колбэки методов массива в скомпилированной программе
+class CompiledFunctionCaller : public FunctionCaller {
+private:
+    const std::shared_ptr<Environment>& env;
+
+public:
+    explicit CompiledFunctionCaller(const std::shared_ptr<Environment>& env) : env(env) {}
+    Value call(const Value& function, const Value* args, size_t count) override;
+    bool isPure(const Value& function) const override;
+};
+
+// return вне функции: интерпретатор тоже не перехватывает этот случай
+struct ReturnOutsideFunction {};
+
+// Точка входа скомпилированной программы: ошибки времени выполнения
+// печатаются так же, как в Interpreter::interpret; maxCallDepth — --max-depth
+// на момент компиляции
+int runCompiledProgram(CompiledProgram program, size_t maxCallDepth = DEFAULT_MAX_CALL_DEPTH);
+
+#endif // RUNTIME_H
@@ -0,0 +1,67 @@
+#include "scheduler.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+thread_local Scheduler* current = nullptr;
+
+} // namespace
+
+Scheduler::Scheduler(Clock::duration timeSlice) : timeSlice(timeSlice) {}
+
+Scheduler::~Scheduler() = default;
+
+void Scheduler::spawn(Task task, unsigned priority) {
+    if (priority == 0) {
+        throw std::runtime_error("Task priority must be at least 1");
+    }
+    // Новая задача не должна обгонять остальных за всё их прошлое время
+    double pass = 0;
+    if (!entries.empty()) {
+        pass = std::min_element(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.pass < b.pass;
+        })->pass;
+    }
+    entries.push_back(Entry{std::make_unique<Coroutine>(std::move(task), TASK_STACK_SIZE), priority, pass});
+}
+
+void Scheduler::run() {
+    Scheduler* outer = current;
+    current = this;
+    while (!entries.empty()) {
+        auto next = std::min_element(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.pass < b.pass;
+        });
+        running = &*next;
+        Clock::time_point start = Clock::now();
+        sliceEnd = start + timeSlice;
+        std::exception_ptr error;
+        try {
+            next->coroutine->resume();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        running = nullptr;
+        double spent = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        next->pass += spent / next->priority;
+        if (next->coroutine->finished()) {
+            entries.erase(next);
+        } else {
+            switchCount++;
+        }
+        if (error) {
+            current = outer;
+            std::rethrow_exception(error);
+        }
+    }
+    current = outer;
+}
+
+void Scheduler::checkpoint() {
+    Scheduler* scheduler = current;
+    if (!scheduler || !scheduler->running || Clock::now() < scheduler->sliceEnd) {
+        return;
+    }
+    Coroutine::suspend(scheduler->running->coroutine.get());
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "coroutine.h"
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Кооперативный планировщик задач одного потока. Каждая задача выполняется
+// в своей сопрограмме и отдаёт поток в checkpoint, когда исчерпан её квант
+// времени. Интерпретатор вызывает checkpoint на обратных переходах циклов
+// и при вызовах функций (Interpreter::setPreemption), поэтому даже
+// while (true) одного скрипта не задерживает остальные дольше кванта.
+//
+// Очерёдность — по виртуальному времени (stride scheduling): задача тратит
+// его в обратной пропорции к приоритету, и следующей выполняется та, что
+// потратила меньше всех. Задача с приоритетом 2 получает вдвое больше
+// процессорного времени, чем задача с приоритетом 1.
+class Scheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = std::function<void()>;
+
+    explicit Scheduler(Clock::duration timeSlice = DEFAULT_TIME_SLICE);
+    // Незавершённые задачи отменяются (Coroutine::Cancelled)
+    ~Scheduler();
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // priority >= 1; исключение задачи пробрасывается из run
+    void spawn(Task task, unsigned priority = 1);
+    // Выполнять задачи, пока все не завершатся
+    void run();
+
+    // Из задачи: квант исчерпан — уступить поток. Вне планировщика ничего не делает.
+    static void checkpoint();
+
+    size_t switches() const { return switchCount; }
+
+    static constexpr Clock::duration DEFAULT_TIME_SLICE = std::chrono::milliseconds(10);
+    // Сколько обратных переходов и вызовов пропускать между checkpoint:
+    // чтение часов дороже проверки счётчика, а квант всё равно в миллисекундах
+    static constexpr size_t CHECKPOINT_INTERVAL = 256;
+    // Сопрограмма задачи выполняет целый скрипт: стек как у потока (выделяется лениво)
+    static constexpr size_t TASK_STACK_SIZE = 8 * 1024 * 1024;
+
+private:
+    struct Entry {
+        std::unique_ptr<Coroutine> coroutine;
+        unsigned priority;
+        double pass; // Потраченное виртуальное время, мкс / priority
+    };
+
+    Clock::duration timeSlice;
+    std::vector<Entry> entries;
+    Entry* running = nullptr;
+    Clock::time_point sliceEnd;
+    size_t switchCount = 0;
+};
+
+#endif // SCHEDULER_H
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "script.h"
+#include "interpreter.h"
+#include "lexer.h"
+#include "parser.h"
+#include "purity.h"
+#include <cstdlib>
+
+Script::Script(const std::string& source) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    program = parser.parse();
+    pragmas = lexer.getPragmas();
+    // Результат нужен мемоизации, JIT и parallelMap/parallelReduce; стоит один проход по AST
+    PurityAnalyzer().analyze(*program);
+}
+
+const Program& Script::getProgram() const {
+    return *program;
+}
+
+const std::vector<std::string>& Script::getPragmas() const {
+    return pragmas;
+}
+
+void Script::run(Interpreter& interpreter) const {
+    interpreter.interpret(*program);
+}
+
+Value scriptInput(const std::string& text) {
+    const char* begin = text.c_str();
+    char* end = nullptr;
+    double number = std::strtod(begin, &end);
+    if (end != begin && *end == '\0') {
+        return Value(number);
+    }
+    return Value(text);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include "ast.h"
+#include "environment.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class Interpreter;
+
+// Скрипт, подготовленный один раз: лексер, парсер и анализ чистоты работают
+// в конструкторе, а выполнять его можно сколько угодно раз — в новом или
+// сброшенном (Interpreter::reset) интерпретаторе. Входные данные передаются
+// через Interpreter::setGlobal, результаты читаются Interpreter::getGlobal.
+// Функции скрипта разделяют с ним тела, поэтому кэши мемоизации и JIT
+// интерпретатора переживают повторные запуски.
+class Script {
+private:
+    std::unique_ptr<Program> program;
+    std::vector<std::string> pragmas;
+
+public:
+    // Ошибки разбора печатаются в stderr, как при запуске файла
+    explicit Script(const std::string& source);
+
+    const Program& getProgram() const;
+    // Прагмы из комментариев (// @memoize ...), см. Lexer::getPragmas
+    const std::vector<std::string>& getPragmas() const;
+
+    void run(Interpreter& interpreter) const;
+};
+
+// Ввод скрипта из текста (строка манифеста --batch, запрос --serve):
+// число, если строка целиком число, иначе строка
+Value scriptInput(const std::string& text);
+
+#endif // SCRIPT_H
\ No newline at end of file
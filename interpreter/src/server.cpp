@@ -0,0 +1,518 @@
+#include "server.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int MAX_EVENTS = 64;
+// Строка запроса длиннее — ошибка протокола, соединение закрывается
+const size_t MAX_REQUEST_LENGTH = 64 * 1024;
+// Вывод копится до flush (print заканчивает строку std::endl) или до этого размера
+const size_t FRAME_SIZE = 4096;
+
+[[noreturn]] void fail(const std::string& what) {
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+sockaddr_un socketAddress(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path is too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+// Отправить всё; неблокирующий сокет ждёт места в буфере. false — клиент ушёл.
+bool sendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (sent > 0) {
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd writable{fd, POLLOUT, 0};
+            ::poll(&writable, 1, -1);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sendAll(int fd, const std::string& data) {
+    return sendAll(fd, data.data(), data.size());
+}
+
+std::string frame(const char* tag, const std::string& data) {
+    return std::string(tag) + " " + std::to_string(data.size()) + "\n" + data;
+}
+
+// Поток вывода скрипта: накопленное уходит клиенту кадром "TAG N\n"
+class FrameBuffer : public std::streambuf {
+private:
+    int fd;
+    const char* tag;
+    bool& broken;
+    char buffer[FRAME_SIZE];
+
+protected:
+    int overflow(int ch) override {
+        sync();
+        if (ch != traits_type::eof()) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override {
+        if (pptr() > pbase() && !broken) {
+            std::string header = std::string(tag) + " " + std::to_string(pptr() - pbase()) + "\n";
+            broken = !sendAll(fd, header) || !sendAll(fd, pbase(), static_cast<size_t>(pptr() - pbase()));
+        }
+        setp(buffer, buffer + FRAME_SIZE);
+        return 0;
+    }
+
+public:
+    FrameBuffer(int fd, const char* tag, bool& broken) : fd(fd), tag(tag), broken(broken) {
+        setp(buffer, buffer + FRAME_SIZE);
+    }
+};
+
+} // namespace
+
+Server::Server(const std::string& socketPath, size_t threads, Configure configure)
+    : socketPath(socketPath), threadCount(threads), configure(std::move(configure)) {}
+
+Server::~Server() {
+    // Задачи пула пишут в сокеты соединений: сначала дождаться их
+    pool.reset();
+    closeAll();
+}
+
+void Server::listen() {
+    sockaddr_un address = socketAddress(socketPath);
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) fail("Could not create socket");
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        if (errno != EADDRINUSE) fail("Could not bind " + socketPath);
+        // Файл сокета остался от упавшей службы, если к нему никто не подключён
+        int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool alive = probe >= 0 && ::connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) ::close(probe);
+        if (alive) {
+            throw std::runtime_error("Another server is listening on " + socketPath);
+        }
+        ::unlink(socketPath.c_str());
+        if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            fail("Could not bind " + socketPath);
+        }
+    }
+    if (::listen(listenFd, SOMAXCONN) < 0) fail("Could not listen on " + socketPath);
+}
+
+void Server::run() {
+    // Сигналы читаются через signalfd; маску наследуют потоки пула
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigset_t previous;
+    pthread_sigmask(SIG_BLOCK, &signals, &previous);
+
+    try {
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        signalFd = ::signalfd(-1, &signals, SFD_CLOEXEC | SFD_NONBLOCK);
+        if (epollFd < 0 || wakeFd < 0 || signalFd < 0) fail("Could not start server");
+        listen();
+        for (int fd : {listenFd, wakeFd, signalFd}) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        }
+
+        pool = std::make_unique<ThreadPool>(threadCount);
+        interpreters.resize(pool->size());
+
+        epoll_event events[MAX_EVENTS];
+        while (!stopping || active > 0) {
+            int count = ::epoll_wait(epollFd, events, MAX_EVENTS, -1);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                fail("epoll_wait");
+            }
+            for (int i = 0; i < count; i++) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptConnections();
+                } else if (fd == wakeFd) {
+                    uint64_t wakeups;
+                    while (::read(wakeFd, &wakeups, sizeof(wakeups)) > 0) {}
+                    finishCompleted();
+                } else if (fd == signalFd) {
+                    signalfd_siginfo info;
+                    while (::read(signalFd, &info, sizeof(info)) > 0) {}
+                    stop();
+                } else {
+                    auto found = connections.find(fd);
+                    if (found != connections.end()) {
+                        readRequests(fd, found->second);
+                    }
+                }
+            }
+        }
+    } catch (...) {
+        pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+        throw;
+    }
+
+    pool.reset();
+    closeAll();
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+void Server::acceptConnections() {
+    while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return; // EAGAIN: очередь пуста; нехватку дескрипторов повторит следующий epoll_wait
+        }
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        connections.emplace(fd, Connection());
+        accepted++;
+    }
+}
+
+void Server::readRequests(int fd, Connection& connection) {
+    char buffer[FRAME_SIZE];
+    bool ended = false;
+    while (true) {
+        ssize_t received = ::read(fd, buffer, sizeof(buffer));
+        if (received > 0) {
+            connection.received.append(buffer, static_cast<size_t>(received));
+        } else if (received < 0 && errno == EINTR) {
+            continue;
+        } else {
+            ended = received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+            break;
+        }
+    }
+
+    size_t start = 0;
+    size_t newline;
+    while ((newline = connection.received.find('\n', start)) != std::string::npos) {
+        std::string line = connection.received.substr(start, newline - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty() && !stopping) connection.requests.push_back(std::move(line));
+        start = newline + 1;
+    }
+    connection.received.erase(0, start);
+    if (connection.received.size() > MAX_REQUEST_LENGTH) {
+        connection.received.clear();
+        connection.requests.push_back("");
+        ended = true;
+    }
+
+    // Клиент закрыл запись: ответить на уже присланные запросы и закрыть
+    if (ended) {
+        ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        connection.closing = true;
+    }
+    dispatch(fd, connection);
+}
+
+void Server::dispatch(int fd, Connection& connection) {
+    while (!connection.running && !connection.requests.empty()) {
+        std::string request = std::move(connection.requests.front());
+        connection.requests.pop_front();
+
+        std::istringstream words(request);
+        std::string command;
+        words >> command;
+        if (command == "shutdown") {
+            sendAll(fd, "done 0\n");
+            stop();
+            return;
+        }
+        std::string path;
+        if (command != "run" || !(words >> path)) {
+            std::string message = request.empty() ? "Error: request is too long\n"
+                                                  : "Error: unknown request: " + request + "\n";
+            sendAll(fd, frame("err", message) + "done 0\n");
+            continue;
+        }
+        std::string input;
+        std::getline(words >> std::ws, input);
+        size_t inputEnd = input.find_last_not_of(" \t");
+        input.erase(inputEnd == std::string::npos ? 0 : inputEnd + 1);
+
+        // Запрос держит свою версию скрипта, даже если файл разберут заново
+        auto cached = std::make_shared<CachedScript>(loadScript(path));
+        connection.running = true;
+        active++;
+        pool->submit([this, fd, cached, input] {
+            bool broken = !execute(fd, *cached, input);
+            {
+                std::lock_guard<std::mutex> lock(completedMutex);
+                completed.push_back({fd, broken});
+            }
+            uint64_t one = 1;
+            ssize_t written = ::write(wakeFd, &one, sizeof(one));
+            (void)written; // Счётчик eventfd не переполнится: поток epoll его вычитывает
+        });
+    }
+    if (connection.closing && !connection.running) {
+        closeConnection(fd);
+    }
+}
+
+bool Server::execute(int fd, const CachedScript& cached, const std::string& input) {
+    Clock::time_point start = Clock::now();
+    bool broken = false;
+    FrameBuffer outputBuffer(fd, "out", broken);
+    FrameBuffer errorBuffer(fd, "err", broken);
+    std::ostream output(&outputBuffer);
+    std::ostream errors(&errorBuffer);
+
+    errors << cached.errors;
+    if (cached.script) {
+        try {
+            std::unique_ptr<Interpreter>& interpreter = interpreters[pool->currentWorker()];
+            if (!interpreter) {
+                interpreter = std::make_unique<Interpreter>();
+                configure(*interpreter);
+            }
+            interpreter->setOutput(output, errors);
+            interpreter->reset();
+            if (!input.empty()) {
+                interpreter->setGlobal("input", scriptInput(input));
+            }
+            cached.script->run(*interpreter);
+        } catch (const std::exception& e) {
+            errors << "Error: " << e.what() << "\n";
+        } catch (...) {
+            // return вне функции: без службы он завершил бы процесс
+            errors << "Error: script terminated by return outside a function\n";
+        }
+    }
+    output.flush();
+    errors.flush();
+
+    long long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    if (!broken) {
+        broken = !sendAll(fd, "done " + std::to_string(elapsed) + "\n");
+    }
+    return !broken;
+}
+
+void Server::finishCompleted() {
+    std::vector<Completion> finished;
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        finished.swap(completed);
+    }
+    for (const Completion& completion : finished) {
+        Connection& connection = connections.at(completion.fd);
+        connection.running = false;
+        active--;
+        served++;
+        if (completion.broken || stopping) {
+            connection.requests.clear();
+            connection.closing = true;
+        }
+        dispatch(completion.fd, connection);
+    }
+}
+
+void Server::closeConnection(int fd) {
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+}
+
+void Server::stop() {
+    if (stopping) return;
+    stopping = true;
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, listenFd, nullptr);
+    ::close(listenFd);
+    listenFd = -1;
+    ::unlink(socketPath.c_str());
+    // Незанятые соединения закрываются сразу, занятые — после своего запроса
+    std::vector<int> idle;
+    for (auto& [fd, connection] : connections) {
+        connection.requests.clear();
+        connection.closing = true;
+        if (!connection.running) idle.push_back(fd);
+    }
+    for (int fd : idle) {
+        closeConnection(fd);
+    }
+}
+
+void Server::closeAll() {
+    for (auto& entry : connections) {
+        ::close(entry.first);
+    }
+    connections.clear();
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        ::unlink(socketPath.c_str());
+    }
+    for (int* fd : {&listenFd, &epollFd, &wakeFd, &signalFd}) {
+        if (*fd >= 0) ::close(*fd);
+        *fd = -1;
+    }
+}
+
+const Server::CachedScript& Server::loadScript(const std::string& path) {
+    std::error_code error;
+    std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, error);
+    auto found = scripts.find(path);
+    if (found != scripts.end() && !error && found->second.modified == modified) {
+        return found->second;
+    }
+
+    CachedScript cached;
+    cached.modified = modified;
+    // Parser печатает ошибки в std::cerr, а работники в него не пишут:
+    // подменить его на время разбора в потоке epoll безопасно
+    std::ostringstream parseErrors;
+    std::streambuf* saved = std::cerr.rdbuf(parseErrors.rdbuf());
+    try {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open file: " + path);
+        }
+        std::stringstream source;
+        source << file.rdbuf();
+        cached.script = std::make_shared<const Script>(source.str());
+    } catch (const std::exception& e) {
+        parseErrors << "Error: " << e.what() << std::endl;
+    }
+    std::cerr.rdbuf(saved);
+    cached.errors = parseErrors.str();
+    parses++;
+
+    if (found == scripts.end()) {
+        return scripts.emplace(path, std::move(cached)).first->second;
+    }
+    if (found->second.script) {
+        retired.push_back(std::move(found->second.script));
+    }
+    found->second = std::move(cached);
+    return found->second;
+}
+
+void Server::printStats(std::ostream& os) const {
+    os << "Serve: requests=" << served << " connections=" << accepted << " scripts=" << scripts.size()
+       << " parses=" << parses << " threads=" << threadCount << std::endl;
+}
+
+ServerClient::ServerClient(const std::string& socketPath, std::chrono::milliseconds timeout) {
+    sockaddr_un address = socketAddress(socketPath);
+    Clock::time_point deadline = Clock::now() + timeout;
+    while (true) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) fail("Could not create socket");
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) return;
+        int reason = errno;
+        ::close(fd);
+        fd = -1;
+        // Служба ещё не создала сокет или не начала слушать
+        if ((reason != ENOENT && reason != ECONNREFUSED) || Clock::now() >= deadline) {
+            errno = reason;
+            fail("Could not connect to " + socketPath);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+ServerClient::~ServerClient() {
+    if (fd >= 0) ::close(fd);
+}
+
+void ServerClient::run(const std::string& path, const std::string& input, std::ostream& out,
+                       std::ostream& errors) {
+    std::string request = "run " + path;
+    if (!input.empty()) request += " " + input;
+    if (!sendAll(fd, request + "\n")) fail("Could not send request");
+    while (true) {
+        std::string header = readLine();
+        size_t space = header.find(' ');
+        std::string tag = header.substr(0, space);
+        if (tag == "done") return;
+        if ((tag != "out" && tag != "err") || space == std::string::npos) {
+            throw std::runtime_error("Unexpected server response: " + header);
+        }
+        readBytes(std::stoul(header.substr(space + 1)), tag == "out" ? out : errors);
+        (tag == "out" ? out : errors).flush();
+    }
+}
+
+void ServerClient::shutdown() {
+    if (!sendAll(fd, "shutdown\n")) fail("Could not send request");
+    readLine();
+}
+
+void ServerClient::fill() {
+    char buffer[FRAME_SIZE];
+    while (true) {
+        ssize_t received = ::read(fd, buffer, sizeof(buffer));
+        if (received > 0) {
+            buffered.append(buffer, static_cast<size_t>(received));
+            return;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        if (received == 0) throw std::runtime_error("Server closed the connection");
+        fail("Could not read response");
+    }
+}
+
+std::string ServerClient::readLine() {
+    size_t newline;
+    while ((newline = buffered.find('\n')) == std::string::npos) {
+        fill();
+    }
+    std::string line = buffered.substr(0, newline);
+    buffered.erase(0, newline + 1);
+    return line;
+}
+
+void ServerClient::readBytes(size_t count, std::ostream& destination) {
+    while (count > 0) {
+        if (buffered.empty()) fill();
+        size_t taken = std::min(count, buffered.size());
+        destination.write(buffered.data(), static_cast<std::streamsize>(taken));
+        buffered.erase(0, taken);
+        count -= taken;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "interpreter.h"
+#include "script.h"
+#include "threadpool.h"
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Служба (--serve): процесс держит тёплые интерпретаторы и выполняет скрипты
+// по запросам через локальный Unix-сокет. Разобранные скрипты, снимок
+// прелюдии, кэши мемоизации и машинный код JIT переживают запросы, поэтому
+// запрос не платит за запуск процесса, разбор и прелюдию.
+//
+// Протокол строчный. Запросы:
+//   run PATH [INPUT]   выполнить скрипт; INPUT — глобальная input, как в --batch
+//   shutdown           доделать начатые запросы и завершить службу
+// Ответ — кадры "out N\n" и "err N\n" с N байтами вывода print или сообщений
+// об ошибках, по мере того как скрипт их печатает, и в конце "done US\n" —
+// время выполнения в микросекундах. Запросы одного соединения выполняются
+// по очереди, разных соединений — параллельно.
+//
+// Сокеты опрашивает один поток через epoll, скрипты выполняются на пуле
+// потоков, у каждого работника свой интерпретатор.
+class Server {
+public:
+    using Configure = std::function<void(Interpreter&)>;
+
+    // configure настраивает интерпретатор каждого работника (JIT, снимок)
+    Server(const std::string& socketPath, size_t threads, Configure configure);
+    ~Server();
+
+    // Принимать запросы до shutdown, SIGINT или SIGTERM
+    void run();
+    void printStats(std::ostream& os) const;
+
+private:
+    // Скрипт разбирается при первом запросе и заново, когда меняется файл
+    struct CachedScript {
+        std::shared_ptr<const Script> script;
+        std::string errors; // Ошибки чтения и разбора — часть вывода каждого запуска
+        std::filesystem::file_time_type modified;
+    };
+    struct Connection {
+        std::string received; // Начало незаконченной строки
+        std::deque<std::string> requests;
+        bool running = false; // Запрос выполняется на пуле, сокет пишет работник
+        bool closing = false; // Закрыть, как только выполнится текущий запрос
+    };
+    struct Completion {
+        int fd;
+        bool broken; // Клиент ушёл, не дождавшись ответа
+    };
+
+    std::string socketPath;
+    size_t threadCount;
+    Configure configure;
+
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;   // eventfd: работник выполнил запрос
+    int signalFd = -1; // SIGINT и SIGTERM
+    bool stopping = false;
+
+    // Кэш и соединения принадлежат потоку epoll
+    std::unordered_map<std::string, CachedScript> scripts;
+    // Старые версии изменённых скриптов: кэши мемоизации и JIT работников
+    // ищут тела функций по адресу, поэтому тела не освобождаются до конца службы
+    std::vector<std::shared_ptr<const Script>> retired;
+    std::unordered_map<int, Connection> connections;
+    size_t active = 0;
+
+    std::mutex completedMutex;
+    std::vector<Completion> completed;
+
+    size_t served = 0;
+    size_t accepted = 0;
+    size_t parses = 0;
+
+    std::vector<std::unique_ptr<Interpreter>> interpreters; // По работнику пула
+    std::unique_ptr<ThreadPool> pool;
+
+    void listen();
+    void acceptConnections();
+    void readRequests(int fd, Connection& connection);
+    void dispatch(int fd, Connection& connection);
+    void finishCompleted();
+    void closeConnection(int fd);
+    void stop();
+    void closeAll();
+    const CachedScript& loadScript(const std::string& path);
+    // В работнике пула: выполнить скрипт и отправить ответ; false — клиент ушёл
+    bool execute(int fd, const CachedScript& cached, const std::string& input);
+};
+
+// Соединение со службой; запросы выполняются по очереди
+class ServerClient {
+public:
+    // Пока служба запускается, подключение повторяется до timeout
+    ServerClient(const std::string& socketPath, std::chrono::milliseconds timeout);
+    ~ServerClient();
+    ServerClient(const ServerClient&) = delete;
+    ServerClient& operator=(const ServerClient&) = delete;
+
+    // Выполнить скрипт path (путь для службы) с вводом input; пустой — без ввода.
+    // Кадры вывода и ошибок передаются в out и errors по мере прихода.
+    void run(const std::string& path, const std::string& input, std::ostream& out, std::ostream& errors);
+    void shutdown();
+
+private:
+    int fd = -1;
+    std::string buffered;
+
+    std::string readLine();
+    void readBytes(size_t count, std::ostream& destination);
+    void fill();
+};
+
+#endif // SERVER_H
\ No newline at end of file
@@ -0,0 +1,619 @@
+#include "snapshot.h"
+#include "array.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+const char MAGIC[8] = {'S', 'N', 'A', 'P', 'S', 'H', 'O', 'T'};
+// Меняется вместе с форматом образа или составом узлов AST
+const uint32_t VERSION = 1;
+// Имя ещё не переведено в символ
+const Symbol NO_SYMBOL = UINT32_MAX;
+
+enum NodeTag : uint8_t {
+    NO_NODE,
+    NUMBER_LITERAL, STRING_LITERAL, BOOLEAN_LITERAL, NULL_LITERAL, IDENTIFIER,
+    BINARY_OPERATION, UNARY_OPERATION, AWAIT_EXPRESSION, FUNCTION_CALL,
+    ARRAY_LITERAL, INDEX_EXPRESSION, OBJECT_LITERAL, PROPERTY_ACCESS, METHOD_CALL,
+    EXPRESSION_STATEMENT, BLOCK, VARIABLE_DECLARATION, ASSIGNMENT, IF_STATEMENT,
+    WHILE_STATEMENT, RETURN_STATEMENT, YIELD_STATEMENT, PRINT_STATEMENT,
+    FUNCTION_DECLARATION, FOR_STATEMENT, FOR_IN_STATEMENT
+};
+
+enum ValueTag : uint8_t {
+    NIL_VALUE, NUMBER_VALUE, STRING_VALUE, BOOLEAN_VALUE,
+    NUMBER_ARRAY, ARRAY_VALUE, OBJECT_VALUE, FUNCTION_VALUE
+};
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+class SnapshotWriter {
+private:
+    const std::function<unsigned(const Block*)>& flags;
+    std::unordered_map<std::string, uint32_t> stringIds;
+    std::string strings;
+    std::unordered_map<const Block*, uint32_t> functionIds;
+    std::string functions;
+
+public:
+    std::string globals;
+
+    explicit SnapshotWriter(const std::function<unsigned(const Block*)>& flags) : flags(flags) {}
+
+    uint32_t stringId(const std::string& text) {
+        auto [it, inserted] = stringIds.emplace(text, static_cast<uint32_t>(stringIds.size()));
+        if (inserted) {
+            put(strings, static_cast<uint32_t>(text.size()));
+            strings += text;
+        }
+        return it->second;
+    }
+
+    void writeNodes(std::string& out, const std::vector<std::unique_ptr<Expression>>& nodes) {
+        put(out, static_cast<uint32_t>(nodes.size()));
+        for (const auto& node : nodes) {
+            writeNode(out, node.get());
+        }
+    }
+
+    void writeNode(std::string& out, const ASTNode* node) {
+        if (!node) {
+            put(out, NO_NODE);
+        } else if (auto num = dynamic_cast<const NumberLiteral*>(node)) {
+            put(out, NUMBER_LITERAL);
+            put(out, num->value);
+        } else if (auto str = dynamic_cast<const StringLiteral*>(node)) {
+            put(out, STRING_LITERAL);
+            put(out, stringId(*str->value));
+        } else if (auto boolean = dynamic_cast<const BooleanLiteral*>(node)) {
+            put(out, BOOLEAN_LITERAL);
+            put(out, static_cast<uint8_t>(boolean->value));
+        } else if (dynamic_cast<const NullLiteral*>(node)) {
+            put(out, NULL_LITERAL);
+        } else if (auto id = dynamic_cast<const Identifier*>(node)) {
+            put(out, IDENTIFIER);
+            put(out, stringId(id->name));
+        } else if (auto binOp = dynamic_cast<const BinaryOperation*>(node)) {
+            put(out, BINARY_OPERATION);
+            put(out, stringId(binOp->op));
+            writeNode(out, binOp->left.get());
+            writeNode(out, binOp->right.get());
+        } else if (auto unary = dynamic_cast<const UnaryOperation*>(node)) {
+            put(out, UNARY_OPERATION);
+            put(out, stringId(unary->op));
+            writeNode(out, unary->operand.get());
+        } else if (auto await = dynamic_cast<const AwaitExpression*>(node)) {
+            put(out, AWAIT_EXPRESSION);
+            writeNode(out, await->operand.get());
+        } else if (auto call = dynamic_cast<const FunctionCall*>(node)) {
+            put(out, FUNCTION_CALL);
+            put(out, stringId(call->functionName));
+            writeNodes(out, call->arguments);
+        } else if (auto array = dynamic_cast<const ArrayLiteral*>(node)) {
+            put(out, ARRAY_LITERAL);
+            writeNodes(out, array->elements);
+        } else if (auto index = dynamic_cast<const IndexExpression*>(node)) {
+            put(out, INDEX_EXPRESSION);
+            writeNode(out, index->object.get());
+            writeNode(out, index->index.get());
+        } else if (auto object = dynamic_cast<const ObjectLiteral*>(node)) {
+            put(out, OBJECT_LITERAL);
+            put(out, static_cast<uint32_t>(object->properties.size()));
+            for (const auto& [key, value] : object->properties) {
+                put(out, stringId(key));
+                writeNode(out, value.get());
+            }
+        } else if (auto property = dynamic_cast<const PropertyAccess*>(node)) {
+            put(out, PROPERTY_ACCESS);
+            put(out, stringId(property->property));
+            writeNode(out, property->object.get());
+        } else if (auto method = dynamic_cast<const MethodCall*>(node)) {
+            put(out, METHOD_CALL);
+            put(out, stringId(method->method));
+            writeNode(out, method->object.get());
+            writeNodes(out, method->arguments);
+        } else if (auto exprStmt = dynamic_cast<const ExpressionStatement*>(node)) {
+            put(out, EXPRESSION_STATEMENT);
+            writeNode(out, exprStmt->expression.get());
+        } else if (auto block = dynamic_cast<const Block*>(node)) {
+            put(out, BLOCK);
+            put(out, static_cast<uint32_t>(block->statements.size()));
+            for (const auto& stmt : block->statements) {
+                writeNode(out, stmt.get());
+            }
+        } else if (auto varDecl = dynamic_cast<const VariableDeclaration*>(node)) {
+            put(out, VARIABLE_DECLARATION);
+            put(out, stringId(varDecl->variableName));
+            writeNode(out, varDecl->initializer.get());
+        } else if (auto assignment = dynamic_cast<const Assignment*>(node)) {
+            put(out, ASSIGNMENT);
+            put(out, stringId(assignment->variableName));
+            writeNode(out, assignment->value.get());
+            writeNode(out, assignment->target.get());
+        } else if (auto ifStmt = dynamic_cast<const IfStatement*>(node)) {
+            put(out, IF_STATEMENT);
+            writeNode(out, ifStmt->condition.get());
+            writeNode(out, ifStmt->thenBlock.get());
+            writeNode(out, ifStmt->elseBlock.get());
+        } else if (auto whileStmt = dynamic_cast<const WhileStatement*>(node)) {
+            put(out, WHILE_STATEMENT);
+            writeNode(out, whileStmt->condition.get());
+            writeNode(out, whileStmt->body.get());
+        } else if (auto returnStmt = dynamic_cast<const ReturnStatement*>(node)) {
+            put(out, RETURN_STATEMENT);
+            writeNode(out, returnStmt->value.get());
+        } else if (auto yieldStmt = dynamic_cast<const YieldStatement*>(node)) {
+            put(out, YIELD_STATEMENT);
+            writeNode(out, yieldStmt->value.get());
+        } else if (auto printStmt = dynamic_cast<const PrintStatement*>(node)) {
+            put(out, PRINT_STATEMENT);
+            writeNode(out, printStmt->expression.get());
+        } else if (auto funcDecl = dynamic_cast<const FunctionDeclaration*>(node)) {
+            put(out, FUNCTION_DECLARATION);
+            unsigned declFlags = (funcDecl->isPure ? SNAPSHOT_PURE : 0u) | (funcDecl->isAsync ? SNAPSHOT_ASYNC : 0u) |
+                                 (funcDecl->isGenerator ? SNAPSHOT_GENERATOR : 0u);
+            writeSignature(out, funcDecl->functionName, funcDecl->parameters, declFlags);
+            writeNode(out, funcDecl->body.get());
+        } else if (auto forStmt = dynamic_cast<const ForStatement*>(node)) {
+            put(out, FOR_STATEMENT);
+            writeNode(out, forStmt->initializer.get());
+            writeNode(out, forStmt->condition.get());
+            writeNode(out, forStmt->increment.get());
+            writeNode(out, forStmt->body.get());
+        } else if (auto forIn = dynamic_cast<const ForInStatement*>(node)) {
+            put(out, FOR_IN_STATEMENT);
+            put(out, stringId(forIn->variableName));
+            writeNode(out, forIn->iterable.get());
+            writeNode(out, forIn->body.get());
+        } else {
+            throw std::runtime_error("Cannot write snapshot: unknown AST node");
+        }
+    }
+
+    void writeSignature(std::string& out, const std::string& name, const std::vector<std::string>& parameters,
+                        unsigned signatureFlags) {
+        put(out, stringId(name));
+        put(out, static_cast<uint32_t>(parameters.size()));
+        for (const std::string& parameter : parameters) {
+            put(out, stringId(parameter));
+        }
+        put(out, static_cast<uint8_t>(signatureFlags));
+    }
+
+    // Тело пишется один раз, сколько бы значений на него ни ссылалось
+    uint32_t functionId(const Value& function, const std::string& name) {
+        auto found = functionIds.find(function.body.get());
+        if (found != functionIds.end()) {
+            return found->second;
+        }
+        uint32_t id = static_cast<uint32_t>(functionIds.size());
+        functionIds.emplace(function.body.get(), id);
+        std::vector<std::string> parameters;
+        for (Symbol parameter : function.parameters) {
+            parameters.push_back(symbolName(parameter));
+        }
+        writeSignature(functions, name, parameters, flags(function.body.get()));
+        writeNode(functions, function.body.get());
+        return id;
+    }
+
+    void writeValue(std::string& out, const Value& value, const std::string& name) {
+        switch (value.type) {
+            case Value::NIL:
+                put(out, NIL_VALUE);
+                break;
+            case Value::NUMBER:
+                put(out, NUMBER_VALUE);
+                put(out, value.numberValue);
+                break;
+            case Value::STRING:
+                put(out, STRING_VALUE);
+                put(out, stringId(value.stringValue()));
+                break;
+            case Value::BOOLEAN:
+                put(out, BOOLEAN_VALUE);
+                put(out, static_cast<uint8_t>(value.booleanValue));
+                break;
+            case Value::ARRAY: {
+                static const ArrayStorage empty;
+                const ArrayStorage& array = value.arrayValue ? *value.arrayValue : empty;
+                if (array.kind() == ArrayStorage::PACKED_DOUBLE) {
+                    put(out, NUMBER_ARRAY);
+                    put(out, static_cast<uint32_t>(array.size()));
+                    out.append(reinterpret_cast<const char*>(array.numbers().data()), array.size() * sizeof(double));
+                } else {
+                    put(out, ARRAY_VALUE);
+                    put(out, static_cast<uint32_t>(array.size()));
+                    for (const Value& element : array.elements()) {
+                        writeValue(out, element, name);
+                    }
+                }
+                break;
+            }
+            case Value::OBJECT: {
+                // Ключи по порядку имён: образ одной прелюдии всегда одинаков
+                std::vector<std::pair<std::string, const Value*>> properties;
+                if (value.objectValue) {
+                    for (const auto& [key, property] : *value.objectValue) {
+                        properties.emplace_back(symbolName(key), &property);
+                    }
+                }
+                std::sort(properties.begin(), properties.end());
+                put(out, OBJECT_VALUE);
+                put(out, static_cast<uint32_t>(properties.size()));
+                for (const auto& [key, property] : properties) {
+                    put(out, stringId(key));
+                    writeValue(out, *property, key);
+                }
+                break;
+            }
+            case Value::FUNCTION:
+                put(out, FUNCTION_VALUE);
+                put(out, functionId(value, name));
+                break;
+            default:
+                throw std::runtime_error("Cannot write snapshot: '" + name + "' holds " + value.toString() +
+                                         ", only data and functions can be saved");
+        }
+    }
+
+    std::string image(uint32_t globalCount) const {
+        std::string out(MAGIC, sizeof(MAGIC));
+        put(out, VERSION);
+        put(out, static_cast<uint32_t>(stringIds.size()));
+        put(out, static_cast<uint32_t>(functionIds.size()));
+        put(out, globalCount);
+        out += strings;
+        out += functions;
+        out += globals;
+        return out;
+    }
+};
+
+// Образ, отображённый в память только для чтения
+class MappedFile {
+public:
+    const char* data = nullptr;
+    size_t size = 0;
+
+    explicit MappedFile(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open snapshot: " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            size = static_cast<size_t>(info.st_size);
+            void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            data = memory == MAP_FAILED ? nullptr : static_cast<const char*>(memory);
+        }
+        close(fd);
+        if (!data) {
+            throw std::runtime_error("Could not map snapshot: " + path);
+        }
+    }
+    ~MappedFile() {
+        munmap(const_cast<char*>(data), size);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
+class SnapshotReader {
+private:
+    const char* position;
+    const char* end;
+    // Строки образа разворачиваются по первому обращению: имена нужны
+    // как символы, и общее хранилище создаётся только для строковых значений
+    struct StringEntry {
+        const char* data;
+        uint32_t length;
+        StringStorage storage;
+        Symbol symbol = NO_SYMBOL;
+    };
+    std::vector<StringEntry> strings;
+
+    [[noreturn]] static void corrupt() {
+        throw std::runtime_error("Corrupt snapshot");
+    }
+
+public:
+    SnapshotImage image;
+
+    SnapshotReader(const char* data, size_t size) : position(data), end(data + size) {}
+
+    template <typename T>
+    T get() {
+        if (static_cast<size_t>(end - position) < sizeof(T)) corrupt();
+        T value;
+        std::memcpy(&value, position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+
+    StringEntry& entry() {
+        uint32_t id = get<uint32_t>();
+        if (id >= strings.size()) corrupt();
+        return strings[id];
+    }
+
+    const StringStorage& string() {
+        StringEntry& string = entry();
+        if (!string.storage) {
+            string.storage = std::make_shared<const std::string>(string.data, string.length);
+        }
+        return string.storage;
+    }
+
+    std::string text() {
+        StringEntry& string = entry();
+        return std::string(string.data, string.length);
+    }
+
+    Symbol symbol() {
+        StringEntry& string = entry();
+        if (string.symbol == NO_SYMBOL) {
+            string.symbol = intern(std::string(string.data, string.length));
+        }
+        return string.symbol;
+    }
+
+    void readStrings(uint32_t count) {
+        if (count > static_cast<size_t>(end - position) / sizeof(uint32_t)) corrupt();
+        strings.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t length = get<uint32_t>();
+            if (static_cast<size_t>(end - position) < length) corrupt();
+            strings.push_back(StringEntry{position, length, nullptr});
+            position += length;
+        }
+    }
+
+    template <typename T>
+    std::unique_ptr<T> node() {
+        std::unique_ptr<ASTNode> read = readNode();
+        if (!read) return nullptr;
+        T* typed = dynamic_cast<T*>(read.get());
+        if (!typed) corrupt();
+        read.release();
+        return std::unique_ptr<T>(typed);
+    }
+
+    template <typename T>
+    std::unique_ptr<T> required() {
+        std::unique_ptr<T> read = node<T>();
+        if (!read) corrupt();
+        return read;
+    }
+
+    std::vector<std::unique_ptr<Expression>> expressions() {
+        uint32_t count = get<uint32_t>();
+        std::vector<std::unique_ptr<Expression>> nodes;
+        for (uint32_t i = 0; i < count; i++) {
+            nodes.push_back(required<Expression>());
+        }
+        return nodes;
+    }
+
+    std::unique_ptr<FunctionDeclaration> function() {
+        std::string name = text();
+        uint32_t count = get<uint32_t>();
+        std::vector<std::string> parameters;
+        for (uint32_t i = 0; i < count; i++) {
+            parameters.push_back(text());
+        }
+        uint8_t flags = get<uint8_t>();
+        auto decl = std::make_unique<FunctionDeclaration>(name, parameters, required<Block>());
+        decl->isPure = flags & SNAPSHOT_PURE;
+        decl->isAsync = flags & SNAPSHOT_ASYNC;
+        decl->isGenerator = flags & SNAPSHOT_GENERATOR;
+        return decl;
+    }
+
+    std::unique_ptr<ASTNode> readNode() {
+        switch (get<uint8_t>()) {
+            case NO_NODE: return nullptr;
+            case NUMBER_LITERAL: return std::make_unique<NumberLiteral>(get<double>());
+            case STRING_LITERAL: return std::make_unique<StringLiteral>(string());
+            case BOOLEAN_LITERAL: return std::make_unique<BooleanLiteral>(get<uint8_t>() != 0);
+            case NULL_LITERAL: return std::make_unique<NullLiteral>();
+            case IDENTIFIER: return std::make_unique<Identifier>(text());
+            case BINARY_OPERATION: {
+                std::string op = text();
+                auto left = required<Expression>();
+                return std::make_unique<BinaryOperation>(std::move(left), op, required<Expression>());
+            }
+            case UNARY_OPERATION: {
+                std::string op = text();
+                return std::make_unique<UnaryOperation>(op, required<Expression>());
+            }
+            case AWAIT_EXPRESSION: return std::make_unique<AwaitExpression>(required<Expression>());
+            case FUNCTION_CALL: {
+                std::string name = text();
+                return std::make_unique<FunctionCall>(name, expressions());
+            }
+            case ARRAY_LITERAL: return std::make_unique<ArrayLiteral>(expressions());
+            case INDEX_EXPRESSION: {
+                auto object = required<Expression>();
+                return std::make_unique<IndexExpression>(std::move(object), required<Expression>());
+            }
+            case OBJECT_LITERAL: {
+                uint32_t count = get<uint32_t>();
+                std::vector<std::pair<std::string, std::unique_ptr<Expression>>> properties;
+                for (uint32_t i = 0; i < count; i++) {
+                    std::string key = text();
+                    properties.emplace_back(key, required<Expression>());
+                }
+                return std::make_unique<ObjectLiteral>(std::move(properties));
+            }
+            case PROPERTY_ACCESS: {
+                std::string property = text();
+                return std::make_unique<PropertyAccess>(required<Expression>(), property);
+            }
+            case METHOD_CALL: {
+                std::string method = text();
+                auto object = required<Expression>();
+                return std::make_unique<MethodCall>(std::move(object), method, expressions());
+            }
+            case EXPRESSION_STATEMENT: return std::make_unique<ExpressionStatement>(required<Expression>());
+            case BLOCK: {
+                uint32_t count = get<uint32_t>();
+                auto block = std::make_unique<Block>();
+                for (uint32_t i = 0; i < count; i++) {
+                    block->addStatement(required<Statement>());
+                }
+                return block;
+            }
+            case VARIABLE_DECLARATION: {
+                std::string name = text();
+                return std::make_unique<VariableDeclaration>(name, node<Expression>());
+            }
+            case ASSIGNMENT: {
+                std::string name = text();
+                auto value = required<Expression>();
+                return std::make_unique<Assignment>(name, std::move(value), node<Expression>());
+            }
+            case IF_STATEMENT: {
+                auto condition = required<Expression>();
+                auto thenBlock = required<Block>();
+                return std::make_unique<IfStatement>(std::move(condition), std::move(thenBlock), node<Block>());
+            }
+            case WHILE_STATEMENT: {
+                auto condition = required<Expression>();
+                return std::make_unique<WhileStatement>(std::move(condition), required<Block>());
+            }
+            case RETURN_STATEMENT: return std::make_unique<ReturnStatement>(node<Expression>());
+            case YIELD_STATEMENT: return std::make_unique<YieldStatement>(required<Expression>());
+            case PRINT_STATEMENT: return std::make_unique<PrintStatement>(required<Expression>());
+            case FUNCTION_DECLARATION: return function();
+            case FOR_STATEMENT: {
+                auto initializer = node<Statement>();
+                auto condition = node<Expression>();
+                auto increment = node<Expression>();
+                return std::make_unique<ForStatement>(std::move(initializer), std::move(condition),
+                                                      std::move(increment), required<Block>());
+            }
+            case FOR_IN_STATEMENT: {
+                std::string name = text();
+                auto iterable = required<Expression>();
+                return std::make_unique<ForInStatement>(name, std::move(iterable), required<Block>());
+            }
+            default: corrupt();
+        }
+    }
+
+    Value readValue() {
+        switch (get<uint8_t>()) {
+            case NIL_VALUE: return Value();
+            case NUMBER_VALUE: return Value(get<double>());
+            case STRING_VALUE: return Value::string(string());
+            case BOOLEAN_VALUE: return Value(get<uint8_t>() != 0);
+            case NUMBER_ARRAY: {
+                uint32_t count = get<uint32_t>();
+                if (static_cast<size_t>(end - position) / sizeof(double) < count) corrupt();
+                std::vector<double> numbers(count);
+                std::memcpy(numbers.data(), position, count * sizeof(double));
+                position += count * sizeof(double);
+                Value array;
+                array.type = Value::ARRAY;
+                array.arrayValue = std::make_shared<ArrayStorage>(std::move(numbers));
+                return array;
+            }
+            case ARRAY_VALUE: {
+                uint32_t count = get<uint32_t>();
+                std::vector<Value> elements;
+                elements.reserve(std::min<size_t>(count, static_cast<size_t>(end - position)));
+                for (uint32_t i = 0; i < count; i++) {
+                    elements.push_back(readValue());
+                }
+                return Value(std::move(elements));
+            }
+            case OBJECT_VALUE: {
+                uint32_t count = get<uint32_t>();
+                Value object(std::unordered_map<Symbol, Value>{});
+                object.objectValue->reserve(std::min<size_t>(count, static_cast<size_t>(end - position)));
+                for (uint32_t i = 0; i < count; i++) {
+                    Symbol key = symbol();
+                    object.objectValue->emplace(key, readValue());
+                }
+                return object;
+            }
+            case FUNCTION_VALUE: {
+                uint32_t id = get<uint32_t>();
+                if (id >= image.functions.size()) corrupt();
+                const FunctionDeclaration& decl = *image.functions[id];
+                return Value(decl.parameterSymbols, decl.body);
+            }
+            default: corrupt();
+        }
+    }
+
+    void read() {
+        if (static_cast<size_t>(end - position) < sizeof(MAGIC) ||
+            std::memcmp(position, MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error("Not a snapshot file");
+        }
+        position += sizeof(MAGIC);
+        if (get<uint32_t>() != VERSION) {
+            throw std::runtime_error("Snapshot was written by another version of the interpreter");
+        }
+        uint32_t stringCount = get<uint32_t>();
+        uint32_t functionCount = get<uint32_t>();
+        uint32_t globalCount = get<uint32_t>();
+        readStrings(stringCount);
+        for (uint32_t i = 0; i < functionCount; i++) {
+            image.functions.push_back(function());
+        }
+        for (uint32_t i = 0; i < globalCount; i++) {
+            Symbol name = symbol();
+            image.globals.emplace_back(name, readValue());
+        }
+        if (position != end) corrupt();
+    }
+};
+
+} // namespace
+
+size_t writeSnapshot(const std::string& path, const std::vector<std::pair<Symbol, Value>>& globals,
+                     const std::function<unsigned(const Block*)>& flags) {
+    std::vector<std::pair<std::string, const Value*>> sorted;
+    for (const auto& [name, value] : globals) {
+        if (value.type != Value::NATIVE) {
+            sorted.emplace_back(symbolName(name), &value);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    SnapshotWriter writer(flags);
+    for (const auto& [name, value] : sorted) {
+        put(writer.globals, writer.stringId(name));
+        writer.writeValue(writer.globals, *value, name);
+    }
+    std::string image = writer.image(static_cast<uint32_t>(sorted.size()));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(image.data(), static_cast<std::streamsize>(image.size()))) {
+        throw std::runtime_error("Could not write snapshot: " + path);
+    }
+    return image.size();
+}
+
+SnapshotImage readSnapshot(const std::string& path) {
+    MappedFile file(path);
+    SnapshotReader reader(file.data, file.size);
+    reader.read();
+    reader.image.bytes = file.size;
+    return std::move(reader.image);
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "ast.h"
+#include "environment.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Снимок глобальных переменных после выполнения прелюдии: числа, строки,
+// массивы, объекты и функции вместе с AST их тел. Прелюдия выполняется
+// один раз (--snapshot-out), а при старте образ отображается в память
+// одним mmap и разворачивается за один проход: смещения в образе
+// заменяются указателями на общие строки и тела функций. Так старт не
+// разбирает и не выполняет сотни объявлений и таблиц заново.
+//
+// Образ — плоский двоичный файл: заголовок, таблица строк (имена,
+// строковые значения и литералы без повторов), таблица функций и
+// переменные. Значения ссылаются на строки и функции номерами. Порядок
+// байтов и размеры — как у собравшей образ машины; версия в заголовке
+// отвергает образы другого формата.
+
+// Флаги функции в снимке: как интерпретатор её вызывает
+enum SnapshotFunctionFlags : unsigned {
+    SNAPSHOT_PURE = 1,
+    SNAPSHOT_ASYNC = 2,
+    SNAPSHOT_GENERATOR = 4
+};
+
+struct SnapshotImage {
+    // Объявления функций: интерпретатор регистрирует их тела так же, как
+    // при выполнении fun (мемоизация, JIT, async и генераторы)
+    std::vector<std::unique_ptr<FunctionDeclaration>> functions;
+    std::vector<std::pair<Symbol, Value>> globals;
+    size_t bytes = 0;
+};
+
+// Записать переменные в файл path; flags — флаги тела функции.
+// Обещания, генераторы и воркеры не данные — для них ошибка.
+// Родные функции пропускаются: их регистрирует приложение.
+size_t writeSnapshot(const std::string& path, const std::vector<std::pair<Symbol, Value>>& globals,
+                     const std::function<unsigned(const Block*)>& flags);
+SnapshotImage readSnapshot(const std::string& path);
+
+#endif // SNAPSHOT_H
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "symbol.h"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// deque не перемещает элементы при добавлении — ссылки из symbolName остаются верными
+struct Interner {
+    std::mutex mutex;
+    std::unordered_map<std::string, Symbol> ids;
+    std::deque<std::string> names;
+};
+
+// Создаётся при первом обращении: intern вызывают и статические константы программ --emit-cpp
+Interner& table() {
+    static Interner instance;
+    return instance;
+}
+
+} // namespace
+
+Symbol intern(const std::string& name) {
+    Interner& symbols = table();
+    std::lock_guard<std::mutex> lock(symbols.mutex);
+    auto it = symbols.ids.find(name);
+    if (it != symbols.ids.end()) {
+        return it->second;
+    }
+    Symbol symbol = static_cast<Symbol>(symbols.names.size());
+    symbols.names.push_back(name);
+    symbols.ids.emplace(name, symbol);
+    return symbol;
+}
+
+const std::string& symbolName(Symbol symbol) {
+    Interner& symbols = table();
+    std::lock_guard<std::mutex> lock(symbols.mutex);
+    return symbols.names[symbol];
+}
+
+size_t symbolCount() {
+    Interner& symbols = table();
+    std::lock_guard<std::mutex> lock(symbols.mutex);
+    return symbols.names.size();
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <cstdint>
+#include <string>
+
+// Имена (переменные, параметры, функции, ключи объектов) переводятся в плотные
+// номера один раз — при разборе программы. Окружения и объекты хранят номера:
+// хеш готов, сравнение имён — сравнение чисел. Таблица общая на процесс.
+using Symbol = uint32_t;
+
+Symbol intern(const std::string& name);
+// Ссылка действительна всё время работы процесса
+const std::string& symbolName(Symbol symbol);
+size_t symbolCount();
+
+#endif // SYMBOL_H
\ No newline at end of file
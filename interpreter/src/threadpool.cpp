@@ -0,0 +1,126 @@
+#include "threadpool.h"
+#include <exception>
+#include <iostream>
+
+namespace {
+
+// Пул, которому принадлежит поток, и номер работника в нём
+thread_local const ThreadPool* workerPool = nullptr;
+thread_local int workerIndex = -1;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+int ThreadPool::currentWorker() const {
+    return workerPool == this ? workerIndex : -1;
+}
+
+void ThreadPool::submit(Task task) {
+    int worker = currentWorker();
+    size_t target = worker >= 0
+        ? static_cast<size_t>(worker)
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    // Сначала счётчик: работник не уснёт, пока задача кладётся в очередь
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    wakeUp.notify_one();
+}
+
+bool ThreadPool::runPendingTask() {
+    Task task;
+    int worker = currentWorker();
+    size_t start = worker >= 0 ? static_cast<size_t>(worker) : 0;
+    if (!takeTask(start, task)) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued--;
+    }
+    runTask(task);
+    return true;
+}
+
+bool ThreadPool::takeTask(size_t worker, Task& task) {
+    // Своя очередь — с головы: задачи выполняются в порядке отправки
+    {
+        WorkerQueue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    // Чужие — с хвоста, чтобы меньше мешать их владельцам
+    for (size_t offset = 1; offset < queues.size(); offset++) {
+        WorkerQueue& victim = *queues[(worker + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runTask(Task& task) {
+    try {
+        task();
+    } catch (const std::exception& e) {
+        std::cerr << "Thread pool task failed: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Thread pool task failed" << std::endl;
+    }
+}
+
+void ThreadPool::workerLoop(size_t worker) {
+    workerPool = this;
+    workerIndex = static_cast<int>(worker);
+    while (true) {
+        Task task;
+        if (takeTask(worker, task)) {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                queued--;
+            }
+            runTask(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        // queued > 0 при пустых очередях: задачу вот-вот положат, проверим снова
+        wakeUp.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
\ No newline at end of file
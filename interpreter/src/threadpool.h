@@ -0,0 +1,61 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков фиксированного размера с захватом работы (work stealing).
+// У каждого работника своя очередь: задачи, отправленные из работника,
+// ложатся в его же очередь, остальные раздаются по кругу. Работник берёт
+// задачи с головы своей очереди, а когда она пуста — крадёт с хвоста чужих,
+// поэтому неравные по длительности задачи не простаивают за одной медленной.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(size_t threads);
+    // Дожидается выполнения всех отправленных задач
+    ~ThreadPool();
+
+    void submit(Task task);
+    size_t size() const;
+
+    // Выполнить в текущем потоке одну задачу из очередей; false — они пусты.
+    // Кто ждёт результатов своих задач, помогает их выполнять и не держит
+    // работника, даже если сам выполняется в пуле.
+    bool runPendingTask();
+
+    // Номер работника этого пула, выполняющего текущую задачу; -1 в любом
+    // другом потоке, в том числе в работнике другого пула
+    int currentWorker() const;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextQueue{0};
+
+    // Сон без задач: queued меняется под sleepMutex, чтобы не потерять пробуждение
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    size_t queued = 0;
+    bool stopping = false;
+
+    bool takeTask(size_t worker, Task& task);
+    // Исключение задачи не должно остановить работника: оно печатается в std::cerr
+    void runTask(Task& task);
+    void workerLoop(size_t worker);
+};
+
+#endif // THREADPOOL_H
\ No newline at end of file
@@ -28,6 +28,11 @@ std::string tokenTypeToString(TokenType type) {
         {TokenType::AND, "AND"},
         {TokenType::OR, "OR"},
         {TokenType::NOT, "NOT"},
+        {TokenType::DOT, "DOT"},
+        {TokenType::ASYNC, "ASYNC"},
+        {TokenType::AWAIT, "AWAIT"},
+        {TokenType::IN, "IN"},
+        {TokenType::YIELD, "YIELD"},
         {TokenType::IDENTIFIER, "IDENTIFIER"},
         {TokenType::NUMBER, "NUMBER"},
         {TokenType::STRING, "STRING"},
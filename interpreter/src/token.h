@@ -29,8 +29,11 @@ enum class TokenType {
     COLON,           // :
     
     // Новые ключевые слова
-    IN,              // for..in (для будущего)
+    IN,              // for..in
     NULL_TOKEN,      // null
+    ASYNC,           // async fun
+    AWAIT,           // await
+    YIELD,           // yield в fun*
 
 
 };
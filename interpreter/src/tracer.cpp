@@ -0,0 +1,704 @@
+#include "tracer.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+// Банки регистров
+const int NUM = 0;
+const int BOOL = 1;
+const int STR = 2;
+const int NONE = -1;
+
+int bankOf(TraceType type) {
+    switch (type) {
+        case TraceType::NUMBER: return NUM;
+        case TraceType::BOOLEAN: return BOOL;
+        default: return STR;
+    }
+}
+
+// Банки результата и операндов; effect — инструкцию нельзя удалить
+struct OpInfo {
+    int dst;
+    int a;
+    int b;
+    bool effect;
+};
+
+OpInfo opInfo(TraceOp op) {
+    switch (op) {
+        case TraceOp::NUM_CONST: return {NUM, NONE, NONE, false};
+        case TraceOp::BOOL_CONST: return {BOOL, NONE, NONE, false};
+        case TraceOp::STR_CONST: return {STR, NONE, NONE, false};
+        case TraceOp::NUM_MOV: return {NUM, NUM, NONE, false};
+        case TraceOp::BOOL_MOV: return {BOOL, BOOL, NONE, false};
+        case TraceOp::STR_MOV: return {STR, STR, NONE, false};
+        case TraceOp::ADD:
+        case TraceOp::SUB:
+        case TraceOp::MUL: return {NUM, NUM, NUM, false};
+        case TraceOp::DIV: return {NUM, NUM, NUM, true}; // Деление на ноль — боковой выход
+        case TraceOp::NEG: return {NUM, NUM, NONE, false};
+        case TraceOp::LESS:
+        case TraceOp::GREATER:
+        case TraceOp::LESS_EQUAL:
+        case TraceOp::GREATER_EQUAL:
+        case TraceOp::NUM_EQ:
+        case TraceOp::NUM_NE: return {BOOL, NUM, NUM, false};
+        case TraceOp::BOOL_EQ:
+        case TraceOp::BOOL_NE:
+        case TraceOp::AND:
+        case TraceOp::OR: return {BOOL, BOOL, BOOL, false};
+        case TraceOp::NOT: return {BOOL, BOOL, NONE, false};
+        case TraceOp::STR_EQ:
+        case TraceOp::STR_NE: return {BOOL, STR, STR, false};
+        case TraceOp::NUM_TO_STR: return {STR, NUM, NONE, false};
+        case TraceOp::BOOL_TO_STR: return {STR, BOOL, NONE, false};
+        case TraceOp::CONCAT: return {STR, STR, STR, false};
+        case TraceOp::PRINT_NUM: return {NONE, NUM, NONE, true};
+        case TraceOp::PRINT_BOOL: return {NONE, BOOL, NONE, true};
+        case TraceOp::PRINT_STR: return {NONE, STR, NONE, true};
+        case TraceOp::GUARD_TRUE:
+        case TraceOp::GUARD_FALSE:
+        case TraceOp::EXIT_IF_FALSE: return {NONE, BOOL, NONE, true};
+    }
+    return {NONE, NONE, NONE, true};
+}
+
+bool isMove(TraceOp op) {
+    return op == TraceOp::NUM_MOV || op == TraceOp::BOOL_MOV || op == TraceOp::STR_MOV;
+}
+
+std::string numberToString(double value) {
+    return Value(value).toString();
+}
+
+class TraceAbort : public std::runtime_error {
+public:
+    explicit TraceAbort(const std::string& reason) : std::runtime_error(reason) {}
+};
+
+// Значение во время записи: конкретное значение текущей итерации
+// и регистр, в котором оно будет при выполнении трассы
+struct RecValue {
+    TraceType type = TraceType::NUMBER;
+    double number = 0;
+    bool boolean = false;
+    std::string string;
+    int reg = -1; // -1 — константа, ещё не материализованная в регистр
+
+    static RecValue ofNumber(double value) { RecValue v; v.type = TraceType::NUMBER; v.number = value; return v; }
+    static RecValue ofBoolean(bool value) { RecValue v; v.type = TraceType::BOOLEAN; v.boolean = value; return v; }
+    static RecValue ofString(const std::string& value) { RecValue v; v.type = TraceType::STRING; v.string = value; return v; }
+};
+
+// Записывает одну итерацию цикла, выполняя её «в тени»: окружение не меняется,
+// ветвления выбираются по конкретным значениям и превращаются в защитные проверки
+class TraceRecorder {
+private:
+    Environment& env;
+    Trace& trace;
+    std::unordered_map<Symbol, int> slotIndex;
+    std::vector<RecValue> slotValues;
+
+    int newRegister(TraceType type) {
+        return trace.registers[bankOf(type)]++;
+    }
+
+    void emit(TraceOp op, int dst, int a = -1, int b = -1) {
+        trace.code.push_back({op, dst, a, b, 0, ""});
+    }
+
+    int materialize(RecValue& value) {
+        if (value.reg >= 0) return value.reg;
+        value.reg = newRegister(value.type);
+        switch (value.type) {
+            case TraceType::NUMBER:
+                emit(TraceOp::NUM_CONST, value.reg);
+                trace.code.back().number = value.number;
+                break;
+            case TraceType::BOOLEAN:
+                emit(TraceOp::BOOL_CONST, value.reg);
+                trace.code.back().number = value.boolean ? 1 : 0;
+                break;
+            case TraceType::STRING:
+                emit(TraceOp::STR_CONST, value.reg);
+                trace.code.back().text = value.string;
+                break;
+        }
+        return value.reg;
+    }
+
+    int slotFor(Symbol name) {
+        auto it = slotIndex.find(name);
+        if (it != slotIndex.end()) return it->second;
+
+        Value* value = nullptr;
+        try {
+            value = &env.get(name);
+        } catch (const std::exception&) {
+            throw TraceAbort("undefined variable: " + symbolName(name));
+        }
+
+        RecValue current;
+        switch (value->type) {
+            case Value::NUMBER: current = RecValue::ofNumber(value->numberValue); break;
+            case Value::BOOLEAN: current = RecValue::ofBoolean(value->booleanValue); break;
+            case Value::STRING: current = RecValue::ofString(value->stringValue()); break;
+            default: throw TraceAbort("unsupported type of variable: " + symbolName(name));
+        }
+
+        TraceSlot slot{name, current.type, newRegister(current.type), false, false};
+        current.reg = slot.home;
+        trace.slots.push_back(slot);
+        slotValues.push_back(current);
+        int index = static_cast<int>(trace.slots.size()) - 1;
+        slotIndex[name] = index;
+        return index;
+    }
+
+    void store(Symbol name, RecValue value, bool declared) {
+        int index = slotFor(name);
+        TraceSlot& slot = trace.slots[index];
+        if (value.type != slot.type) {
+            throw TraceAbort("type of variable changes: " + symbolName(name));
+        }
+
+        int reg = materialize(value);
+        TraceOp move = slot.type == TraceType::NUMBER ? TraceOp::NUM_MOV
+                     : slot.type == TraceType::BOOLEAN ? TraceOp::BOOL_MOV : TraceOp::STR_MOV;
+        emit(move, slot.home, reg);
+        slot.written = true;
+        slot.declared = slot.declared || declared;
+
+        value.reg = slot.home;
+        slotValues[index] = value;
+    }
+
+    // Операция над двумя значениями: свёртка констант или инструкция
+    RecValue combine(TraceOp op, RecValue& left, RecValue& right, RecValue result) {
+        if (left.reg < 0 && right.reg < 0) return result;
+        int a = materialize(left);
+        int b = materialize(right);
+        result.reg = newRegister(result.type);
+        emit(op, result.reg, a, b);
+        return result;
+    }
+
+    RecValue unary(TraceOp op, RecValue& operand, RecValue result) {
+        if (operand.reg < 0) return result;
+        result.reg = newRegister(result.type);
+        emit(op, result.reg, operand.reg);
+        return result;
+    }
+
+    RecValue toString(RecValue& value) {
+        switch (value.type) {
+            case TraceType::STRING: return value;
+            case TraceType::NUMBER:
+                return unary(TraceOp::NUM_TO_STR, value, RecValue::ofString(numberToString(value.number)));
+            default:
+                return unary(TraceOp::BOOL_TO_STR, value, RecValue::ofString(value.boolean ? "true" : "false"));
+        }
+    }
+
+    RecValue binary(const std::string& op, RecValue& left, RecValue& right) {
+        bool numbers = left.type == TraceType::NUMBER && right.type == TraceType::NUMBER;
+        bool booleans = left.type == TraceType::BOOLEAN && right.type == TraceType::BOOLEAN;
+        bool strings = left.type == TraceType::STRING && right.type == TraceType::STRING;
+        double l = left.number;
+        double r = right.number;
+
+        if (op == "+") {
+            if (numbers) return combine(TraceOp::ADD, left, right, RecValue::ofNumber(l + r));
+            if (left.type == TraceType::STRING || right.type == TraceType::STRING) {
+                RecValue ls = toString(left);
+                RecValue rs = toString(right);
+                return combine(TraceOp::CONCAT, ls, rs, RecValue::ofString(ls.string + rs.string));
+            }
+        }
+        else if (op == "==" || op == "!=") {
+            bool equals = op == "==";
+            if (numbers) {
+                bool result = numbersEqual(l, r) == equals;
+                return combine(equals ? TraceOp::NUM_EQ : TraceOp::NUM_NE, left, right, RecValue::ofBoolean(result));
+            }
+            if (booleans) {
+                bool result = (left.boolean == right.boolean) == equals;
+                return combine(equals ? TraceOp::BOOL_EQ : TraceOp::BOOL_NE, left, right, RecValue::ofBoolean(result));
+            }
+            // Разные типы сравниваются по строковому представлению
+            RecValue ls = strings ? left : toString(left);
+            RecValue rs = strings ? right : toString(right);
+            bool result = (ls.string == rs.string) == equals;
+            return combine(equals ? TraceOp::STR_EQ : TraceOp::STR_NE, ls, rs, RecValue::ofBoolean(result));
+        }
+        else if (numbers) {
+            if (op == "-") return combine(TraceOp::SUB, left, right, RecValue::ofNumber(l - r));
+            if (op == "*") return combine(TraceOp::MUL, left, right, RecValue::ofNumber(l * r));
+            if (op == "/") {
+                if (r == 0) throw TraceAbort("division by zero");
+                return combine(TraceOp::DIV, left, right, RecValue::ofNumber(l / r));
+            }
+            if (op == "<") return combine(TraceOp::LESS, left, right, RecValue::ofBoolean(l < r));
+            if (op == ">") return combine(TraceOp::GREATER, left, right, RecValue::ofBoolean(l > r));
+            if (op == "<=") return combine(TraceOp::LESS_EQUAL, left, right, RecValue::ofBoolean(l <= r));
+            if (op == ">=") return combine(TraceOp::GREATER_EQUAL, left, right, RecValue::ofBoolean(l >= r));
+        }
+        else if (booleans) {
+            if (op == "and") return combine(TraceOp::AND, left, right, RecValue::ofBoolean(left.boolean && right.boolean));
+            if (op == "or") return combine(TraceOp::OR, left, right, RecValue::ofBoolean(left.boolean || right.boolean));
+        }
+        throw TraceAbort("unsupported operation: " + op);
+    }
+
+    RecValue evaluate(const Expression& expr) {
+        if (auto num = dynamic_cast<const NumberLiteral*>(&expr)) {
+            return RecValue::ofNumber(num->value);
+        }
+        else if (auto str = dynamic_cast<const StringLiteral*>(&expr)) {
+            return RecValue::ofString(*str->value);
+        }
+        else if (auto boolean = dynamic_cast<const BooleanLiteral*>(&expr)) {
+            return RecValue::ofBoolean(boolean->value);
+        }
+        else if (auto id = dynamic_cast<const Identifier*>(&expr)) {
+            return slotValues[slotFor(id->symbol)];
+        }
+        else if (auto binOp = dynamic_cast<const BinaryOperation*>(&expr)) {
+            RecValue left = evaluate(*binOp->left);
+            RecValue right = evaluate(*binOp->right);
+            return binary(binOp->op, left, right);
+        }
+        else if (auto unOp = dynamic_cast<const UnaryOperation*>(&expr)) {
+            RecValue operand = evaluate(*unOp->operand);
+            if (unOp->op == "-" && operand.type == TraceType::NUMBER) {
+                return unary(TraceOp::NEG, operand, RecValue::ofNumber(-operand.number));
+            }
+            if (unOp->op == "not" && operand.type == TraceType::BOOLEAN) {
+                return unary(TraceOp::NOT, operand, RecValue::ofBoolean(!operand.boolean));
+            }
+            throw TraceAbort("unsupported unary operation: " + unOp->op);
+        }
+        throw TraceAbort("unsupported expression");
+    }
+
+    void execute(const Statement& stmt) {
+        if (auto varDecl = dynamic_cast<const VariableDeclaration*>(&stmt)) {
+            if (!varDecl->initializer) throw TraceAbort("declaration without initializer");
+            store(varDecl->variableSymbol, evaluate(*varDecl->initializer), true);
+        }
+        else if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
+            if (assignment->target) throw TraceAbort("element assignment");
+            store(assignment->variableSymbol, evaluate(*assignment->value), false);
+        }
+        else if (auto ifStmt = dynamic_cast<const IfStatement*>(&stmt)) {
+            RecValue condition = evaluate(*ifStmt->condition);
+            // Небулево условие ложно (как booleanValue у интерпретатора); тип известен статически
+            bool taken = condition.type == TraceType::BOOLEAN && condition.boolean;
+            if (condition.type == TraceType::BOOLEAN && condition.reg >= 0) {
+                emit(taken ? TraceOp::GUARD_TRUE : TraceOp::GUARD_FALSE, -1, condition.reg);
+            }
+            if (taken) {
+                execute(*ifStmt->thenBlock);
+            } else if (ifStmt->elseBlock) {
+                execute(*ifStmt->elseBlock);
+            }
+        }
+        else if (auto block = dynamic_cast<const Block*>(&stmt)) {
+            for (const auto& s : block->statements) {
+                execute(*s);
+            }
+        }
+        else if (auto printStmt = dynamic_cast<const PrintStatement*>(&stmt)) {
+            RecValue value = evaluate(*printStmt->expression);
+            int reg = materialize(value);
+            TraceOp op = value.type == TraceType::NUMBER ? TraceOp::PRINT_NUM
+                       : value.type == TraceType::BOOLEAN ? TraceOp::PRINT_BOOL : TraceOp::PRINT_STR;
+            emit(op, -1, reg);
+        }
+        else if (auto exprStmt = dynamic_cast<const ExpressionStatement*>(&stmt)) {
+            evaluate(*exprStmt->expression);
+        }
+        else {
+            throw TraceAbort("unsupported statement");
+        }
+    }
+
+public:
+    TraceRecorder(Environment& env, Trace& trace) : env(env), trace(trace) {}
+
+    // false — условие цикла уже ложно, записывать нечего
+    bool recordIteration(const Expression* condition, const Block& body, const Expression* increment) {
+        if (condition) {
+            RecValue value = evaluate(*condition);
+            if (value.type != TraceType::BOOLEAN || !value.boolean) return false;
+            if (value.reg >= 0) emit(TraceOp::EXIT_IF_FALSE, -1, value.reg);
+        }
+        execute(body);
+        if (increment) evaluate(*increment);
+        trace.recordedLength = trace.code.size();
+        return true;
+    }
+};
+
+// Оптимизация трассы: слияние временных регистров с «домашними»,
+// удаление мёртвых записей переменных и мёртвого кода
+void optimize(Trace& trace) {
+    std::vector<std::vector<bool>> home(3);
+    for (int bank = 0; bank < 3; bank++) home[bank].assign(trace.registers[bank], false);
+    for (const auto& slot : trace.slots) home[bankOf(slot.type)][slot.home] = true;
+
+    auto& code = trace.code;
+    auto countUses = [&]() {
+        std::vector<std::vector<int>> uses(3);
+        for (int bank = 0; bank < 3; bank++) uses[bank].assign(trace.registers[bank], 0);
+        for (const auto& in : code) {
+            OpInfo info = opInfo(in.op);
+            if (info.a != NONE) uses[info.a][in.a]++;
+            if (info.b != NONE) uses[info.b][in.b]++;
+        }
+        return uses;
+    };
+
+    // 1. «t = op ...; home = t» -> «home = op ...», если t больше нигде не читается
+    auto uses = countUses();
+    std::vector<bool> removed(code.size(), false);
+    for (size_t i = 0; i + 1 < code.size(); i++) {
+        TraceInstr& def = code[i];
+        TraceInstr& move = code[i + 1];
+        OpInfo info = opInfo(def.op);
+        if (!isMove(move.op) || info.dst == NONE || info.dst != opInfo(move.op).dst) continue;
+        if (move.a != def.dst || home[info.dst][def.dst] || uses[info.dst][def.dst] != 1) continue;
+        def.dst = move.dst;
+        removed[i + 1] = true;
+        i++;
+    }
+
+    std::vector<TraceInstr> compacted;
+    for (size_t i = 0; i < code.size(); i++) {
+        if (!removed[i]) compacted.push_back(std::move(code[i]));
+    }
+    code = std::move(compacted);
+
+    // 2. Запись переменной, перезаписанная до чтения, мертва. Боковые выходы
+    //    ей не мешают: при выходе переменные всё равно откатываются.
+    removed.assign(code.size(), false);
+    for (size_t i = 0; i < code.size(); i++) {
+        OpInfo info = opInfo(code[i].op);
+        if (info.effect || info.dst == NONE || !home[info.dst][code[i].dst]) continue;
+        int bank = info.dst;
+        int reg = code[i].dst;
+        for (size_t j = i + 1; j < code.size(); j++) {
+            if (removed[j]) continue;
+            OpInfo next = opInfo(code[j].op);
+            if ((next.a == bank && code[j].a == reg) || (next.b == bank && code[j].b == reg)) break;
+            if (next.dst == bank && code[j].dst == reg) {
+                removed[i] = true;
+                break;
+            }
+        }
+    }
+
+    compacted.clear();
+    for (size_t i = 0; i < code.size(); i++) {
+        if (!removed[i]) compacted.push_back(std::move(code[i]));
+    }
+    code = std::move(compacted);
+
+    // 3. Удаление вычислений, результат которых не используется
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        uses = countUses();
+        compacted.clear();
+        for (auto& in : code) {
+            OpInfo info = opInfo(in.op);
+            if (!info.effect && info.dst != NONE && !home[info.dst][in.dst] && uses[info.dst][in.dst] == 0) {
+                changed = true;
+                continue;
+            }
+            compacted.push_back(std::move(in));
+        }
+        code = std::move(compacted);
+    }
+}
+
+} // namespace
+
+// Боковые выходы чаще этой доли итераций — трасса не окупается
+const size_t MIN_SIDE_EXITS_TO_BLACKLIST = 32;
+const size_t MAX_ENTRY_FAILURES = 32;
+// Столько входов подряд без единой итерации — путь сменился, трасса перезаписывается
+const size_t MAX_FAILED_ENTRIES = 8;
+const size_t MAX_RETRACES = 4;
+
+Tracer::Tracer(size_t hotThreshold) : hotThreshold(hotThreshold), outputStream(&std::cout) {}
+
+void Tracer::setOutput(std::ostream& out) {
+    outputStream = &out;
+}
+
+void Tracer::setBackEdgeHook(std::function<void()> hook) {
+    backEdge = std::move(hook);
+}
+
+LoopProfile& Tracer::profileFor(const Statement&, std::atomic<int>& traceId, const char* kind) {
+    // Номер в узле один на процесс: программу могут выполнять несколько
+    // изолятов, и у каждого трассировщика свои профили
+    int id = traceId.load(std::memory_order_relaxed);
+    if (id < 0) {
+        static std::atomic<int> nextTraceId{0};
+        int fresh = nextTraceId.fetch_add(1, std::memory_order_relaxed);
+        if (traceId.compare_exchange_strong(id, fresh, std::memory_order_relaxed)) {
+            id = fresh;
+        }
+    }
+    auto it = profileSlots.find(id);
+    if (it != profileSlots.end()) {
+        return profiles[it->second];
+    }
+    profileSlots.emplace(id, profiles.size());
+    profiles.emplace_back();
+    profiles.back().kind = kind;
+    return profiles.back();
+}
+
+void Tracer::onIteration(const WhileStatement& loop, Environment& env) {
+    LoopProfile& profile = profileFor(loop, loop.traceId, "while");
+    profile.iterations++;
+    if (profile.state == LoopProfile::COUNTING && profile.iterations >= std::max(hotThreshold, profile.recordAt)) {
+        record(profile, loop.condition.get(), *loop.body, nullptr, env);
+    }
+    if (profile.state == LoopProfile::TRACED) {
+        run(profile, env);
+    }
+}
+
+void Tracer::onIteration(const ForStatement& loop, Environment& env) {
+    LoopProfile& profile = profileFor(loop, loop.traceId, "for");
+    profile.iterations++;
+    if (profile.state == LoopProfile::COUNTING && profile.iterations >= std::max(hotThreshold, profile.recordAt)) {
+        record(profile, loop.condition.get(), *loop.body, loop.increment.get(), env);
+    }
+    if (profile.state == LoopProfile::TRACED) {
+        run(profile, env);
+    }
+}
+
+void Tracer::record(LoopProfile& profile, const Expression* condition, const Block& body,
+                    const Expression* increment, Environment& env) {
+    Trace trace;
+    try {
+        TraceRecorder recorder(env, trace);
+        if (!recorder.recordIteration(condition, body, increment)) {
+            return; // Цикл завершается — попробуем при следующем входе
+        }
+    } catch (const std::exception& e) {
+        profile.state = LoopProfile::BLACKLISTED;
+        profile.abortReason = e.what();
+        return;
+    }
+
+    optimize(trace);
+    profile.trace = std::move(trace);
+    profile.state = LoopProfile::TRACED;
+}
+
+void Tracer::run(LoopProfile& profile, Environment& env) {
+    const Trace& trace = profile.trace;
+
+    // Вход: разрешаем переменные и проверяем их типы (единственные защиты типов)
+    std::vector<Value*> targets(trace.slots.size());
+    for (size_t i = 0; i < trace.slots.size(); i++) {
+        const TraceSlot& slot = trace.slots[i];
+        Value* target = nullptr;
+        if (slot.declared) {
+            auto it = env.variables.find(slot.name);
+            if (it != env.variables.end()) target = &it->second;
+        } else if (env.exists(slot.name)) {
+            target = &env.get(slot.name);
+        }
+
+        bool typeMatches = target &&
+            ((slot.type == TraceType::NUMBER && target->type == Value::NUMBER) ||
+             (slot.type == TraceType::BOOLEAN && target->type == Value::BOOLEAN) ||
+             (slot.type == TraceType::STRING && target->type == Value::STRING));
+        if (!typeMatches) {
+            if (++profile.entryFailures > MAX_ENTRY_FAILURES) {
+                profile.state = LoopProfile::BLACKLISTED;
+                profile.abortReason = "variable types are unstable";
+            }
+            return;
+        }
+        targets[i] = target;
+    }
+
+    std::vector<double> numbers(trace.registers[NUM]);
+    std::vector<char> booleans(trace.registers[BOOL]);
+    std::vector<std::string> strings(trace.registers[STR]);
+    for (size_t i = 0; i < trace.slots.size(); i++) {
+        const TraceSlot& slot = trace.slots[i];
+        switch (slot.type) {
+            case TraceType::NUMBER: numbers[slot.home] = targets[i]->numberValue; break;
+            case TraceType::BOOLEAN: booleans[slot.home] = targets[i]->booleanValue; break;
+            case TraceType::STRING: strings[slot.home] = targets[i]->stringValue(); break;
+        }
+    }
+
+    // Снимок изменяемых переменных на начало итерации — для отката
+    std::vector<double> savedNumbers(trace.slots.size());
+    std::vector<char> savedBooleans(trace.slots.size());
+    std::vector<std::string> savedStrings(trace.slots.size());
+    auto save = [&]() {
+        for (size_t i = 0; i < trace.slots.size(); i++) {
+            const TraceSlot& slot = trace.slots[i];
+            if (!slot.written) continue;
+            switch (slot.type) {
+                case TraceType::NUMBER: savedNumbers[i] = numbers[slot.home]; break;
+                case TraceType::BOOLEAN: savedBooleans[i] = booleans[slot.home]; break;
+                case TraceType::STRING: savedStrings[i] = strings[slot.home]; break;
+            }
+        }
+    };
+    auto restore = [&]() {
+        for (size_t i = 0; i < trace.slots.size(); i++) {
+            const TraceSlot& slot = trace.slots[i];
+            if (!slot.written) continue;
+            switch (slot.type) {
+                case TraceType::NUMBER: numbers[slot.home] = savedNumbers[i]; break;
+                case TraceType::BOOLEAN: booleans[slot.home] = savedBooleans[i]; break;
+                case TraceType::STRING: strings[slot.home] = savedStrings[i]; break;
+            }
+        }
+    };
+    auto writeBack = [&]() {
+        for (size_t i = 0; i < trace.slots.size(); i++) {
+            const TraceSlot& slot = trace.slots[i];
+            if (!slot.written) continue;
+            switch (slot.type) {
+                case TraceType::NUMBER: *targets[i] = Value(numbers[slot.home]); break;
+                case TraceType::BOOLEAN: *targets[i] = Value(booleans[slot.home] != 0); break;
+                case TraceType::STRING: *targets[i] = Value(strings[slot.home]); break;
+            }
+        }
+    };
+
+    profile.traceEntries++;
+    size_t iterationsBefore = profile.traceIterations;
+    save();
+
+    const std::vector<TraceInstr>& code = trace.code;
+    std::string output; // Вывод итерации публикуется только после её завершения
+    size_t pc = 0;
+    while (true) {
+        if (pc == code.size()) {
+            if (!output.empty()) {
+                *outputStream << output << std::flush;
+                output.clear();
+            }
+            profile.traceIterations++;
+            profile.failedEntries = 0;
+            save();
+            if (backEdge) {
+                backEdge();
+            }
+            pc = 0;
+            continue;
+        }
+
+        const TraceInstr& in = code[pc++];
+        switch (in.op) {
+            case TraceOp::NUM_CONST: numbers[in.dst] = in.number; break;
+            case TraceOp::BOOL_CONST: booleans[in.dst] = in.number != 0; break;
+            case TraceOp::STR_CONST: strings[in.dst] = in.text; break;
+            case TraceOp::NUM_MOV: numbers[in.dst] = numbers[in.a]; break;
+            case TraceOp::BOOL_MOV: booleans[in.dst] = booleans[in.a]; break;
+            case TraceOp::STR_MOV: strings[in.dst] = strings[in.a]; break;
+            case TraceOp::ADD: numbers[in.dst] = numbers[in.a] + numbers[in.b]; break;
+            case TraceOp::SUB: numbers[in.dst] = numbers[in.a] - numbers[in.b]; break;
+            case TraceOp::MUL: numbers[in.dst] = numbers[in.a] * numbers[in.b]; break;
+            case TraceOp::DIV:
+                if (numbers[in.b] == 0) goto sideExit;
+                numbers[in.dst] = numbers[in.a] / numbers[in.b];
+                break;
+            case TraceOp::NEG: numbers[in.dst] = -numbers[in.a]; break;
+            case TraceOp::LESS: booleans[in.dst] = numbers[in.a] < numbers[in.b]; break;
+            case TraceOp::GREATER: booleans[in.dst] = numbers[in.a] > numbers[in.b]; break;
+            case TraceOp::LESS_EQUAL: booleans[in.dst] = numbers[in.a] <= numbers[in.b]; break;
+            case TraceOp::GREATER_EQUAL: booleans[in.dst] = numbers[in.a] >= numbers[in.b]; break;
+            case TraceOp::NUM_EQ: booleans[in.dst] = numbersEqual(numbers[in.a], numbers[in.b]); break;
+            case TraceOp::NUM_NE: booleans[in.dst] = !numbersEqual(numbers[in.a], numbers[in.b]); break;
+            case TraceOp::BOOL_EQ: booleans[in.dst] = booleans[in.a] == booleans[in.b]; break;
+            case TraceOp::BOOL_NE: booleans[in.dst] = booleans[in.a] != booleans[in.b]; break;
+            case TraceOp::STR_EQ: booleans[in.dst] = strings[in.a] == strings[in.b]; break;
+            case TraceOp::STR_NE: booleans[in.dst] = strings[in.a] != strings[in.b]; break;
+            case TraceOp::AND: booleans[in.dst] = booleans[in.a] && booleans[in.b]; break;
+            case TraceOp::OR: booleans[in.dst] = booleans[in.a] || booleans[in.b]; break;
+            case TraceOp::NOT: booleans[in.dst] = !booleans[in.a]; break;
+            case TraceOp::NUM_TO_STR: strings[in.dst] = numberToString(numbers[in.a]); break;
+            case TraceOp::BOOL_TO_STR: strings[in.dst] = booleans[in.a] ? "true" : "false"; break;
+            case TraceOp::CONCAT: strings[in.dst] = strings[in.a] + strings[in.b]; break;
+            case TraceOp::PRINT_NUM: output += numberToString(numbers[in.a]) + "\n"; break;
+            case TraceOp::PRINT_BOOL: output += booleans[in.a] ? "true\n" : "false\n"; break;
+            case TraceOp::PRINT_STR: output += strings[in.a] + "\n"; break;
+            case TraceOp::GUARD_TRUE:
+                if (!booleans[in.a]) goto sideExit;
+                break;
+            case TraceOp::GUARD_FALSE:
+                if (booleans[in.a]) goto sideExit;
+                break;
+            case TraceOp::EXIT_IF_FALSE:
+                if (!booleans[in.a]) {
+                    writeBack();
+                    profile.normalExits++;
+                    return;
+                }
+                break;
+        }
+    }
+
+sideExit:
+    // Откат незавершённой итерации; её заново выполнит интерпретатор
+    restore();
+    writeBack();
+    profile.sideExits++;
+    if (profile.traceIterations == iterationsBefore && ++profile.failedEntries >= MAX_FAILED_ENTRIES) {
+        if (profile.retraces++ < MAX_RETRACES) {
+            profile.state = LoopProfile::COUNTING;
+            profile.recordAt = profile.iterations + hotThreshold;
+            profile.failedEntries = 0;
+            return;
+        }
+        profile.state = LoopProfile::BLACKLISTED;
+        profile.abortReason = "trace keeps failing";
+    }
+    if (profile.sideExits >= MIN_SIDE_EXITS_TO_BLACKLIST && profile.sideExits * 2 > profile.traceIterations) {
+        profile.state = LoopProfile::BLACKLISTED;
+        profile.abortReason = "too many side exits";
+    }
+}
+
+void Tracer::printStats(std::ostream& os) const {
+    os << "Loop traces:" << std::endl;
+    for (size_t i = 0; i < profiles.size(); i++) {
+        const LoopProfile& profile = profiles[i];
+        os << "  #" << i << " " << profile.kind << ": iterations=" << profile.iterations;
+        if (profile.trace.recordedLength > 0) {
+            os << " trace ops=" << profile.trace.recordedLength << "->" << profile.trace.code.size()
+               << " entries=" << profile.traceEntries
+               << " trace iterations=" << profile.traceIterations
+               << " exits=" << profile.normalExits
+               << " side exits=" << profile.sideExits
+               << " retraces=" << profile.retraces;
+        }
+        if (profile.state == LoopProfile::BLACKLISTED) {
+            os << " blacklisted: " << profile.abortReason;
+        } else if (profile.state == LoopProfile::COUNTING) {
+            os << " cold";
+        }
+        os << std::endl;
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include "ast.h"
+#include "environment.h"
+#include <atomic>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Типы значений внутри трассы (проверяются один раз при входе)
+enum class TraceType { NUMBER, BOOLEAN, STRING };
+
+enum class TraceOp {
+    NUM_CONST, BOOL_CONST, STR_CONST,
+    NUM_MOV, BOOL_MOV, STR_MOV,
+    ADD, SUB, MUL, DIV, NEG,
+    LESS, GREATER, LESS_EQUAL, GREATER_EQUAL,
+    NUM_EQ, NUM_NE, BOOL_EQ, BOOL_NE, STR_EQ, STR_NE,
+    AND, OR, NOT,
+    NUM_TO_STR, BOOL_TO_STR, CONCAT,
+    PRINT_NUM, PRINT_BOOL, PRINT_STR,
+    GUARD_TRUE, GUARD_FALSE, // Боковой выход при нарушении
+    EXIT_IF_FALSE            // Условие цикла: обычный выход
+};
+
+// Операнды — номера регистров в банке соответствующего типа
+struct TraceInstr {
+    TraceOp op;
+    int dst;
+    int a;
+    int b;
+    double number;
+    std::string text;
+};
+
+// Переменная окружения, с которой работает трасса
+struct TraceSlot {
+    Symbol name;
+    TraceType type;
+    int home;      // Регистр, где живёт значение между итерациями
+    bool written;
+    bool declared; // Объявлена через let в теле — должна быть локальной
+};
+
+struct Trace {
+    std::vector<TraceSlot> slots;
+    std::vector<TraceInstr> code;
+    int registers[3] = {0, 0, 0}; // По банкам: числа, bool, строки
+    size_t recordedLength = 0;
+};
+
+struct LoopProfile {
+    enum State { COUNTING, TRACED, BLACKLISTED };
+
+    std::string kind;
+    State state = COUNTING;
+    size_t iterations = 0;       // Итерации, начатые интерпретатором
+    size_t traceEntries = 0;
+    size_t traceIterations = 0;
+    size_t normalExits = 0;
+    size_t sideExits = 0;
+    size_t entryFailures = 0;
+    size_t failedEntries = 0;    // Подряд идущие входы, вышедшие до конца первой итерации
+    size_t retraces = 0;
+    size_t recordAt = 0;         // Итерация, на которой записывать трассу
+    std::string abortReason;
+    Trace trace;
+};
+
+// Трассирующий JIT для горячих циклов while/for.
+// Когда счётчик итераций цикла достигает порога, одна итерация записывается
+// в типизированное линейное IR (ветвления превращаются в защитные проверки),
+// IR оптимизируется и дальше итерации выполняет исполнитель трасс.
+// Боковой выход откатывает незавершённую итерацию: переменные восстанавливаются
+// на начало итерации, буферизованный вывод отбрасывается, и итерацию
+// повторяет интерпретатор. Если трасса раз за разом выходит, не завершив
+// ни одной итерации, путь через цикл сменился и трасса записывается заново.
+class Tracer {
+private:
+    size_t hotThreshold;
+    std::vector<LoopProfile> profiles;
+    // Номер цикла (общий для процесса) -> его профиль в profiles
+    std::unordered_map<int, size_t> profileSlots;
+    std::ostream* outputStream;
+    std::function<void()> backEdge;
+
+    LoopProfile& profileFor(const Statement& loop, std::atomic<int>& traceId, const char* kind);
+    void record(LoopProfile& profile, const Expression* condition, const Block& body,
+                const Expression* increment, Environment& env);
+    void run(LoopProfile& profile, Environment& env);
+
+public:
+    explicit Tracer(size_t hotThreshold);
+    // Куда печатает print в трассе (по умолчанию std::cout)
+    void setOutput(std::ostream& out);
+    // Вызывается после каждой итерации, выполненной трассой (вытеснение,
+    // Interpreter::setPreemption). Может приостановить поток выполнения.
+    void setBackEdgeHook(std::function<void()> hook);
+
+    // Вызывается в начале каждой итерации. Может выполнить несколько итераций
+    // трассой; после возврата интерпретатор продолжает с проверки условия.
+    void onIteration(const WhileStatement& loop, Environment& env);
+    void onIteration(const ForStatement& loop, Environment& env);
+
+    void printStats(std::ostream& os) const;
+};
+
+#endif // TRACER_H
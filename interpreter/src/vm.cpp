@@ -0,0 +1,560 @@
+#include "vm.h"
+#include "compiler.h"
+#include "runtime.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+const char* opName(Op op) {
+    static const char* const names[] = {
+#define VM_OPCODE_NAME(name) #name,
+        VM_OPCODES(VM_OPCODE_NAME)
+#undef VM_OPCODE_NAME
+    };
+    return op < Op::COUNT ? names[static_cast<int>(op)] : "?";
+}
+
+Vm::Vm() : globals(std::make_shared<Environment>()), maxCallDepth(DEFAULT_MAX_CALL_DEPTH) {
+    registers.resize(1024);
+    declared.resize(registers.size());
+}
+
+void Vm::setMaxCallDepth(size_t depth) {
+    maxCallDepth = depth;
+}
+
+void Vm::registerNative(const std::string& name, size_t arity, NativeCallback function) {
+    globals->define(intern(name), Value::native(std::make_shared<NativeFunction>(
+        NativeFunction{name, arity, std::move(function)})));
+}
+
+void Vm::enableProfiling() {
+    profiling = true;
+    pairCounts.assign(static_cast<size_t>(Op::COUNT) * static_cast<size_t>(Op::COUNT), 0);
+}
+
+void Vm::interpret(const Program& program) {
+    BytecodeCompiler compiler(functions);
+    size_t firstNew = functions.size();
+    FunctionProto& script = *functions[compiler.compile(program)];
+    for (size_t i = firstNew; i < functions.size(); i++) {
+        if (functions[i]->marker) {
+            functionsByMarker[functions[i]->marker.get()] = functions[i].get();
+        }
+    }
+    shadowCount.resize(symbolCount(), 0);
+    globalSlots.resize(symbolCount(), nullptr);
+
+    try {
+        run(script);
+    } catch (const std::exception& e) {
+        std::cout << std::flush;
+        std::cerr << "Runtime error: " << e.what() << std::endl;
+    } catch (const ReturnOutsideFunction&) {
+        // Вывод буферизован, а процесс сейчас завершится
+        std::cout << std::flush;
+        throw;
+    }
+    std::cout << std::flush;
+    reset();
+}
+
+// После ошибки окна брошены на середине: следующая программа (REPL) начинает с пустого стека
+void Vm::reset() {
+    frames.clear();
+    std::fill(shadowCount.begin(), shadowCount.end(), 0);
+    std::fill(declared.begin(), declared.end(), 0);
+}
+
+// Динамическая область видимости: своя объявленная локальная, затем локальные
+// вызывающих от ближайшего, затем globals. nullptr — имя не определено.
+Value* Vm::findName(const NameRef& ref) {
+    const CallFrame& top = frames.back();
+    if (ref.slot >= 0 && declared[top.base + ref.slot]) {
+        return &registers[top.base + ref.slot];
+    }
+
+    if (shadowCount[ref.symbol] > 0) {
+        for (size_t i = frames.size() - 1; i-- > 0;) {
+            const CallFrame& frame = frames[i];
+            const std::vector<Symbol>& locals = frame.function->localSymbols;
+            for (size_t slot = locals.size(); slot-- > 0;) {
+                if (locals[slot] == ref.symbol && declared[frame.base + slot]) {
+                    return &registers[frame.base + slot];
+                }
+            }
+        }
+    }
+
+    Value*& global = globalSlots[ref.symbol];
+    if (!global) {
+        auto it = globals->variables.find(ref.symbol);
+        if (it == globals->variables.end()) return nullptr;
+        global = &it->second;
+    }
+    return global;
+}
+
+void Vm::releaseLocals(const CallFrame& frame) {
+    const std::vector<Symbol>& locals = frame.function->localSymbols;
+    for (size_t slot = 0; slot < locals.size(); slot++) {
+        if (declared[frame.base + slot]) {
+            shadowCount[locals[slot]]--;
+        }
+    }
+}
+
+// Массив регистров растёт только на входе в функцию; окна адресуются смещениями
+void Vm::reserve(size_t top) {
+    if (top > registers.size()) {
+        registers.resize(std::max(registers.size() * 2, top));
+        declared.resize(registers.size());
+    }
+}
+
+void Vm::run(FunctionProto& script) {
+    reserve(script.chunk.registers);
+    frames.push_back({&script, nullptr, 0, false});
+    execute();
+}
+
+Value Vm::call(const Value& function, const Value* args, size_t count) {
+    if (function.type == Value::NATIVE) {
+        return callNative(function, args, count, *this);
+    }
+    auto found = functionsByMarker.find(function.body.get());
+    if (found == functionsByMarker.end()) {
+        throw std::runtime_error("Function is not compiled");
+    }
+    if (frames.size() > maxCallDepth) {
+        throw std::runtime_error("Stack overflow");
+    }
+    FunctionProto* proto = found->second;
+
+    // Результат — в регистре под окном, как у CALL; окно лежит выше всех
+    // регистров текущего кадра. args — копии вызывающего, не регистры VM.
+    const CallFrame& current = frames.back();
+    size_t base = current.base + current.function->chunk.registers + 1;
+    reserve(base + proto->chunk.registers);
+    for (size_t i = 0; i < count; i++) {
+        registers[base + i] = args[i];
+    }
+
+    const std::vector<Symbol>& locals = proto->localSymbols;
+    size_t parameterCount = proto->parameters.size();
+    for (size_t slot = 0; slot < locals.size(); slot++) {
+        declared[base + slot] = slot < parameterCount;
+        if (slot < parameterCount) shadowCount[locals[slot]]++;
+    }
+
+    frames.push_back({proto, nullptr, base, true});
+    execute();
+    return std::move(registers[base - 1]);
+}
+
+// Локальные VM лежат в общем массиве регистров, поэтому fork не поддержан:
+// parallelMap выполняет колбэки по очереди в этом потоке
+bool Vm::isPure(const Value& function) const {
+    auto found = functionsByMarker.find(function.body.get());
+    return found != functionsByMarker.end() && found->second->pure;
+}
+
+// Computed goto и взятие адреса метки — расширения GNU
+#if VM_THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#define VM_CASE(name) op_##name:
+#define VM_DISPATCH() goto *ip->target
+#else
+#define VM_CASE(name) case Op::name:
+#define VM_DISPATCH() goto dispatch
+#endif
+#define VM_NEXT() do { ++ip; VM_DISPATCH(); } while (0)
+#define RK(x) ((x) >= 0 ? R[x] : K[-1 - (x)])
+
+void Vm::execute() {
+#if VM_THREADED
+    static const void* const labels[] = {
+#define VM_OPCODE_LABEL(name) &&op_##name,
+        VM_OPCODES(VM_OPCODE_LABEL)
+#undef VM_OPCODE_LABEL
+    };
+    // При профилировании каждая команда сначала проходит через счётчик пар
+    const void* const profileLabel = &&profile;
+#endif
+
+    // Шитый код: адрес обработчика записывается в команду при первом входе в функцию
+    auto prepare = [&](Chunk& chunk) {
+        if (chunk.threaded) return;
+#if VM_THREADED
+        for (auto& instr : chunk.code) {
+            instr.target = profiling ? profileLabel : labels[static_cast<int>(instr.op)];
+        }
+#endif
+        chunk.threaded = true;
+    };
+
+    Chunk* chunk = &frames.back().function->chunk;
+    prepare(*chunk);
+    const Instruction* ip = chunk->code.data();
+    Value* R = registers.data() + frames.back().base;
+    const Value* K = chunk->constants.data();
+    const Instruction* previous = nullptr;
+
+#if VM_THREADED
+    VM_DISPATCH();
+
+profile:
+    // Считаются только пары соседних команд: их и можно склеить
+    if (previous && ip == previous + 1) {
+        pairCounts[static_cast<size_t>(previous->op) * static_cast<size_t>(Op::COUNT) +
+                   static_cast<size_t>(ip->op)]++;
+    }
+    previous = ip;
+    executed++;
+    goto *labels[static_cast<int>(ip->op)];
+#else
+dispatch:
+    if (profiling) {
+        if (previous && ip == previous + 1) {
+            pairCounts[static_cast<size_t>(previous->op) * static_cast<size_t>(Op::COUNT) +
+                       static_cast<size_t>(ip->op)]++;
+        }
+        previous = ip;
+        executed++;
+    }
+    switch (ip->op) {
+#endif
+
+    VM_CASE(MOVE)
+        R[ip->a] = R[ip->b];
+        VM_NEXT();
+
+    VM_CASE(LOAD_CONST)
+        R[ip->a] = K[ip->b];
+        VM_NEXT();
+
+    VM_CASE(LOAD_NIL)
+        R[ip->a] = Value();
+        VM_NEXT();
+
+    VM_CASE(GET_NAME) {
+        const NameRef& ref = chunk->names[ip->b];
+        Value* variable = findName(ref);
+        if (!variable) {
+            throw std::runtime_error("Undefined variable: " + ref.name);
+        }
+        R[ip->a] = *variable;
+        VM_NEXT();
+    }
+
+    VM_CASE(SET_NAME) {
+        const NameRef& ref = chunk->names[ip->a];
+        Value* variable = findName(ref);
+        if (!variable) {
+            throw std::runtime_error("Undefined variable: " + ref.name);
+        }
+        *variable = RK(ip->b);
+        VM_NEXT();
+    }
+
+    VM_CASE(DECLARE_LOCAL) {
+        unsigned char& flag = declared[frames.back().base + ip->a];
+        if (!flag) {
+            flag = 1;
+            shadowCount[frames.back().function->localSymbols[ip->a]]++;
+        }
+        VM_NEXT();
+    }
+
+    VM_CASE(DEFINE_NAME) {
+        const NameRef& ref = chunk->names[ip->a];
+        Value& variable = globals->variables[ref.symbol];
+        variable = RK(ip->b);
+        globalSlots[ref.symbol] = &variable;
+        VM_NEXT();
+    }
+
+    VM_CASE(ADD) {
+        const Value& left = RK(ip->b);
+        const Value& right = RK(ip->c);
+        if (left.type == Value::NUMBER && right.type == Value::NUMBER) {
+            R[ip->a] = Value(left.numberValue + right.numberValue);
+        } else {
+            R[ip->a] = addValues(left, right);
+        }
+        VM_NEXT();
+    }
+
+    VM_CASE(SUB)
+        R[ip->a] = subtractValues(RK(ip->b), RK(ip->c));
+        VM_NEXT();
+
+    VM_CASE(MUL)
+        R[ip->a] = multiplyValues(RK(ip->b), RK(ip->c));
+        VM_NEXT();
+
+    VM_CASE(DIV)
+        R[ip->a] = divideValues(RK(ip->b), RK(ip->c));
+        VM_NEXT();
+
+    VM_CASE(EQ)
+        R[ip->a] = equalValues(RK(ip->b), RK(ip->c));
+        VM_NEXT();
+
+    VM_CASE(NE)
+        R[ip->a] = notEqualValues(RK(ip->b), RK(ip->c));
+        VM_NEXT();
+
+    VM_CASE(LT)
+        R[ip->a] = Value(RK(ip->b).numberValue < RK(ip->c).numberValue);
+        VM_NEXT();
+
+    VM_CASE(GT)
+        R[ip->a] = Value(RK(ip->b).numberValue > RK(ip->c).numberValue);
+        VM_NEXT();
+
+    VM_CASE(LE)
+        R[ip->a] = Value(RK(ip->b).numberValue <= RK(ip->c).numberValue);
+        VM_NEXT();
+
+    VM_CASE(GE)
+        R[ip->a] = Value(RK(ip->b).numberValue >= RK(ip->c).numberValue);
+        VM_NEXT();
+
+    VM_CASE(AND)
+        R[ip->a] = Value(RK(ip->b).booleanValue && RK(ip->c).booleanValue);
+        VM_NEXT();
+
+    VM_CASE(OR)
+        R[ip->a] = Value(RK(ip->b).booleanValue || RK(ip->c).booleanValue);
+        VM_NEXT();
+
+    VM_CASE(NEG)
+        R[ip->a] = negateValue(RK(ip->b));
+        VM_NEXT();
+
+    VM_CASE(NOT)
+        R[ip->a] = Value(!RK(ip->b).booleanValue);
+        VM_NEXT();
+
+    VM_CASE(JUMP)
+        ip = chunk->code.data() + ip->a;
+        VM_DISPATCH();
+
+    VM_CASE(JUMP_IF_FALSE)
+        if (!RK(ip->b).booleanValue) {
+            ip = chunk->code.data() + ip->a;
+            VM_DISPATCH();
+        }
+        VM_NEXT();
+
+    VM_CASE(JUMP_IF_NOT_LT)
+        if (!(RK(ip->b).numberValue < RK(ip->c).numberValue)) {
+            ip = chunk->code.data() + ip->a;
+            VM_DISPATCH();
+        }
+        VM_NEXT();
+
+    VM_CASE(JUMP_IF_NOT_LE)
+        if (!(RK(ip->b).numberValue <= RK(ip->c).numberValue)) {
+            ip = chunk->code.data() + ip->a;
+            VM_DISPATCH();
+        }
+        VM_NEXT();
+
+    VM_CASE(PRINT)
+        std::cout << RK(ip->a) << '\n';
+        VM_NEXT();
+
+    VM_CASE(PRINT_ITEM)
+        std::cout << RK(ip->a) << " ";
+        VM_NEXT();
+
+    VM_CASE(PRINT_END)
+        std::cout << '\n';
+        VM_NEXT();
+
+    VM_CASE(GET_FUNCTION) {
+        const NameRef& ref = chunk->names[ip->b];
+        const Value* function = findName(ref);
+        if (!function) {
+            function = findBuiltin(ref.symbol);
+        }
+        if (!function) {
+            throw std::runtime_error("Undefined variable: " + ref.name);
+        }
+        if (!function->isCallable()) {
+            throw std::runtime_error("Not a function: " + ref.name);
+        }
+        if (static_cast<size_t>(ip->c) != function->arity()) {
+            throw std::runtime_error("Wrong number of arguments for function: " + ref.name);
+        }
+        if (function->type == Value::NATIVE) {
+            R[ip->a] = *function;
+            VM_NEXT();
+        }
+        // Для вызова нужно только тело-метка: без копии списка параметров.
+        // Регистр заменяется целиком, чтобы не держать массив или строку,
+        // лежавшие в нём раньше.
+        Value callee;
+        callee.type = Value::FUNCTION;
+        callee.body = function->body;
+        R[ip->a] = std::move(callee);
+        VM_NEXT();
+    }
+
+    VM_CASE(CALL) {
+        if (R[ip->a].type == Value::NATIVE) {
+            // Аргументы уже лежат в регистрах за функцией, результат — на её место.
+            // Родная функция может вызвать колбэк и перевыделить регистры.
+            Value result = callNative(R[ip->a], R + ip->a + 1, static_cast<size_t>(ip->b), *this);
+            R = registers.data() + frames.back().base;
+            R[ip->a] = std::move(result);
+            VM_NEXT();
+        }
+        auto found = functionsByMarker.find(R[ip->a].body.get());
+        if (found == functionsByMarker.end()) {
+            throw std::runtime_error("Function is not compiled");
+        }
+        // Первый кадр — сама программа, он не считается вызовом
+        if (frames.size() > maxCallDepth) {
+            throw std::runtime_error("Stack overflow");
+        }
+        FunctionProto* function = found->second;
+
+        // Окно вызываемой начинается с аргументов; результат вернётся на место функции
+        size_t base = frames.back().base + ip->a + 1;
+        reserve(base + function->chunk.registers);
+
+        // Параметры объявлены сразу, остальные локальные — когда выполнится их let
+        const std::vector<Symbol>& locals = function->localSymbols;
+        size_t parameterCount = function->parameters.size();
+        for (size_t slot = 0; slot < locals.size(); slot++) {
+            declared[base + slot] = slot < parameterCount;
+            if (slot < parameterCount) shadowCount[locals[slot]]++;
+        }
+
+        frames.back().returnAddress = ip + 1;
+        frames.push_back({function, nullptr, base, false});
+
+        prepare(function->chunk);
+        chunk = &function->chunk;
+        ip = chunk->code.data();
+        R = registers.data() + base;
+        K = chunk->constants.data();
+        VM_DISPATCH();
+    }
+
+    VM_CASE(RETURN) {
+        if (frames.size() == 1) {
+            // Как в интерпретаторе, return вне функции не перехватывается
+            throw ReturnOutsideFunction();
+        }
+        Value& result = R[-1];
+        if (ip->a >= 0) {
+            result = std::move(R[ip->a]);
+        } else {
+            result = K[-1 - ip->a];
+        }
+        bool entry = frames.back().entry;
+        releaseLocals(frames.back());
+        frames.pop_back();
+        if (entry) return;
+
+        const CallFrame& caller = frames.back();
+        chunk = &caller.function->chunk;
+        ip = caller.returnAddress;
+        R = registers.data() + caller.base;
+        K = chunk->constants.data();
+        VM_DISPATCH();
+    }
+
+    VM_CASE(HALT)
+        frames.pop_back();
+        return;
+
+    VM_CASE(FUNCTION) {
+        const FunctionProto& function = *functions[ip->b];
+        R[ip->a] = Value(function.parameters, function.marker);
+        VM_NEXT();
+    }
+
+    VM_CASE(ARRAY) {
+        std::vector<Value> elements(std::make_move_iterator(R + ip->b),
+                                    std::make_move_iterator(R + ip->b + ip->c));
+        R[ip->a] = Value(std::move(elements));
+        VM_NEXT();
+    }
+
+    VM_CASE(OBJECT) {
+        const auto& keys = chunk->keyLists[ip->c];
+        std::unordered_map<Symbol, Value> properties;
+        for (size_t i = 0; i < keys.size(); i++) {
+            properties[keys[i]] = std::move(R[ip->b + i]);
+        }
+        R[ip->a] = Value(properties);
+        VM_NEXT();
+    }
+
+    VM_CASE(INDEX)
+        R[ip->a] = indexValue(RK(ip->b), RK(ip->c));
+        VM_NEXT();
+
+    VM_CASE(PROPERTY)
+        R[ip->a] = propertyValue(RK(ip->b), chunk->names[ip->c].symbol);
+        VM_NEXT();
+
+    VM_CASE(METHOD) {
+        const MethodSite& site = chunk->methodSites[ip->c];
+        Value* receiver;
+        if (ip->b >= 0) {
+            receiver = &R[ip->b];
+        } else {
+            const NameRef& ref = chunk->names[-1 - ip->b];
+            receiver = findName(ref);
+            if (!receiver) {
+                throw std::runtime_error("Undefined variable: " + ref.name);
+            }
+        }
+        // Колбэки выполняются во вложенных окнах и могут перевыделить регистры
+        Value result = callArrayMethod(*receiver, site.method, R + ip->a + 1,
+                                       static_cast<size_t>(site.argumentCount), *this);
+        R = registers.data() + frames.back().base;
+        R[ip->a] = std::move(result);
+        VM_NEXT();
+    }
+
+#if !VM_THREADED
+        default:
+            throw std::runtime_error("Unknown opcode");
+    }
+#endif
+}
+
+#undef RK
+#undef VM_NEXT
+#undef VM_DISPATCH
+#undef VM_CASE
+#if VM_THREADED
+#pragma GCC diagnostic pop
+#endif
+
+void Vm::printStats(std::ostream& os) const {
+    if (!profiling) return;
+
+    size_t count = static_cast<size_t>(Op::COUNT);
+    std::vector<std::pair<size_t, size_t>> pairs; // (число, индекс пары)
+    for (size_t i = 0; i < pairCounts.size(); i++) {
+        if (pairCounts[i] > 0) pairs.push_back({pairCounts[i], i});
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    os << "VM: executed=" << executed << std::endl;
+    os << "VM op pairs:" << std::endl;
+    for (size_t i = 0; i < pairs.size() && i < 20; i++) {
+        Op first = static_cast<Op>(pairs[i].second / count);
+        Op second = static_cast<Op>(pairs[i].second % count);
+        os << "  " << opName(first) << " " << opName(second) << ": " << pairs[i].first << std::endl;
+    }
+}
\ No newline at end of file
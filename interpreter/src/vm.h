@@ -0,0 +1,77 @@
+#ifndef VM_H
+#define VM_H
+
+#include "ast.h"
+#include "bytecode.h"
+#include "environment.h"
+#include "runtime.h"
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Шитый код (computed goto) — расширение GCC/Clang; иначе диспетчеризация через switch
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_THREADED 1
+#else
+#define VM_THREADED 0
+#endif
+
+// Регистровая виртуальная машина: альтернатива обходу AST (--vm).
+// Окна вызовов — участки одного непрерывного массива регистров, поэтому
+// вызов не выделяет память: аргументы уже лежат в первых регистрах окна.
+// Значения и операции языка — общие с интерпретатором (runtime.h),
+// поэтому вывод и тексты ошибок совпадают.
+class Vm : public FunctionCaller {
+private:
+    struct CallFrame {
+        FunctionProto* function;
+        const Instruction* returnAddress; // Куда вернуться в этой функции после вложенного вызова
+        size_t base;                      // Первый регистр окна
+        bool entry;                       // Вызван из C++ (колбэк): его RETURN завершает execute
+    };
+
+    std::shared_ptr<Environment> globals;
+    std::vector<std::unique_ptr<FunctionProto>> functions;
+    std::unordered_map<const Block*, FunctionProto*> functionsByMarker;
+    std::vector<CallFrame> frames;
+    // Кадры живут в куче, родной стек не растёт; предел ловит бесконечную рекурсию
+    size_t maxCallDepth;
+
+    std::vector<Value> registers;
+    // Локальная объявлена (let уже выполнен) — только тогда она видна по имени
+    std::vector<unsigned char> declared;
+    // Символ -> число объявленных локальных с этим именем во всех окнах.
+    // Ноль — имя можно сразу искать в globals, не просматривая вызывающих.
+    std::vector<int> shadowCount;
+    // Символ -> переменная в globals (узлы unordered_map не перемещаются)
+    std::vector<Value*> globalSlots;
+
+    // Профиль пар команд (--vm-profile): counts[первая * COUNT + вторая]
+    bool profiling = false;
+    std::vector<size_t> pairCounts;
+    size_t executed = 0;
+
+    Value* findName(const NameRef& ref);
+    void releaseLocals(const CallFrame& frame);
+    void reset();
+    void reserve(size_t top);
+    void run(FunctionProto& script);
+    // Выполнять кадр frames.back() до его возврата
+    void execute();
+
+public:
+    Vm();
+    void setMaxCallDepth(size_t depth);
+    // Как Interpreter::registerNative
+    void registerNative(const std::string& name, size_t arity, NativeCallback function);
+    void enableProfiling();
+    void interpret(const Program& program);
+    void printStats(std::ostream& os) const;
+    // Колбэки методов массива: вложенный execute в окне над текущим кадром
+    Value call(const Value& function, const Value* args, size_t count) override;
+    bool isPure(const Value& function) const override;
+};
+
+#endif // VM_H
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "worker.h"
+#include "array.h"
+#include <stdexcept>
+
+bool isTransferable(const Value& value) {
+    switch (value.type) {
+        case Value::NUMBER:
+        case Value::STRING:
+        case Value::BOOLEAN:
+        case Value::NIL:
+            return true;
+        case Value::ARRAY: {
+            if (!value.arrayValue || value.arrayValue->kind() == ArrayStorage::PACKED_DOUBLE) {
+                return true;
+            }
+            for (const Value& element : value.arrayValue->elements()) {
+                if (!isTransferable(element)) return false;
+            }
+            return true;
+        }
+        case Value::OBJECT: {
+            if (!value.objectValue) return true;
+            for (const auto& entry : *value.objectValue) {
+                if (!isTransferable(entry.second)) return false;
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+WorkerHandle::WorkerHandle(std::shared_ptr<WorkerChannel> channel) : channel(std::move(channel)) {}
+
+WorkerHandle::~WorkerHandle() {
+    terminate();
+}
+
+void WorkerHandle::start(std::function<void()> body) {
+    thread = std::thread(std::move(body));
+}
+
+void WorkerHandle::post(const Value& message) {
+    if (terminated()) {
+        throw std::runtime_error("postMessage: the worker is terminated");
+    }
+    channel->busy.fetch_add(1, std::memory_order_relaxed);
+    channel->inbox.push(message);
+    channel->workerLoop->wake();
+}
+
+void WorkerHandle::terminate() {
+    if (!thread.joinable()) return;
+    channel->stopping.store(true);
+    channel->workerLoop->wake();
+    thread.join();
+    interpreter.reset();
+    channel->parentLoop->removeSource(sourceId);
+}
+
+ParentPort::ParentPort(std::shared_ptr<WorkerChannel> channel, std::function<void()> flushOutput)
+    : channel(std::move(channel)), flushOutput(std::move(flushOutput)) {}
+
+void ParentPort::post(const Value& message) {
+    flushOutput();
+    WorkerEvent event;
+    event.message = message;
+    channel->outbox.push(std::move(event));
+    channel->parentLoop->wake();
+}
\ No newline at end of file
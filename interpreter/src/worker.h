@@ -0,0 +1,85 @@
+#ifndef WORKER_H
+#define WORKER_H
+
+#include "channel.h"
+#include "environment.h"
+#include "eventloop.h"
+#include "runtime.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Событие от воркера для потока-родителя
+struct WorkerEvent {
+    enum Kind { MESSAGE, OUTPUT, ERROR_OUTPUT };
+    Kind kind = MESSAGE;
+    Value message;    // MESSAGE
+    std::string text; // OUTPUT и ERROR_OUTPUT: вывод print и ошибки воркера
+};
+
+// Общее для родителя и воркера: по очереди SPSC в каждую сторону.
+// Каждый цикл событий будит другая сторона, положив что-то в очередь.
+struct WorkerChannel {
+    SpscQueue<Value> inbox;        // Родитель → воркер
+    SpscQueue<WorkerEvent> outbox; // Воркер → родитель
+    // Сообщения, которые воркер ещё не обработал: пока их больше нуля,
+    // цикл родителя ждёт ответов
+    std::atomic<size_t> busy{0};
+    std::atomic<bool> stopping{false};
+    EventLoop* parentLoop = nullptr;
+    EventLoop* workerLoop = nullptr;
+};
+
+// Сообщением может быть только значение-данные: число, строка, логическое,
+// null и массивы и объекты из них. Массивы и строки не копируются: обе
+// стороны разделяют неизменяемое хранилище, а изменившая копирует его
+// (mutableArray). Функции, обещания, генераторы и воркеры привязаны к
+// своему интерпретатору и не передаются.
+bool isTransferable(const Value& value);
+
+// Значение, в которое можно отправить сообщение (postMessage)
+class MessagePort : public HostObject {
+public:
+    virtual void post(const Value& message) = 0;
+};
+
+// Сторона родителя: воркер со своим потоком и интерпретатором
+class WorkerHandle : public MessagePort {
+public:
+    explicit WorkerHandle(std::shared_ptr<WorkerChannel> channel);
+    ~WorkerHandle() override;
+
+    // body выполняет цикл событий воркера в новом потоке
+    void start(std::function<void()> body);
+    void post(const Value& message) override;
+    // Остановить поток после текущего сообщения; необработанные пропадают
+    void terminate();
+    bool terminated() const { return !thread.joinable(); }
+
+    std::shared_ptr<WorkerChannel> channel;
+    // Интерпретатор воркера. Разрушается после join: до этого родитель
+    // ещё может будить его цикл (wake в terminate).
+    std::shared_ptr<FunctionCaller> interpreter;
+    Value onMessage;   // Колбэк родителя для сообщений воркера
+    int sourceId = 0;  // Источник в цикле родителя
+
+private:
+    std::thread thread;
+};
+
+// Сторона воркера: значение parent, через которое он отвечает родителю
+class ParentPort : public MessagePort {
+public:
+    // flushOutput переносит накопленный вывод воркера в очередь до сообщения,
+    // чтобы родитель напечатал всё в том же порядке
+    ParentPort(std::shared_ptr<WorkerChannel> channel, std::function<void()> flushOutput);
+    void post(const Value& message) override;
+
+private:
+    std::shared_ptr<WorkerChannel> channel;
+    std::function<void()> flushOutput;
+};
+
+#endif // WORKER_H
\ No newline at end of file